@@ -17,9 +17,20 @@
 /** Image height in pixels */
 #define IMAGE_SIZE_Y        (64 * 2)
 
-/** Camera frequency in Hz */
+/** Camera frequency in Hz (starting point when CAMERA_RATE_ADAPT_ENABLE is set) */
 #define CAMERA_FREQ         (5 * 1000 * 1000)
 
+/** Adapt camera clock and sensor prescaler at runtime to the fastest rate
+ *  that does not overflow the stream buffers */
+#define CAMERA_RATE_ADAPT_ENABLE 1
+
+/** Clean frames before a faster capture rate is probed */
+#define CAMERA_RATE_PROBE_FRAMES 32
+
+/** Sensor sends RGB565 (2 bytes per pixel instead of 3 over the camera
+ *  interface), expanded to RGB888 on the MCU */
+#define CAMERA_SENSOR_RGB565 0
+
 /** RGB565 display buffer size: two bytes per pixel */
 #define DATA565_SIZE        (IMAGE_SIZE_X * IMAGE_SIZE_Y * 2)
 
@@ -30,12 +41,62 @@
  * Feature Toggles
  ******************************************************************************/
 
+/* Every toggle is defined to 0 or 1 and tested by value (#if), never with
+ * #ifdef: a toggle set to 0 is still defined */
+
 /** Enable TFT display for live video feed */
 #define TFT_ENABLE          0
 
 /** Enable serial image streaming to PC (for capture/viewing) */
 #define SERIAL_STREAM_ENABLE 1
 
+/** Stream captures as binary frames (1) instead of ASCII PPM (0) */
+#define SERIAL_STREAM_BINARY 1
+
+/** Pixel format of binary frames (STREAM_PIXFMT_RGB888 or STREAM_PIXFMT_RGB565) */
+#define SERIAL_STREAM_PIXFMT STREAM_PIXFMT_RGB888
+
+/** Compression of binary frames: IMAGE_CODEC_NONE, IMAGE_CODEC_DRLE (lossless
+ *  delta + RLE) or IMAGE_CODEC_JPEG (baseline, ~10-20x smaller) */
+#define SERIAL_STREAM_CODEC IMAGE_CODEC_NONE
+
+/** JPEG quality for IMAGE_CODEC_JPEG (1-100) */
+#define SERIAL_JPEG_QUALITY 75
+
+/** Upload live-feed frames with UART TX DMA while the next frame is captured.
+ *  Needs a slot of SERIAL_ASYNC_SLOT_SIZE bytes per queued frame; the RGB565
+ *  capture copy is dropped to make room. */
+#define SERIAL_STREAM_ASYNC_ENABLE 0
+
+/** Number of frames that can be queued for DMA upload */
+#define SERIAL_ASYNC_SLOTS  1
+
+/** Pixel format of DMA-uploaded frames */
+#define SERIAL_ASYNC_PIXFMT STREAM_PIXFMT_RGB565
+
+/** Bytes per upload slot: marker, header and an RGB565 payload */
+#define SERIAL_ASYNC_SLOT_SIZE (16 + 24 + IMAGE_SIZE_X * IMAGE_SIZE_Y * 2)
+
+/** Console baud rate while streaming (capture_images.py --baud must match) */
+#define SERIAL_STREAM_BAUD  115200
+
+/** Stream the live feed as a keyframe followed by changed-tile deltas
+ *  (capture_images.py rebuilds and previews the frames) */
+#define SERIAL_LIVE_DELTA_ENABLE 0
+
+/** Tile side of live deltas in pixels (even, at most 16) */
+#define SERIAL_LIVE_TILE_SIZE 8
+
+/** Change of a tile's quadrant mean luma or mean red/blue (0-255) that
+ *  resends the tile */
+#define SERIAL_LIVE_TILE_THRESHOLD 6
+
+/** Delta frames between live keyframes */
+#define SERIAL_LIVE_KEYFRAME_INTERVAL 100
+
+/** Pixel format of blocking live frames (DMA uploads use SERIAL_ASYNC_PIXFMT) */
+#define SERIAL_LIVE_PIXFMT  STREAM_PIXFMT_RGB565
+
 /** Enable ASCII art preview of captured images (serial console) */
 #define ASCII_ART_ENABLE    0
 
@@ -45,12 +106,182 @@
 /** Live feed mode: continuous capture without button press */
 #define LIVE_FEED_ENABLE    1
 
-/** Live feed frame delay in milliseconds (lower = faster, more CPU) */
-#define LIVE_FEED_DELAY_MS  50
+/** Live feed target frame period in milliseconds; the core sleeps until the
+ *  next period starts (0 = run frames back to back) */
+#define LIVE_FEED_FRAME_PERIOD_MS 66
+
+/** Skip live feed inference when the scene has not changed (block-luma
+ *  signature built during capture); the last result is shown instead */
+#define MOTION_GATE_ENABLE  1
+
+/** Block-mean luma change (0-255) for a signature block to count as moved */
+#define MOTION_BLOCK_THRESHOLD 6
+
+/** Moved blocks (of MOTION_GRID x MOTION_GRID) needed to run inference */
+#define MOTION_MIN_BLOCKS   4
+
+/** Run inference at least once every this many skipped frames */
+#define MOTION_MAX_SKIP     50
+
+/** Smooth results over frames and report a class only once it is stable */
+#define TRACKER_ENABLE      1
+
+/** Moving average weight of a new frame: 1 / 2^TRACKER_EMA_SHIFT */
+#define TRACKER_EMA_SHIFT   2
+
+/** Smoothed confidence (%) a class needs to become stable */
+#define TRACKER_ENTER_PERCENT 70
+
+/** Smoothed confidence (%) below which a stable class is dropped */
+#define TRACKER_EXIT_PERCENT 55
+
+/** Frames the leading class must stay above the enter level */
+#define TRACKER_CONFIRM_FRAMES 3
+
+/** Single capture: frames captured at most before reporting */
+#define TRACKER_SINGLE_MAX_FRAMES 8
+
+/** Timer that paces live feed frames (TMR0 is the CNN inference timer) */
+#define SCHED_TIMER         MXC_TMR1
+#define SCHED_TIMER_IDX     1
+
+/** Sleep in WFI between camera stream buffers instead of spinning (relies
+ *  on the camera driver's per-buffer DMA interrupt) */
+#define CAMERA_WAIT_WFI     1
+
+/** Frames staged for the CNN when CAPTURE_FIFO_STREAM_ENABLE is 0. With 2 or
+ *  more the live feed captures the next frame while the CNN runs on the
+ *  current one; each slot takes INPUT_WORDS * 4 bytes of SRAM, so 2 slots
+ *  only fit with smaller frames. */
+#define FRAME_POOL_SLOTS    1
+
+/** Stream camera rows into the CNN FIFO during capture (overlaps capture with
+ *  inference). With TFT, serial streaming and ASCII art all disabled the
+ *  64 KB CNN staging buffer is not allocated in this mode. */
+#define CAPTURE_FIFO_STREAM_ENABLE 1
+
+/** SRAM layout of the frame buffers:
+ *  MEMORY_LAYOUT_LEGACY - CNN frame plus an RGB565 copy (DATA565_SIZE) filled
+ *                         during capture
+ *  MEMORY_LAYOUT_SINGLE - CNN frame only, the TFT converts it line by line
+ *                         (saves DATA565_SIZE)
+ *  MEMORY_LAYOUT_STREAM - no frame kept (needs CAPTURE_FIFO_STREAM_ENABLE, no
+ *                         serial images or ASCII art); the TFT draws camera
+ *                         rows as they arrive (saves up to 96 KB) */
+#define MEMORY_LAYOUT_LEGACY 0
+#define MEMORY_LAYOUT_SINGLE 1
+#define MEMORY_LAYOUT_STREAM 2
+#define MEMORY_LAYOUT       MEMORY_LAYOUT_SINGLE
+
+/** Time pipeline stages with the DWT cycle counter and print a <<<PROFILE>>>
+ *  block (min/avg/max/p99 per stage) after each single capture and when the
+ *  live feed exits */
+#define PROFILE_ENABLE      1
+
+/** Load CNN weights with memory-to-memory DMA instead of the CPU copy loop
+ *  (falls back to cnn_load_weights() when no DMA channel is free) */
+#define INFERENCE_WEIGHT_DMA_ENABLE 1
+
+/** Program the CNN from the network.h register table (cnn_network.c) instead
+ *  of the unrolled cnn_configure() / cnn_unload() of the generated cnn.c */
+#define CNN_NETWORK_TABLE_ENABLE 1
+
+/** Networks that can be resident in CNN weight memory at once
+ *  (inference_add_model(), needs CNN_NETWORK_TABLE_ENABLE) */
+#define INFERENCE_MAX_MODELS 2
+
+/** Classify each frame with a half-resolution network first (2x2-binned
+ *  from the staged frame) and rerun it on the full network only below
+ *  FAST_PATH_ESCALATE_PERCENT confidence. Needs CAPTURE_FIFO_STREAM_ENABLE 0
+ *  and a 64x64 network generated with
+ *    gen_network.py --prefix FAST --embed-kernels --exclude-weights weights.h
+ *  into FAST_PATH_HEADER. */
+#define FAST_PATH_ENABLE    0
+#define FAST_PATH_HEADER    "network_fast.h"
+#define FAST_PATH_PREFIX    FAST
+#define FAST_PATH_ESCALATE_PERCENT 85
+
+/** Load frames into the CNN FIFO with DMA instead of the CPU write loop when
+ *  the whole frame is staged (CAPTURE_FIFO_STREAM_ENABLE 0). Opt-in: needs
+ *  INFERENCE_FIFO_DMA_REQSEL set to the DMA request line paced by the CNN
+ *  FIFO of the part (see the MSDK dma.h of your device). */
+#define INFERENCE_FIFO_DMA_ENABLE 0
+/* #define INFERENCE_FIFO_DMA_REQSEL MXC_DMA_REQUEST_... */
+
+/** Log compressed captures and their results to a ring of pages at the top
+ *  of internal flash (oldest overwritten first), for units that capture
+ *  offline. "capture_images.py --offload" downloads the log; keep the
+ *  linker script's flash region below CAPTURE_LOG_PAGES pages from the top.
+ *  Needs a kept frame (not MEMORY_LAYOUT_STREAM). */
+#define CAPTURE_LOG_ENABLE  0
+
+/** Flash pages (MXC_FLASH_PAGE_SIZE, 8 KB) in the ring */
+#define CAPTURE_LOG_PAGES   24
+
+/** SRAM page buffers: one receives records while the others wait for flash */
+#define CAPTURE_LOG_BUFFERS 2
+
+/** Compression of logged frames (IMAGE_CODEC_JPEG, IMAGE_CODEC_DRLE or
+ *  IMAGE_CODEC_NONE) and JPEG quality */
+#define CAPTURE_LOG_CODEC   IMAGE_CODEC_JPEG
+#define CAPTURE_LOG_QUALITY 60
+
+/** Console baud rate while the log is dumped */
+#define CAPTURE_LOG_OFFLOAD_BAUD 921600
+
+/** Run with power/performance profiles (system clock, CNN clock and CNN
+ *  supply boost set together) and print the measured inference time and
+ *  estimated energy per inference of each profile */
+#define POWER_PROFILE_ENABLE 0
+
+/** Profile applied at start-up (power_profile_t) */
+#define POWER_PROFILE_DEFAULT POWER_PROFILE_MAX_THROUGHPUT
+
+/** Let the live feed pick the slowest profile that still meets
+ *  LIVE_FEED_FRAME_PERIOD_MS (needs a period > 0) */
+#define POWER_GOVERNOR_ENABLE 1
+
+/** Step to a faster profile when a frame is busy above HIGH percent of the
+ *  period; step to a slower one after SETTLE frames predicted below LOW */
+#define POWER_GOVERNOR_HIGH_PERCENT 90
+#define POWER_GOVERNOR_LOW_PERCENT 60
+#define POWER_GOVERNOR_SETTLE_FRAMES 30
+
+/** The board has a CNN supply boost circuit on POWER_BOOST_PORT/PIN */
+#define POWER_BOOST_ENABLE  0
+#define POWER_BOOST_PORT    MXC_GPIO2
+#define POWER_BOOST_PIN     MXC_GPIO_PIN_5
+
+/** Power model of the energy estimate: static power in uW, plus uW per MHz
+ *  of system clock and of CNN clock; boost scales the CNN part by
+ *  POWER_BOOST_PERCENT. Rough figures - calibrate with a power monitor. */
+#define POWER_STATIC_UW     1500
+#define POWER_CORE_UW_PER_MHZ 40
+#define POWER_CNN_UW_PER_MHZ 250
+#define POWER_BOOST_PERCENT 120
 
 /** Use sample data instead of camera capture (for testing) */
 /* #define USE_SAMPLEDATA */
 
+/*******************************************************************************
+ * Benchmark Configuration (build with "make BENCHMARK=1")
+ ******************************************************************************/
+
+/** Run the camera-free benchmark on sampledata.h instead of the demo */
+#ifndef BENCHMARK_ENABLE
+#define BENCHMARK_ENABLE    0
+#endif
+
+/** Inferences per benchmark run */
+#define BENCHMARK_ITERATIONS 100
+
+/** Latency histogram bins */
+#define BENCHMARK_HIST_BINS 10
+
+/** Measured average board power during inference in mW (0 = not measured).
+ *  LED1 is on while the CNN runs, to trigger an external power monitor. */
+#define BENCHMARK_POWER_MW  0
+
 /*******************************************************************************
  * Hardware Configuration
  ******************************************************************************/
@@ -0,0 +1,51 @@
+/**
+ * @file    benchmark.h
+ * @brief   Camera-free inference benchmark for MAX78000 CNN projects.
+ *          Runs the CNN on sampledata.h and checks it against sampleoutput.h.
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Benchmark status codes */
+typedef enum {
+    BENCHMARK_OK = 0,
+    BENCHMARK_MISMATCH,     /**< CNN output differs from sampleoutput.h */
+    BENCHMARK_ERROR
+} benchmark_status_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Run back-to-back inferences on the sample input and report.
+ *
+ * Each iteration loads SAMPLE_INPUT_0 through the FIFO, waits for the
+ * result and compares the CNN output memory with SAMPLE_OUTPUT (outside the
+ * timed window). The bias memory is read back and the kernel table CRC is
+ * reported; the capture conversion (camera_utils_convert_row()) and
+ * inference_load_input() are timed on their own.
+ *
+ * Prints a <<<PROFILE>>> block of the single-frame stages, then a
+ * <<<BENCHMARK>>> block of "key: value" lines with throughput, latency
+ * min/avg/max, stage timings, a latency histogram and energy per inference
+ * when BENCHMARK_POWER_MW is set. tools/bench_compare.py checks both
+ * against a stored baseline.
+ *
+ * The CNN must already be initialized with inference_init() and the cycle
+ * counter enabled with profile_init().
+ *
+ * @param   iterations  Number of inferences (1 to BENCHMARK_ITERATIONS).
+ *
+ * @return  BENCHMARK_OK when every output matched.
+ */
+benchmark_status_t benchmark_run(int iterations);
+
+#endif /* BENCHMARK_H_ */
@@ -8,6 +8,7 @@
 #define CAMERA_UTILS_H_
 
 #include <stdint.h>
+#include "frame_pool.h"
 
 /*******************************************************************************
  * Definitions
@@ -21,6 +22,89 @@ typedef enum {
     CAM_STATUS_TIMEOUT
 } cam_status_t;
 
+/**
+ * Per-row callback, run on the raw camera words (0x00BBGGRR) of each row
+ * before the stream buffer is released. Keep it short: it runs between
+ * camera DMA buffers.
+ */
+typedef void (*camera_row_hook_t)(int row, const uint32_t *pixels, uint32_t width, void *ctx);
+
+/** Pixel layout of a frame view */
+typedef enum {
+    CAM_VIEW_RGB888 = 0,    /**< 32-bit words (B<<16)|(G<<8)|R, as the camera delivers */
+    CAM_VIEW_CNN,           /**< 32-bit words (B<<16)|(G<<8)|R XOR 0x00808080 */
+    CAM_VIEW_RGB565         /**< 16-bit big-endian RGB565 */
+} cam_view_format_t;
+
+/** Read-only view of a frame in any of the cam_view_format_t layouts */
+typedef struct {
+    const uint8_t     *data;    /**< First pixel */
+    uint32_t          width;    /**< Pixels per row */
+    uint32_t          height;   /**< Rows */
+    uint32_t          stride;   /**< Bytes from one row to the next */
+    cam_view_format_t format;   /**< Pixel layout */
+} cam_frame_view_t;
+
+/** Pixel format on the camera interface */
+typedef enum {
+    CAM_SENSOR_RGB888 = 0,  /**< 3 bytes per pixel */
+    CAM_SENSOR_RGB565       /**< 2 bytes per pixel, expanded to RGB888 on the MCU */
+} cam_sensor_format_t;
+
+/**
+ * Sensor-side capture configuration (see camera_utils_configure()).
+ *
+ * The crop window is in pixels of the sensor's 640x480 array and is scaled
+ * by the sensor to the output size, so a smaller window zooms in. Binning
+ * divides the output size, and with it the bytes per frame.
+ */
+typedef struct {
+    uint16_t            crop_x;     /**< Window left edge */
+    uint16_t            crop_y;     /**< Window top edge */
+    uint16_t            crop_w;     /**< Window width, 0 for the full array */
+    uint16_t            crop_h;     /**< Window height, 0 for the full array */
+    uint8_t             binning;    /**< Output size divider: 1, 2 or 4 */
+    cam_sensor_format_t format;     /**< Interface pixel format */
+} cam_capture_config_t;
+
+/** Capture rate controller state (see camera_utils_rate_update()) */
+typedef struct {
+    int      level;             /**< Index into the rate table, 0 = fastest */
+    uint32_t freq;              /**< Camera clock (XCLK) in Hz */
+    uint8_t  prescaler;         /**< Sensor clock prescaler (reg 0x11) */
+    uint32_t fps_x100;          /**< Achieved frames per second x 100 */
+    uint32_t overflow_frames;   /**< Frames lost to stream overflow */
+} cam_rate_status_t;
+
+/**
+ * Start of row y of a view.
+ */
+static inline const uint8_t *cam_view_row(const cam_frame_view_t *view, uint32_t y)
+{
+    return view->data + y * view->stride;
+}
+
+/**
+ * Pixel (x, y) of a view as (B<<16)|(G<<8)|R, whatever the view's layout.
+ */
+static inline uint32_t cam_view_rgb(const cam_frame_view_t *view, uint32_t x, uint32_t y)
+{
+    const uint8_t *row = cam_view_row(view, y);
+    uint32_t px;
+
+    switch (view->format) {
+    case CAM_VIEW_CNN:
+        return (((const uint32_t *)row)[x] ^ 0x00808080U) & 0x00FFFFFFU;
+    case CAM_VIEW_RGB565:
+        px = ((uint32_t)row[2 * x] << 8) | row[2 * x + 1];
+        return ((px >> 8) & 0xF8U) | ((px >> 13) & 0x07U) |             /* R */
+               (((px >> 3) & 0xFCU) | ((px >> 9) & 0x03U)) << 8 |       /* G */
+               (((px << 3) & 0xF8U) | ((px >> 2) & 0x07U)) << 16;       /* B */
+    default:
+        return ((const uint32_t *)row)[x] & 0x00FFFFFFU;
+    }
+}
+
 /*******************************************************************************
  * Function Prototypes
  ******************************************************************************/
@@ -56,6 +140,177 @@ cam_status_t camera_utils_init(uint32_t freq, uint32_t width, uint32_t height,
 cam_status_t camera_utils_capture(uint32_t *cnn_buffer, uint32_t cnn_buffer_size,
                                    uint8_t *rgb565_buffer, uint32_t rgb565_size);
 
+/**
+ * @brief   Convert one camera stream buffer row, as the capture functions do.
+ *
+ * Camera-free entry point to the capture conversion, e.g. for benchmarks.
+ * RGB565 sensor rows (CAM_SENSOR_RGB565) are expanded first.
+ *
+ * @param   data        Stream buffer row in the configured sensor format.
+ * @param   width       Pixels in the row (at most IMAGE_SIZE_X for RGB565).
+ * @param   cnn         n_cnn output words, CNN format.
+ * @param   n_cnn       Pixels to convert to CNN words.
+ * @param   rgb565      Optional 2 * n_rgb565 bytes of RGB565 (NULL if not needed).
+ * @param   n_rgb565    Pixels to convert to RGB565.
+ *
+ * @return  The row as 0x00BBGGRR camera words.
+ */
+const uint32_t *camera_utils_convert_row(const uint8_t *data, uint32_t width, uint32_t *cnn,
+                                         uint32_t n_cnn, uint8_t *rgb565, uint32_t n_rgb565);
+
+/**
+ * @brief   Capture an image and stream it straight into the CNN input FIFO.
+ *
+ * Each row is converted as soon as the camera driver hands over its stream
+ * buffer and is written to the CNN FIFO right away, so layer 0 runs while the
+ * rest of the frame is still arriving. inference_start() must be called
+ * before this function; on any error the caller must call inference_abort()
+ * because the accelerator has only received part of the frame.
+ *
+ * @param   cnn_buffer      Optional copy of the converted frame (same format as
+ *                          camera_utils_capture()). Pass NULL when nothing
+ *                          else needs the pixels after inference.
+ * @param   cnn_buffer_size Size of cnn_buffer in 32-bit words.
+ * @param   rgb565_buffer   Optional output buffer for RGB565 display data.
+ *                          Pass NULL if not needed.
+ * @param   rgb565_size     Size of rgb565_buffer in bytes.
+ *
+ * @return  CAM_STATUS_OK on success, error code otherwise.
+ */
+cam_status_t camera_utils_capture_stream(uint32_t *cnn_buffer, uint32_t cnn_buffer_size,
+                                          uint8_t *rgb565_buffer, uint32_t rgb565_size);
+
+/**
+ * @brief   Capture an image into a frame pool slot.
+ *
+ * Same as camera_utils_capture() into slot->data. On success the slot is
+ * handed from FRAME_OWNER_CAPTURE to next_owners; on failure the capture
+ * ownership is released.
+ *
+ * @param   slot            Slot owned by FRAME_OWNER_CAPTURE.
+ * @param   next_owners     Stages that take the frame (frame_owner_t flags).
+ * @param   rgb565_buffer   Optional output buffer for RGB565 display data.
+ * @param   rgb565_size     Size of rgb565_buffer in bytes.
+ *
+ * @return  CAM_STATUS_OK on success, error code otherwise.
+ */
+cam_status_t camera_utils_capture_slot(frame_slot_t *slot, uint32_t next_owners,
+                                       uint8_t *rgb565_buffer, uint32_t rgb565_size);
+
+/**
+ * @brief   Register a per-row callback for both capture functions.
+ *
+ * @param   hook    Callback, or NULL to remove it.
+ * @param   ctx     Passed to the callback.
+ */
+void camera_utils_set_row_hook(camera_row_hook_t hook, void *ctx);
+
+/**
+ * @brief   Feed one capture result to the capture rate controller.
+ *
+ * Call after every capture. An overflow steps to the next slower entry of
+ * the rate table (camera clock / sensor prescaler). After
+ * CAMERA_RATE_PROBE_FRAMES clean frames the next faster entry is tried; a
+ * level that overflowed before waits twice as long per failure before it is
+ * probed again, so the rate settles at the fastest overflow-free level.
+ * Changing the camera clock re-runs the camera setup, which is only done
+ * between frames.
+ *
+ * @param   capture_status  Result of the capture that just finished.
+ *
+ * @return  1 if the rate was changed, 0 otherwise, -1 if the sensor failed
+ *          to come back at the new camera clock (the old rate is kept).
+ */
+int camera_utils_rate_update(cam_status_t capture_status);
+
+/**
+ * @brief   Read the capture rate controller state.
+ *
+ * @param   status      Filled with the current level and achieved FPS.
+ */
+void camera_utils_rate_get(cam_rate_status_t *status);
+
+/**
+ * @brief   Redo the camera setup after the system clock changed.
+ *
+ * The camera clock, window and rate level are kept. Only call between
+ * frames; the sensor is reset.
+ *
+ * @return  CAM_STATUS_OK on success, CAM_STATUS_ERROR otherwise.
+ */
+cam_status_t camera_utils_reclock(void);
+
+/**
+ * @brief   Program the sensor's window, scaler and output format.
+ *
+ * The capture functions keep producing 0x00BBGGRR camera words and CNN
+ * words; RGB565 output is expanded row by row. The output size, width /
+ * binning x height / binning of camera_utils_init(), must be the network
+ * input IMAGE_SIZE_X x IMAGE_SIZE_Y, so binning above 1 needs
+ * camera_utils_init() at that multiple of it. A crop window must be at
+ * least the output size.
+ *
+ * @param   config      New configuration (NULL restores the defaults:
+ *                      full array, no binning, RGB888).
+ *
+ * @return  CAM_STATUS_OK on success, CAM_STATUS_ERROR for an invalid window
+ *          or binning, an output size other than the network input, or if
+ *          the sensor setup failed.
+ */
+cam_status_t camera_utils_configure(const cam_capture_config_t *config);
+
+/**
+ * @brief   Read the configuration in effect.
+ */
+void camera_utils_get_config(cam_capture_config_t *config);
+
+/**
+ * @brief   Describe a CNN buffer (packed pixels XOR 0x00808080) as a view.
+ */
+void camera_utils_view_cnn(cam_frame_view_t *view, const uint32_t *cnn_buffer,
+                           uint32_t width, uint32_t height);
+
+/**
+ * @brief   Describe a big-endian RGB565 buffer as a view.
+ */
+void camera_utils_view_rgb565(cam_frame_view_t *view, const uint8_t *rgb565_buffer,
+                              uint32_t width, uint32_t height);
+
+/**
+ * @brief   Get the camera driver's frame buffer as a view, without copying.
+ *
+ * Only valid while the driver's buffer holds a whole frame (not in the
+ * row-streaming capture mode).
+ *
+ * @param   view        Filled with a CAM_VIEW_RGB888 view (CAM_VIEW_RGB565 with
+ *                      RGB565 sensor output).
+ *
+ * @return  CAM_STATUS_OK on success, error code otherwise.
+ */
+cam_status_t camera_utils_get_view(cam_frame_view_t *view);
+
+/**
+ * @brief   Decode one row of a view into (B<<16)|(G<<8)|R words.
+ *
+ * @param   view        Frame view.
+ * @param   y           Row index.
+ * @param   dst         view->width words.
+ */
+void camera_utils_view_row_rgb(const cam_frame_view_t *view, uint32_t y, uint32_t *dst);
+
+/**
+ * @brief   Halve a CNN buffer in both directions (2x2 box filter).
+ *
+ * Feeds a half-resolution network from a full-resolution capture.
+ *
+ * @param   src         CNN buffer of width x height pixels (even sizes).
+ * @param   width       Source width.
+ * @param   height      Source height.
+ * @param   dst         (width / 2) x (height / 2) words, CNN format.
+ */
+void camera_utils_downscale_cnn(const uint32_t *src, uint32_t width, uint32_t height,
+                                uint32_t *dst);
+
 /**
  * @brief   Get the raw image buffer pointer.
  *
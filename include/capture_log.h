@@ -0,0 +1,155 @@
+/**
+ * @file    capture_log.h
+ * @brief   Persistent capture log in internal flash for MAX78000 CNN projects.
+ *          Compressed frames and their inference results are appended to a
+ *          ring of flash pages, batched one page at a time in SRAM, and are
+ *          dumped in bulk over the console UART later.
+ */
+
+#ifndef CAPTURE_LOG_H_
+#define CAPTURE_LOG_H_
+
+#include <stdint.h>
+#include "camera_utils.h"
+#include "inference_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Capture log status codes */
+typedef enum {
+    CAPTURE_LOG_OK = 0,         /**< Success */
+    CAPTURE_LOG_ERROR,          /**< Not initialized or invalid arguments */
+    CAPTURE_LOG_FLASH_ERROR     /**< Flash erase or program failed */
+} capture_log_status_t;
+
+/**
+ * Every page starts with a 16-byte header (all fields little-endian):
+ *
+ *   offset  size  field
+ *        0     4  magic "MXLP"
+ *        4     4  page sequence number (increments per written page)
+ *        8     4  erase count of the page
+ *       12     2  offset of the first record starting in the page
+ *                 (0xFFFF when a record covers the whole page)
+ *       14     2  boot number (increments on every capture_log_init())
+ *
+ * Records follow each other across page boundaries:
+ *
+ *   offset  size  field
+ *        0     4  magic "MXLG"
+ *        4     4  capture ID
+ *        8     1  codec (image_codec_t)
+ *        9     1  pixel format (stream_pixfmt_t, always RGB888)
+ *       10     2  width
+ *       12     2  height
+ *       14     1  predicted class
+ *       15     1  confidence percent
+ *       16     4  inference time in microseconds
+ *       20     1  number of classes n
+ *       21     3  reserved (0)
+ *       24    2n  softmax per class (Q15)
+ *
+ * followed by the payload in chunks of a 2-byte length and that many
+ * bytes, a zero length, and the CRC32 (as zlib.crc32) of the payload.
+ * The padding left by capture_log_flush() reads as 0xFF.
+ */
+#define CAPTURE_LOG_PAGE_MAGIC      "MXLP"
+#define CAPTURE_LOG_RECORD_MAGIC    "MXLG"
+#define CAPTURE_LOG_PAGE_HEADER     16
+
+/** Offload block header: magic "MXLD", version, 3 reserved bytes, page count
+ *  and page size (32-bit), followed by the pages oldest first and the CRC32
+ *  of all page bytes */
+#define CAPTURE_LOG_DUMP_MAGIC      "MXLD"
+#define CAPTURE_LOG_DUMP_VERSION    1
+
+/** Log state */
+typedef struct {
+    uint32_t pages;             /**< Pages in the ring */
+    uint32_t used_pages;        /**< Pages holding records */
+    uint32_t records;           /**< Records appended since init */
+    uint32_t lost_pages;        /**< Pages lost to flash errors */
+    uint32_t stalls;            /**< Appends that waited for a page write */
+    uint32_t max_erase;         /**< Highest page erase count */
+    uint16_t boot;              /**< Boot number of this session */
+} capture_log_stats_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Find the end of the log in flash and start a new boot session.
+ *
+ * Appends continue in the page after the newest one written, so records of
+ * earlier sessions are kept until the ring wraps over them.
+ *
+ * @return  CAPTURE_LOG_OK on success, CAPTURE_LOG_FLASH_ERROR otherwise.
+ */
+capture_log_status_t capture_log_init(void);
+
+/**
+ * @brief   Append a frame and its result to the log.
+ *
+ * The record is encoded into an SRAM page buffer; full pages are written by
+ * capture_log_service(). Only when every buffer is waiting for flash does
+ * this function write a page itself (counted in stats.stalls).
+ *
+ * @param   view        Frame to store. A packed CAM_VIEW_CNN view is
+ *                      compressed with CAPTURE_LOG_CODEC, other views are
+ *                      stored uncompressed.
+ * @param   capture_id  Capture number/ID stored in the record.
+ * @param   result      Inference result (softmax filled).
+ *
+ * @return  CAPTURE_LOG_OK on success, error code otherwise.
+ */
+capture_log_status_t capture_log_append(const cam_frame_view_t *view, int capture_id,
+                                        const inference_result_t *result);
+
+/**
+ * @brief   Do one step of pending flash work: erase a page, or program one
+ *          CAPTURE_LOG_PROGRAM_BYTES part of a full page buffer.
+ *
+ * Code runs from flash and stalls while it is erased or programmed, so call
+ * this while nothing time-critical is pending, e.g. between frames.
+ *
+ * @return  1 while more work is pending, 0 when idle.
+ */
+int capture_log_service(void);
+
+/**
+ * @brief   Write all buffered records to flash, including a partial page.
+ *
+ * The rest of a partial page stays erased; the next record starts a new page.
+ */
+capture_log_status_t capture_log_flush(void);
+
+/**
+ * @brief   Flush and send the whole log over the console UART.
+ *
+ * Prints a "<<<LOG>>>" marker line and the baud rate of the dump, switches
+ * the UART to that rate, sends the offload block and switches back to
+ * restore_baud.
+ *
+ * @param   baud            Baud rate of the dump.
+ * @param   restore_baud    Baud rate to return to.
+ *
+ * @return  CAPTURE_LOG_OK on success, error code otherwise.
+ */
+capture_log_status_t capture_log_offload(uint32_t baud, uint32_t restore_baud);
+
+/**
+ * @brief   Erase every page of the log.
+ */
+capture_log_status_t capture_log_erase(void);
+
+/**
+ * @brief   Get the log state.
+ *
+ * @param   stats   Filled with the current state.
+ */
+void capture_log_get_stats(capture_log_stats_t *stats);
+
+#endif /* CAPTURE_LOG_H_ */
@@ -0,0 +1,166 @@
+/**
+ * @file    cnn_network.h
+ * @brief   Table-driven CNN network descriptor for MAX78000 projects.
+ *          Layer shapes, the accelerator register program and the weight
+ *          records come from network.h (tools/gen_network.py), written out
+ *          by loops instead of the unrolled stores of cnn.c. Networks whose
+ *          kernel and bias memory do not overlap can be loaded side by side.
+ */
+
+#ifndef CNN_NETWORK_H_
+#define CNN_NETWORK_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Layer operation */
+typedef enum {
+    CNN_OP_PASSTHROUGH = 0,
+    CNN_OP_CONV1D,
+    CNN_OP_CONV2D,
+    CNN_OP_LINEAR
+} cnn_op_t;
+
+/** Pooling ahead of the operation */
+typedef enum {
+    CNN_POOL_NONE = 0,
+    CNN_POOL_MAX,
+    CNN_POOL_AVG
+} cnn_pool_t;
+
+/** One layer (field order matches network.h) */
+typedef struct {
+    uint16_t in_ch;         /**< Input channels */
+    uint16_t in_h;          /**< Input height */
+    uint16_t in_w;          /**< Input width */
+    uint16_t out_ch;        /**< Output channels */
+    uint16_t out_h;         /**< Output height */
+    uint16_t out_w;         /**< Output width */
+    uint8_t  op;            /**< cnn_op_t */
+    uint8_t  pool;          /**< cnn_pool_t */
+    uint8_t  pool_size;     /**< Pooling window side (1 without pooling) */
+    uint8_t  kernel;        /**< Kernel side */
+    uint8_t  relu;          /**< 1 with ReLU activation */
+    uint8_t  streaming;     /**< 1 when the layer runs in streaming mode */
+    uint16_t first_reg;     /**< Index of the layer's first register store */
+    uint16_t num_regs;      /**< Register stores of the layer */
+    uint32_t ops;           /**< Operations per inference */
+    uint32_t macs;          /**< Multiply-accumulates per inference */
+} cnn_layer_desc_t;
+
+/** A whole network: layers, register program, weights and output location */
+typedef struct {
+    const char             *name;
+    const cnn_layer_desc_t *layers;
+    uint16_t               num_layers;
+    uint16_t               num_regs;
+    const uint16_t         *reg_addr;      /**< (quadrant << 14) | (offset >> 2) */
+    const uint32_t         *reg_value;
+    uint32_t               fifo_ctrl;      /**< FIFO control, written last */
+    uint16_t               num_init;
+    const uint32_t         *init;          /**< cnn_init() as address, value pairs */
+    const uint32_t         *kernels;       /**< {address, count, words...}, 0 terminated */
+    const uint32_t         *bias;          /**< {address, count, bytes...}, 0 terminated */
+    uint32_t               output_addr;    /**< First output word in CNN memory */
+    uint16_t               output_words;   /**< Output words (one per class) */
+} cnn_network_t;
+
+/** The network generated into network.h */
+extern const cnn_network_t cnn_network_default;
+
+/**
+ * Define a descriptor named var from a header generated with
+ * "gen_network.py --prefix P --embed-kernels".
+ */
+#define CNN_NETWORK_DEFINE(var, P)      CNN_NETWORK_DEFINE_(var, P)
+#define CNN_NETWORK_DEFINE_(var, P)                                                 \
+    static const cnn_layer_desc_t var##_layers[P##_NUM_LAYERS] = P##_LAYERS;       \
+    static const uint16_t var##_reg_addr[P##_NUM_REGS] = P##_REG_ADDR;             \
+    static const uint32_t var##_reg_value[P##_NUM_REGS] = P##_REG_VALUE;           \
+    static const uint32_t var##_init[2 * P##_NUM_INIT] = P##_INIT;                 \
+    static const uint32_t var##_kernels[] = P##_KERNELS;                           \
+    static const uint32_t var##_bias[] = P##_BIAS;                                 \
+    const cnn_network_t var = {                                                     \
+        P##_NAME, var##_layers, P##_NUM_LAYERS, P##_NUM_REGS, var##_reg_addr,       \
+        var##_reg_value, P##_FIFO_CTRL, P##_NUM_INIT, var##_init, var##_kernels,    \
+        var##_bias, P##_OUTPUT_ADDR, P##_OUTPUT_WORDS                               \
+    }
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Stop the state machines and set the network's layer count
+ *          (replaces cnn_init()).
+ *
+ * @param   net     Network descriptor.
+ */
+void cnn_network_init(const cnn_network_t *net);
+
+/**
+ * @brief   Program the accelerator for a network (replaces cnn_configure()).
+ *
+ * Expects cnn_network_init() first, as cnn_configure() expects cnn_init().
+ *
+ * @param   net     Network descriptor.
+ */
+void cnn_network_configure(const cnn_network_t *net);
+
+/**
+ * @brief   Copy the network's kernels into CNN weight memory
+ *          (replaces cnn_load_weights()).
+ *
+ * Only the network's own records are written, so kernels of other
+ * networks at other offsets stay intact.
+ *
+ * @param   net     Network descriptor.
+ */
+void cnn_network_load_weights(const cnn_network_t *net);
+
+/**
+ * @brief   Copy the network's biases into CNN bias memory
+ *          (replaces cnn_load_bias()).
+ *
+ * @param   net     Network descriptor.
+ */
+void cnn_network_load_bias(const cnn_network_t *net);
+
+/**
+ * @brief   Copy the network output out of CNN memory (replaces cnn_unload()).
+ *
+ * @param   net     Network descriptor.
+ * @param   out     net->output_words words.
+ */
+void cnn_network_unload(const cnn_network_t *net, uint32_t *out);
+
+/**
+ * @brief   Total operations of one inference.
+ */
+uint32_t cnn_network_ops(const cnn_network_t *net);
+
+/**
+ * @brief   Total multiply-accumulates of one inference.
+ */
+uint32_t cnn_network_macs(const cnn_network_t *net);
+
+/**
+ * @brief   Output shape of the last layer.
+ *
+ * @param   net     Network descriptor.
+ * @param   ch      Channels (may be NULL).
+ * @param   h       Height (may be NULL).
+ * @param   w       Width (may be NULL).
+ */
+void cnn_network_output_shape(const cnn_network_t *net, uint32_t *ch, uint32_t *h,
+                              uint32_t *w);
+
+/**
+ * @brief   Print the layer table to the console.
+ */
+void cnn_network_print(const cnn_network_t *net);
+
+#endif /* CNN_NETWORK_H_ */
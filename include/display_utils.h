@@ -8,6 +8,17 @@
 #define DISPLAY_UTILS_H_
 
 #include <stdint.h>
+#include "camera_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** ASCII art output modes */
+typedef enum {
+    DISPLAY_ART_FULL = 0,   /**< Whole frame, one line per row */
+    DISPLAY_ART_DIFF        /**< Only the characters changed since the last frame */
+} display_art_mode_t;
 
 /*******************************************************************************
  * Function Prototypes
@@ -40,6 +51,40 @@ void display_ascii_art(const uint8_t *img, int width, int height,
 void display_ascii_art_from_cnn(const uint32_t *cnn_buffer, int width, int height,
                                  int ratio);
 
+/**
+ * @brief   Render a frame view as ASCII art (standard detail).
+ *
+ * Reads the pixels in place, whatever the view's format.
+ *
+ * @param   view        Frame view.
+ * @param   ratio       Downscale ratio.
+ */
+void display_ascii_art_view(const cam_frame_view_t *view, int ratio);
+
+/**
+ * @brief   Render a frame view as ASCII art, optionally as a diff update.
+ *
+ * The frame is built in a buffer (one luma LUT lookup per character) and
+ * written with one fwrite(). With DISPLAY_ART_DIFF and a previous frame of
+ * the same size, only changed characters are sent, placed with ANSI cursor
+ * moves relative to the cursor position; the caller must start each frame
+ * where the previous one started (e.g. after a fixed header below "ESC [H").
+ * A diff larger than the full frame is sent as the full frame. The cursor
+ * ends on the line below the frame in both modes.
+ *
+ * @param   view        Frame view.
+ * @param   ratio       Downscale ratio.
+ * @param   mode        DISPLAY_ART_FULL or DISPLAY_ART_DIFF.
+ */
+void display_ascii_art_frame(const cam_frame_view_t *view, int ratio,
+                             display_art_mode_t mode);
+
+/**
+ * @brief   Forget the previous frame, so the next diff update draws in full
+ *          (call after clearing the screen).
+ */
+void display_ascii_art_reset(void);
+
 /**
  * @brief   Render a packed CNN buffer as ASCII art (high detail).
  *
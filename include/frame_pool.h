@@ -0,0 +1,98 @@
+/**
+ * @file    frame_pool.h
+ * @brief   Frame buffer pool for MAX78000 CNN pipelines.
+ *          Each slot holds one frame and a set of owning stages; a slot is
+ *          reused only once every stage has released it, so capture of the
+ *          next frame can run while earlier stages still hold theirs.
+ */
+
+#ifndef FRAME_POOL_H_
+#define FRAME_POOL_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Largest number of slots a pool can have */
+#ifndef FRAME_POOL_MAX_SLOTS
+#define FRAME_POOL_MAX_SLOTS 4
+#endif
+
+/** Pipeline stages that can own a slot (bit flags) */
+typedef enum {
+    FRAME_OWNER_CAPTURE = (1u << 0),    /**< Camera is writing the frame */
+    FRAME_OWNER_INFER   = (1u << 1),    /**< Frame is being loaded into the CNN */
+    FRAME_OWNER_DISPLAY = (1u << 2),    /**< TFT / console is reading the frame */
+    FRAME_OWNER_STREAM  = (1u << 3)     /**< Serial upload is reading the frame */
+} frame_owner_t;
+
+/** One frame buffer */
+typedef struct {
+    uint32_t          *data;        /**< Frame in CNN format (packed pixels) */
+    uint32_t          words;        /**< Capacity of data in 32-bit words */
+    volatile uint32_t owners;       /**< OR of frame_owner_t, 0 when free */
+    uint32_t          frame_id;     /**< Sequence number set on acquire */
+} frame_slot_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Split storage into slots and mark them all free.
+ *
+ * @param   storage     slots * slot_words words of frame memory.
+ * @param   slots       Number of slots (1 to FRAME_POOL_MAX_SLOTS).
+ * @param   slot_words  Words per slot.
+ *
+ * @return  0 on success, -1 on invalid arguments.
+ */
+int frame_pool_init(uint32_t *storage, int slots, uint32_t slot_words);
+
+/**
+ * @brief   Take the oldest free slot.
+ *
+ * @param   owners      Stages that own the slot from now on.
+ *
+ * @return  The slot, or NULL if every slot is in use.
+ */
+frame_slot_t *frame_pool_acquire(uint32_t owners);
+
+/**
+ * @brief   Take a free slot, sleeping until one is released.
+ *
+ * @param   owners      Stages that own the slot from now on.
+ *
+ * @return  The slot.
+ */
+frame_slot_t *frame_pool_acquire_wait(uint32_t owners);
+
+/**
+ * @brief   Pass a slot from one stage to others.
+ *
+ * @param   slot        Slot to hand over.
+ * @param   from        Stage that is done with it.
+ * @param   to          Stages that take it (0 releases it).
+ */
+void frame_pool_hand_off(frame_slot_t *slot, uint32_t from, uint32_t to);
+
+/**
+ * @brief   Drop a stage's ownership (callable from interrupt handlers).
+ *
+ * The slot becomes free once no stage owns it.
+ *
+ * @param   slot        Slot to release.
+ * @param   owner       Stage that is done with it.
+ */
+void frame_pool_release(frame_slot_t *slot, uint32_t owner);
+
+/**
+ * @brief   Count free slots.
+ *
+ * @return  Number of slots no stage owns.
+ */
+int frame_pool_free_count(void);
+
+#endif /* FRAME_POOL_H_ */
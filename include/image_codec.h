@@ -0,0 +1,65 @@
+/**
+ * @file    image_codec.h
+ * @brief   Image compression for streamed captures on MAX78000 CNN projects.
+ *          Encodes a packed CNN buffer into a byte stream through a sink.
+ */
+
+#ifndef IMAGE_CODEC_H_
+#define IMAGE_CODEC_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Codec IDs (values are sent in the binary frame header) */
+typedef enum {
+    IMAGE_CODEC_NONE = 0,   /**< Uncompressed pixels */
+    IMAGE_CODEC_DRLE = 1,   /**< Lossless: per-channel delta + PackBits RLE */
+    IMAGE_CODEC_JPEG = 2    /**< Baseline JPEG (JFIF, YCbCr 4:2:0) */
+} image_codec_t;
+
+/** Default JPEG quality (1-100, IJG scaling) */
+#define IMAGE_CODEC_JPEG_QUALITY    75
+
+/**
+ * @brief   Output callback for encoded bytes.
+ *
+ * @param   ctx     Caller context passed to image_codec_encode().
+ * @param   data    Encoded bytes.
+ * @param   len     Number of bytes.
+ */
+typedef void (*image_codec_sink_t)(void *ctx, const uint8_t *data, uint32_t len);
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Encode a packed CNN buffer.
+ *
+ * The encoders are deterministic, so running the same frame twice produces the
+ * same bytes. Callers use this to size and checksum a payload without a
+ * compression buffer, then encode again to send it.
+ *
+ * DRLE stream: control byte c < 0x80 is followed by c + 1 literal bytes,
+ * c >= 0x80 repeats the next byte (c - 0x80) + 3 times. Decoded bytes are
+ * three planes (R, G, B) of width * height deltas, each against the previous
+ * pixel of the same plane (0 before the first), modulo 256.
+ *
+ * @param   codec       Codec to use (not IMAGE_CODEC_NONE).
+ * @param   cnn_buffer  CNN input buffer (packed pixels XOR 0x00808080).
+ * @param   width       Image width.
+ * @param   height      Image height.
+ * @param   quality     JPEG quality 1-100 (ignored by DRLE).
+ * @param   sink        Output callback.
+ * @param   ctx         Context for the callback.
+ *
+ * @return  0 on success, -1 on invalid arguments.
+ */
+int image_codec_encode(image_codec_t codec, const uint32_t *cnn_buffer,
+                       int width, int height, int quality,
+                       image_codec_sink_t sink, void *ctx);
+
+#endif /* IMAGE_CODEC_H_ */
@@ -10,6 +10,8 @@
 #include <stdint.h>
 #include "mxc.h"
 #include "cnn.h"
+#include "frame_pool.h"
+#include "cnn_network.h"
 
 /*******************************************************************************
  * Definitions
@@ -22,6 +24,18 @@ typedef enum {
     INFERENCE_TIMEOUT
 } inference_status_t;
 
+/** What inference_sleep() keeps powered */
+typedef enum {
+    INFERENCE_SLEEP_RETAIN = 0,     /**< Gate the CNN clock, keep weight SRAM powered */
+    INFERENCE_SLEEP_POWER_OFF       /**< Remove CNN power, weights must be reloaded */
+} inference_sleep_t;
+
+/** What inference_wait_mode() computes after unloading the CNN */
+typedef enum {
+    INFERENCE_RESULT_FULL = 0,      /**< Softmax, class and confidence */
+    INFERENCE_RESULT_LOGITS         /**< Class and margin from raw_output only */
+} inference_result_mode_t;
+
 /** Inference result structure */
 typedef struct {
     int32_t  raw_output[CNN_NUM_OUTPUTS];   /**< Raw CNN output values */
@@ -29,6 +43,8 @@ typedef struct {
     int      predicted_class;                /**< Index of highest probability class */
     int      confidence_percent;             /**< Confidence as percentage (0-100) */
     uint32_t inference_time_us;              /**< Inference time in microseconds */
+    int32_t  margin;                         /**< Top minus runner-up raw output (Q17.14) */
+    int      softmax_valid;                  /**< softmax/confidence_percent are filled */
 } inference_result_t;
 
 /*******************************************************************************
@@ -53,6 +69,58 @@ inference_status_t inference_init(void);
  */
 void inference_load_input(const uint32_t *input_data, uint32_t num_words);
 
+/**
+ * @brief   Set up DMA loading of the CNN FIFO (INFERENCE_FIFO_DMA_ENABLE).
+ *
+ * @param   dma_channel     DMA channel to use (from MXC_DMA_AcquireChannel()).
+ *
+ * @return  0 on success, -1 if the channel is invalid or DMA loading is not
+ *          built in (inference_load_input_dma() then uses the CPU).
+ */
+int inference_fifo_dma_init(int dma_channel);
+
+/**
+ * @brief   Start loading input data into the CNN FIFO by DMA (non-blocking).
+ *
+ * The transfer is paced by the FIFO; the CPU is free until it completes.
+ * input_data must stay valid until then. Without DMA this is
+ * inference_load_input() followed by the callback.
+ *
+ * @param   input_data      Pointer to input data buffer (packed pixels).
+ * @param   num_words       Number of 32-bit words to load.
+ * @param   callback        Called from the DMA interrupt when done, or NULL.
+ *
+ * @return  INFERENCE_OK once started, INFERENCE_ERROR if a load is running.
+ */
+inference_status_t inference_load_input_dma(const uint32_t *input_data, uint32_t num_words,
+                                            void (*callback)(void));
+
+/**
+ * @brief   Start inference on a frame pool slot.
+ *
+ * Starts the CNN and loads slot->data (by DMA when available). The slot's
+ * FRAME_OWNER_INFER ownership is released as soon as the whole frame is in
+ * the FIFO, so the slot can be refilled while the CNN is still running.
+ *
+ * @param   slot            Slot owned by FRAME_OWNER_INFER.
+ * @param   num_words       Number of 32-bit words to load.
+ *
+ * @return  INFERENCE_OK once started, error code otherwise.
+ */
+inference_status_t inference_start_slot(frame_slot_t *slot, uint32_t num_words);
+
+/**
+ * @brief   Check whether a DMA FIFO load is still running.
+ *
+ * @return  1 while the DMA transfer runs, 0 otherwise.
+ */
+int inference_load_input_busy(void);
+
+/**
+ * @brief   Sleep until a running DMA FIFO load has finished.
+ */
+void inference_load_input_wait(void);
+
 /**
  * @brief   Run CNN inference and wait for completion.
  *
@@ -81,22 +149,173 @@ void inference_start(void);
  */
 inference_status_t inference_wait(inference_result_t *result);
 
+/**
+ * @brief   Wait for CNN inference to complete, choosing the post-processing.
+ *
+ * INFERENCE_RESULT_LOGITS only fills raw_output, predicted_class (argmax of
+ * raw_output) and margin; softmax_valid is 0 and softmax/confidence_percent
+ * are left untouched. Call inference_compute_confidence() when they are
+ * needed later.
+ *
+ * @param   result          Pointer to result structure to fill.
+ * @param   mode            Post-processing to run.
+ *
+ * @return  INFERENCE_OK on success, error code otherwise.
+ */
+inference_status_t inference_wait_mode(inference_result_t *result, inference_result_mode_t mode);
+
+/**
+ * @brief   Fill softmax, predicted_class and confidence_percent from raw_output.
+ *
+ * Does nothing if softmax_valid is already set. Binary classifiers use a
+ * lookup that gives the same values as softmax_q17p14_q15() without its
+ * 64-bit division.
+ *
+ * @param   result          Result holding raw_output.
+ */
+void inference_compute_confidence(inference_result_t *result);
+
+/**
+ * @brief   Run inference on a batch of input frames back to back.
+ *
+ * The CNN interrupt unloads each frame's output and restarts the CNN at
+ * once; the caller's thread only streams the next frame into the FIFO and
+ * sleeps otherwise. Softmax (per mode) is computed after the last frame.
+ * Blocks until the whole batch is done.
+ *
+ * @param   inputs          Array of count input buffers (packed pixels).
+ * @param   count           Number of frames.
+ * @param   num_words       32-bit words per frame.
+ * @param   results         Array of count results to fill.
+ * @param   mode            Post-processing to run on each result.
+ *
+ * @return  INFERENCE_OK on success, error code otherwise.
+ */
+inference_status_t inference_run_batch(const uint32_t *const *inputs, int count,
+                                       uint32_t num_words, inference_result_t *results,
+                                       inference_result_mode_t mode);
+
+/**
+ * @brief   Check whether the running inference has finished.
+ *
+ * @return  1 once the CNN interrupt has fired, 0 while it is still running.
+ */
+int inference_is_done(void);
+
+/**
+ * @brief   Register a function called from the CNN interrupt on completion.
+ *
+ * Runs in interrupt context, keep it short (e.g. post a scheduler event).
+ *
+ * @param   callback    Function to call, or NULL to remove it.
+ */
+void inference_set_done_callback(void (*callback)(void));
+
+/**
+ * @brief   Abandon an inference whose input was not fully loaded.
+ *
+ * Stops the accelerator and reconfigures it so the next inference_start()
+ * begins from a clean FIFO. Weights and biases are kept.
+ */
+void inference_abort(void);
+
+/**
+ * @brief   Put the CNN to sleep between inferences.
+ *
+ * INFERENCE_SLEEP_RETAIN only gates the CNN clock, so weights and biases
+ * survive and inference_resume() skips reloading them. The CNN power domain
+ * must stay on while the MCU sleeps (SLEEP/LPM, not BACKUP or power down).
+ * INFERENCE_SLEEP_POWER_OFF removes CNN power for the lowest leakage.
+ *
+ * @param   mode    What to keep powered.
+ */
+void inference_sleep(inference_sleep_t mode);
+
+/**
+ * @brief   Wake the CNN after inference_sleep() or inference_disable().
+ *
+ * With retained weights only the state machine and layer registers are
+ * reprogrammed (cnn_init() + cnn_configure()). Otherwise the CNN is powered
+ * up and weights are reloaded, by DMA when INFERENCE_WEIGHT_DMA_ENABLE is set.
+ *
+ * @return  INFERENCE_OK on success, error code otherwise.
+ */
+inference_status_t inference_resume(void);
+
+/**
+ * @brief   Check whether weights are still loaded in CNN SRAM.
+ *
+ * @return  1 if the next inference_resume() is a warm restart, 0 otherwise.
+ */
+int inference_weights_retained(void);
+
+/**
+ * @brief   Select the CNN clock (replaces the fixed APB div 1 of cnn_enable()).
+ *
+ * Applied at once when the CNN is powered, otherwise at the next cold start.
+ * Only call while no inference is running.
+ *
+ * @param   clock_source    MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK or _ISO.
+ * @param   clock_divider   MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV1 to _DIV16.
+ */
+void inference_set_clock(uint32_t clock_source, uint32_t clock_divider);
+
 /**
  * @brief   Disable the CNN peripheral.
  *
- * Call this when inference is no longer needed to save power.
+ * Call this when inference is no longer needed to save power. Same as
+ * inference_sleep(INFERENCE_SLEEP_POWER_OFF).
  */
 void inference_disable(void);
 
 /**
  * @brief   Re-enable the CNN peripheral after disable.
  *
- * This re-initializes the CNN for another inference session.
+ * This re-initializes the CNN for another inference session. Same as
+ * inference_resume().
  *
  * @return  INFERENCE_OK on success, error code otherwise.
  */
 inference_status_t inference_enable(void);
 
+/**
+ * @brief   Descriptor of the loaded network.
+ *
+ * Layer shapes, output shape and ops count, see cnn_network.h.
+ */
+const cnn_network_t *inference_get_network(void);
+
+/**
+ * @brief   Keep another network resident in CNN SRAM (CNN_NETWORK_TABLE_ENABLE).
+ *
+ * Its kernel and bias memory must not overlap the other networks' (see
+ * tools/gen_network.py --exclude-weights) and it must have CNN_NUM_OUTPUTS
+ * outputs. Loaded now if the CNN is running, else at the next cold start.
+ * Call between inferences; the current network is reprogrammed.
+ *
+ * @param   net     Network descriptor.
+ *
+ * @return  Model index for inference_select_model(), -1 on error.
+ */
+int inference_add_model(const cnn_network_t *net);
+
+/**
+ * @brief   Switch to a resident network without reloading weights.
+ *
+ * Only the layer program (cnn_init() and cnn_configure() equivalents) is
+ * rewritten. Call between inferences with the CNN awake.
+ *
+ * @param   model   0 for the network of cnn.c, else from inference_add_model().
+ *
+ * @return  INFERENCE_OK on success, INFERENCE_ERROR for an unknown model.
+ */
+inference_status_t inference_select_model(int model);
+
+/**
+ * @brief   Index of the selected network.
+ */
+int inference_get_model(void);
+
 /**
  * @brief   Print classification results to console.
  *
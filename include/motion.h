@@ -0,0 +1,87 @@
+/**
+ * @file    motion.h
+ * @brief   Motion gating for MAX78000 CNN live feeds.
+ *          Builds a block-luma signature of each frame during capture and
+ *          decides whether the frame differs enough to be inferred.
+ */
+
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Signature grid (blocks per side) */
+#ifndef MOTION_GRID
+#define MOTION_GRID         16
+#endif
+
+/** Motion gating statistics */
+typedef struct {
+    uint32_t frames;        /**< Frames evaluated */
+    uint32_t skipped;       /**< Frames whose inference was skipped */
+    uint32_t last_blocks;   /**< Changed blocks in the last frame */
+    uint32_t last_sad;      /**< Mean block-luma difference of the last frame */
+} motion_stats_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Set the frame size and clear the reference signature.
+ *
+ * The region of interest starts as the whole frame.
+ *
+ * @param   width       Frame width in pixels (multiple of MOTION_GRID).
+ * @param   height      Frame height in pixels (multiple of MOTION_GRID).
+ */
+void motion_init(int width, int height);
+
+/**
+ * @brief   Restrict change detection to a rectangle (in pixels).
+ *
+ * Blocks overlapping the rectangle are compared, the rest are ignored.
+ */
+void motion_set_roi(int x, int y, int width, int height);
+
+/**
+ * @brief   Accumulate one camera row into the current signature.
+ *
+ * Matches camera_row_hook_t, register it with camera_utils_set_row_hook().
+ *
+ * @param   row     Row index (0 starts a new frame).
+ * @param   pixels  Camera words, 0x00BBGGRR per pixel.
+ * @param   width   Number of pixels.
+ * @param   ctx     Unused.
+ */
+void motion_row_hook(int row, const uint32_t *pixels, uint32_t width, void *ctx);
+
+/**
+ * @brief   Decide whether the frame just captured needs inference.
+ *
+ * A frame is "changed" when at least MOTION_MIN_BLOCKS blocks of the region
+ * of interest moved by more than MOTION_BLOCK_THRESHOLD luma levels against
+ * the reference, or when MOTION_MAX_SKIP frames in a row were skipped. A
+ * changed frame becomes the new reference, so slow drift still triggers.
+ *
+ * @return  1 if the frame should be inferred, 0 to reuse the last result.
+ */
+int motion_frame_changed(void);
+
+/**
+ * @brief   Force the next frame to count as changed.
+ */
+void motion_invalidate(void);
+
+/**
+ * @brief   Read the gating statistics.
+ *
+ * @param   stats   Filled with counters since motion_init().
+ */
+void motion_get_stats(motion_stats_t *stats);
+
+#endif /* MOTION_H_ */
@@ -0,0 +1,130 @@
+/**
+ * @file    power_profile.h
+ * @brief   Power/performance profiles for MAX78000 CNN projects.
+ *          A profile sets the system clock, the CNN clock and the CNN supply
+ *          boost together, keeps the measured inference time per profile and
+ *          estimates the energy per inference from a simple power model.
+ */
+
+#ifndef POWER_PROFILE_H_
+#define POWER_PROFILE_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Profiles, fastest first */
+typedef enum {
+    POWER_PROFILE_MAX_THROUGHPUT = 0,   /**< 100 MHz core, 50 MHz CNN, boost */
+    POWER_PROFILE_BALANCED,             /**< 100 MHz core, 25 MHz CNN */
+    POWER_PROFILE_LOW_ENERGY,           /**< 60 MHz core, 15 MHz CNN */
+    POWER_PROFILE_COUNT
+} power_profile_t;
+
+/** Power profile status codes */
+typedef enum {
+    POWER_PROFILE_OK = 0,
+    POWER_PROFILE_ERROR         /**< Unknown profile or peripheral re-setup failed */
+} power_profile_status_t;
+
+/** What a profile programs */
+typedef struct {
+    const char *name;
+    uint8_t    sys_clock;       /**< mxc_sys_system_clock_t (IPO or ISO) */
+    uint8_t    sys_div;         /**< System clock divider: 1, 2, 4, ... 128 */
+    uint32_t   cnn_clksel;      /**< MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK or _ISO */
+    uint8_t    cnn_div;         /**< CNN clock divider: 1, 2, 4, 8 or 16 */
+    uint8_t    boost;           /**< Raise the CNN supply (POWER_BOOST_ENABLE boards) */
+} power_profile_desc_t;
+
+/** Measurements of one profile */
+typedef struct {
+    uint32_t samples;           /**< Inferences recorded */
+    uint32_t last_us;           /**< Last inference time */
+    uint32_t avg_us;            /**< Mean inference time (0 without samples) */
+    uint32_t sys_hz;            /**< System clock */
+    uint32_t cnn_hz;            /**< CNN clock */
+    uint32_t power_uw;          /**< Estimated active power */
+    uint32_t energy_nj;         /**< avg_us x power_uw, nJ per inference */
+} power_profile_stats_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Switch to a profile.
+ *
+ * The CNN clock is set through inference_set_clock(). When the system clock
+ * changes, the console UART keeps its baud rate and the callback from
+ * power_profile_set_reclock_callback() re-times the other peripherals.
+ * Call between frames, with no inference, DMA upload or capture running.
+ *
+ * @param   profile     Profile to apply.
+ *
+ * @return  POWER_PROFILE_OK on success, error code otherwise.
+ */
+power_profile_status_t power_profile_select(power_profile_t profile);
+
+/**
+ * @brief   Current profile.
+ */
+power_profile_t power_profile_get(void);
+
+/**
+ * @brief   Settings of a profile.
+ *
+ * @return  The descriptor, or NULL for an unknown profile.
+ */
+const power_profile_desc_t *power_profile_desc(power_profile_t profile);
+
+/**
+ * @brief   Register a function called after every system clock change.
+ *
+ * Use it to re-time peripherals whose rate is divided from the peripheral
+ * clock at setup (camera clock, frame timer).
+ *
+ * @param   callback    Function to call, or NULL to remove it.
+ */
+void power_profile_set_reclock_callback(void (*callback)(void));
+
+/**
+ * @brief   Record a measured inference time for the current profile.
+ *
+ * @param   inference_us    inference_result_t.inference_time_us.
+ */
+void power_profile_record(uint32_t inference_us);
+
+/**
+ * @brief   Get the measurements and estimates of a profile.
+ *
+ * @param   profile     Profile to read.
+ * @param   stats       Filled with the profile's state.
+ */
+void power_profile_get_stats(power_profile_t profile, power_profile_stats_t *stats);
+
+/**
+ * @brief   Pick the profile for the next frames from the frame busy time.
+ *
+ * Steps to the next faster profile when a frame took more than
+ * POWER_GOVERNOR_HIGH_PERCENT of the period. Steps to the next slower one
+ * after POWER_GOVERNOR_SETTLE_FRAMES frames whose busy time, scaled to the
+ * slower clocks, stays below POWER_GOVERNOR_LOW_PERCENT. Does not switch;
+ * apply the result with power_profile_select() at a safe point.
+ *
+ * @param   busy_us     Time the last frame kept the core busy.
+ * @param   period_us   Target frame period.
+ *
+ * @return  Profile to use.
+ */
+power_profile_t power_profile_govern(uint32_t busy_us, uint32_t period_us);
+
+/**
+ * @brief   Print every profile with its clocks, measured inference time and
+ *          estimated energy per inference.
+ */
+void power_profile_print(void);
+
+#endif /* POWER_PROFILE_H_ */
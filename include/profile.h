@@ -0,0 +1,117 @@
+/**
+ * @file    profile.h
+ * @brief   Per-stage latency profiling for MAX78000 CNN projects.
+ *          Times pipeline stages with the Cortex-M4 DWT cycle counter.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+#include "mxc.h"
+#include "app_config.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Pipeline stages that can be timed */
+typedef enum {
+    PROFILE_STAGE_CAPTURE = 0,  /**< Camera capture (including streamed rows) */
+    PROFILE_STAGE_CONVERT,      /**< RGB888 to CNN word / RGB565 conversion */
+    PROFILE_STAGE_FIFO_LOAD,    /**< Writes to the CNN input FIFO */
+    PROFILE_STAGE_CNN,          /**< CNN start to completion seen by the CPU */
+    PROFILE_STAGE_SOFTMAX,      /**< Output unload and softmax */
+    PROFILE_STAGE_TFT,          /**< TFT image and result drawing */
+    PROFILE_STAGE_SERIAL,       /**< Serial frame upload */
+    PROFILE_STAGE_FRAME,        /**< Whole capture-to-result iteration */
+    PROFILE_NUM_STAGES
+} profile_stage_t;
+
+/** Samples kept per stage for the p99 estimate */
+#ifndef PROFILE_RING_SIZE
+#define PROFILE_RING_SIZE   32
+#endif
+
+/*
+ * Instrumentation macros. They compile away unless PROFILE_ENABLE is set, so
+ * spans can stay in the code permanently. PROFILE_NOW() reads 0 when disabled,
+ * letting the compiler drop caller-side accumulation too.
+ */
+#if PROFILE_ENABLE
+#define PROFILE_NOW()                   profile_now()
+#define PROFILE_BEGIN(stage)            profile_begin(stage)
+#define PROFILE_END(stage)              profile_end(stage)
+#define PROFILE_RECORD(stage, cycles)   profile_record((stage), (cycles))
+#else
+#define PROFILE_NOW()                   0U
+#define PROFILE_BEGIN(stage)            ((void)0)
+#define PROFILE_END(stage)              ((void)0)
+#define PROFILE_RECORD(stage, cycles)   ((void)(cycles))
+#endif
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Read the cycle counter.
+ *
+ * Valid after profile_init(). Wraps every 2^32 cycles (~43 s at 100 MHz);
+ * unsigned subtraction of two readings is correct across one wrap.
+ *
+ * @return  Current core cycle count.
+ */
+static inline uint32_t profile_now(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief   Enable the DWT cycle counter and clear all statistics.
+ */
+void profile_init(void);
+
+/**
+ * @brief   Clear all statistics, keeping the counter running.
+ */
+void profile_reset(void);
+
+/**
+ * @brief   Mark the start of a stage span.
+ *
+ * @param   stage   Stage to time. Spans of the same stage must not nest.
+ */
+void profile_begin(profile_stage_t stage);
+
+/**
+ * @brief   Mark the end of a stage span and record its duration.
+ *
+ * @param   stage   Stage passed to the matching profile_begin().
+ */
+void profile_end(profile_stage_t stage);
+
+/**
+ * @brief   Record a duration measured by the caller.
+ *
+ * Used for stages that run in many short pieces (e.g. per camera row), where
+ * the caller sums the pieces with profile_now() and records one sample.
+ *
+ * @param   stage   Stage to record.
+ * @param   cycles  Duration in core cycles.
+ */
+void profile_record(profile_stage_t stage, uint32_t cycles);
+
+/**
+ * @brief   Print all stages with samples as a marker block.
+ *
+ * Output (times in microseconds, p99 over the last PROFILE_RING_SIZE samples):
+ *   <<<PROFILE>>>
+ *   stage,count,min_us,avg_us,max_us,p99_us
+ *   capture,12,9120,9133,9170,9170
+ *   ...
+ *   <<<PROFILE>>>
+ */
+void profile_dump(void);
+
+#endif /* PROFILE_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @file    result_tracker.h
+ * @brief   Temporal smoothing of CNN results for MAX78000 projects.
+ *          Averages the Q15 softmax over successive frames and reports a
+ *          class as stable only after it has held for several frames.
+ */
+
+#ifndef RESULT_TRACKER_H_
+#define RESULT_TRACKER_H_
+
+#include <stdint.h>
+#include "inference_utils.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Tracker events returned by tracker_update() */
+typedef enum {
+    TRACKER_EVT_NONE = 0,   /**< No change of the stable class */
+    TRACKER_EVT_STABLE,     /**< A class became stable (or replaced another) */
+    TRACKER_EVT_LOST        /**< The stable class dropped below the exit level */
+} tracker_event_t;
+
+/** Tracker state */
+typedef struct {
+    int32_t  score[CNN_NUM_OUTPUTS];    /**< Smoothed softmax (Q15) */
+    int      stable_class;              /**< Confirmed class, -1 if none */
+    int      candidate;                 /**< Leading class awaiting confirmation */
+    int      candidate_run;             /**< Frames the candidate has led */
+    uint32_t frames;                    /**< Frames since tracker_init() */
+} result_tracker_t;
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Clear the tracker (no history, no stable class).
+ *
+ * @param   tracker     Tracker to reset.
+ */
+void tracker_init(result_tracker_t *tracker);
+
+/**
+ * @brief   Add one inference result.
+ *
+ * The score of each class is an exponential moving average with weight
+ * 1 / 2^TRACKER_EMA_SHIFT. The leading class becomes stable once its score
+ * is at least TRACKER_ENTER_PERCENT for TRACKER_CONFIRM_FRAMES frames in a
+ * row, and stays stable until it falls below TRACKER_EXIT_PERCENT.
+ *
+ * @param   tracker     Tracker to update.
+ * @param   result      Result of the latest frame.
+ *
+ * @return  Event caused by this frame.
+ */
+tracker_event_t tracker_update(result_tracker_t *tracker, const inference_result_t *result);
+
+/**
+ * @brief   Get the smoothed result.
+ *
+ * softmax holds the smoothed scores; predicted_class is the stable class,
+ * or the leading class if none is stable. raw_output and inference_time_us
+ * are taken from latest.
+ *
+ * @param   tracker     Tracker to read.
+ * @param   latest      Result of the latest frame.
+ * @param   out         Filled with the smoothed result (may equal latest).
+ */
+void tracker_get_result(const result_tracker_t *tracker, const inference_result_t *latest,
+                        inference_result_t *out);
+
+/**
+ * @brief   Check whether a class is confirmed.
+ *
+ * @return  1 if a class is stable, 0 otherwise.
+ */
+int tracker_is_stable(const result_tracker_t *tracker);
+
+#endif /* RESULT_TRACKER_H_ */
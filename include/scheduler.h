@@ -0,0 +1,110 @@
+/**
+ * @file    scheduler.h
+ * @brief   Event flags and sleep helpers for MAX78000 CNN projects.
+ *          Interrupts post events; the main loop sleeps in WFI until one
+ *          it waits for is pending.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+#include "mxc.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/** Scheduler events (bit flags) */
+typedef enum {
+    SCHED_EVT_FRAME_TICK = (1u << 0),   /**< Frame period timer expired */
+    SCHED_EVT_BUTTON     = (1u << 1),   /**< Capture button pressed */
+    SCHED_EVT_CNN_DONE   = (1u << 2),   /**< CNN finished an inference */
+    SCHED_EVT_TX_DONE    = (1u << 3)    /**< Serial DMA upload drained */
+} sched_event_t;
+
+/**
+ * Sleep in WFI while cond holds, without missing a wake-up.
+ *
+ * cond is evaluated with interrupts masked; WFI still wakes on a pending
+ * interrupt, which then runs as soon as the mask is lifted. A plain
+ * "while (cond) __WFI();" can sleep through the last interrupt if it fires
+ * between the test and the WFI.
+ */
+#define SCHED_SLEEP_WHILE(cond)         \
+    do {                                \
+        __disable_irq();                \
+        while (cond) {                  \
+            __WFI();                    \
+            __enable_irq();             \
+            __disable_irq();            \
+        }                               \
+        __enable_irq();                 \
+    } while (0)
+
+/*******************************************************************************
+ * Function Prototypes
+ ******************************************************************************/
+
+/**
+ * @brief   Set up the frame timer and the capture button interrupt.
+ *
+ * @return  0 on success, -1 on failure.
+ */
+int sched_init(void);
+
+/**
+ * @brief   Post events (callable from interrupt handlers).
+ *
+ * @param   events  OR of sched_event_t flags.
+ */
+void sched_post(uint32_t events);
+
+/**
+ * @brief   Sleep until any of the given events is pending, then take them.
+ *
+ * Events posted while nobody waits are kept, so a frame tick that fires
+ * during a long frame starts the next one immediately.
+ *
+ * @param   mask    OR of sched_event_t flags to wait for.
+ *
+ * @return  The pending events from mask (cleared).
+ */
+uint32_t sched_wait(uint32_t mask);
+
+/**
+ * @brief   Take pending events without sleeping.
+ *
+ * @param   mask    OR of sched_event_t flags.
+ *
+ * @return  The pending events from mask (cleared), 0 if none.
+ */
+uint32_t sched_take(uint32_t mask);
+
+/**
+ * @brief   Check for pending events without taking them.
+ *
+ * @param   mask    OR of sched_event_t flags.
+ *
+ * @return  The pending events from mask, 0 if none.
+ */
+uint32_t sched_peek(uint32_t mask);
+
+/**
+ * @brief   Post SCHED_EVT_FRAME_TICK periodically.
+ *
+ * @param   period_ms   Target frame period in milliseconds (0 stops the timer).
+ */
+void sched_set_frame_period(uint32_t period_ms);
+
+/**
+ * @brief   Frame period last set with sched_set_frame_period().
+ *
+ * The timer count is computed from the peripheral clock, so set the period
+ * again after a clock change.
+ *
+ * @return  Period in milliseconds, 0 when stopped.
+ */
+uint32_t sched_get_frame_period(void);
+
+#endif /* SCHEDULER_H_ */
@@ -8,6 +8,9 @@
 #define SERIAL_STREAM_H_
 
 #include <stdint.h>
+#include "app_config.h"
+#include "image_codec.h"
+#include "camera_utils.h"
 
 /*******************************************************************************
  * Definitions
@@ -20,10 +23,236 @@ typedef enum {
     STREAM_FORMAT_HEX       /**< Hex dump (for debugging) */
 } stream_format_t;
 
+/** Pixel formats for binary frames */
+typedef enum {
+    STREAM_PIXFMT_RGB888 = 0,   /**< 3 bytes per pixel: R, G, B */
+    STREAM_PIXFMT_RGB565 = 1    /**< 2 bytes per pixel, big-endian (TFT order) */
+} stream_pixfmt_t;
+
+/**
+ * Binary frame layout (all fields little-endian), sent after a
+ * "<<<FRAME>>>" marker line:
+ *
+ *   offset  size  field
+ *        0     4  magic "MXFR"
+ *        4     1  protocol version (SERIAL_FRAME_VERSION)
+ *        5     1  pixel format (stream_pixfmt_t)
+ *        6     1  codec (image_codec_t, 0 = uncompressed, or
+ *                 SERIAL_CODEC_TILE_DELTA)
+ *        7     1  flags (SERIAL_FRAME_FLAG_*)
+ *        8     2  width
+ *       10     2  height
+ *       12     4  capture ID
+ *       16     4  payload length in bytes
+ *       20     4  CRC32 (IEEE 802.3, as zlib.crc32) of the payload
+ *
+ * The payload follows the header immediately. Compressed payloads always
+ * decode to RGB888 and carry STREAM_PIXFMT_RGB888 in the format field.
+ */
+#define SERIAL_FRAME_MAGIC          "MXFR"
+#define SERIAL_FRAME_VERSION        1
+#define SERIAL_FRAME_HEADER_SIZE    24
+
+/** Flag: frame of a live stream (keyframe, or a delta against the last one) */
+#define SERIAL_FRAME_FLAG_LIVE      0x01
+
+/**
+ * Codec of live delta frames, which update the previous live frame tile by
+ * tile. Payload (little-endian):
+ *
+ *   offset  size  field
+ *        0     1  tile side in pixels
+ *        1     1  tile pixel format (stream_pixfmt_t)
+ *        2     2  tiles across
+ *        4     2  tiles down
+ *        6     2  number of changed tiles
+ *        8     b  changed-tile bitmap, row-major, LSB first
+ *                 (b = (across * down + 7) / 8)
+ *
+ * then the pixels of each changed tile in bitmap order, row by row; tiles
+ * at the right and bottom edges are cut to the frame.
+ */
+#define SERIAL_CODEC_TILE_DELTA     3
+
+/** Asynchronous stream status */
+typedef enum {
+    STREAM_ASYNC_IDLE = 0,  /**< No frame queued, UART idle */
+    STREAM_ASYNC_BUSY,      /**< A frame is still being sent */
+    STREAM_ASYNC_ERROR      /**< Frame rejected (not initialized or too large) */
+} stream_async_status_t;
+
 /*******************************************************************************
  * Function Prototypes
  ******************************************************************************/
 
+/**
+ * @brief   Set the console UART baud rate used for streaming.
+ *
+ * The PC side must be opened at the same rate.
+ *
+ * @param   baud        Baud rate in bits per second.
+ */
+void serial_stream_init(uint32_t baud);
+
+/**
+ * @brief   Select the compression applied to subsequent binary frames.
+ *
+ * Applies to serial_stream_frame() and, when enabled,
+ * serial_stream_async_start(). The default comes from SERIAL_STREAM_CODEC.
+ *
+ * @param   codec       IMAGE_CODEC_NONE, IMAGE_CODEC_DRLE or IMAGE_CODEC_JPEG.
+ * @param   quality     JPEG quality 1-100 (ignored by the other codecs).
+ */
+void serial_stream_set_codec(image_codec_t codec, int quality);
+
+/**
+ * @brief   Send image as a binary frame (header + raw pixels).
+ *
+ * Bytes are written through a buffered UART writer instead of stdio, so a
+ * 128x128 RGB888 frame costs its 48 KB payload plus a 24-byte header.
+ * With a codec selected the frame is encoded twice (once for length and
+ * CRC, once to send) instead of buffering the compressed payload.
+ *
+ * @param   cnn_buffer  CNN input buffer (packed pixels XOR 0x00808080).
+ * @param   width       Image width.
+ * @param   height      Image height.
+ * @param   capture_id  Capture number/ID stored in the header.
+ * @param   format      Pixel format of the payload.
+ */
+void serial_stream_frame(const uint32_t *cnn_buffer, int width, int height,
+                          int capture_id, stream_pixfmt_t format);
+
+/**
+ * @brief   Send a frame view as a binary frame, pixels read in place.
+ *
+ * Same wire format as serial_stream_frame(). Only a packed CAM_VIEW_CNN view
+ * can be compressed; other views are sent uncompressed whatever the codec.
+ *
+ * @param   view        Frame to send (any cam_view_format_t).
+ * @param   capture_id  Capture number/ID stored in the header.
+ * @param   format      Pixel format of the payload.
+ */
+void serial_stream_frame_view(const cam_frame_view_t *view, int capture_id,
+                              stream_pixfmt_t format);
+
+#if SERIAL_LIVE_DELTA_ENABLE
+/**
+ * @brief   Forget the live reference, so the next live frame is a keyframe.
+ *
+ * Call when a live stream (re)starts.
+ */
+void serial_stream_live_reset(void);
+
+/**
+ * @brief   Send the next frame of a live stream.
+ *
+ * Sends a keyframe (a normal frame, compressed as serial_stream_frame_view(),
+ * with SERIAL_FRAME_FLAG_LIVE) first, every SERIAL_LIVE_KEYFRAME_INTERVAL
+ * frames and on a size change, and otherwise a SERIAL_CODEC_TILE_DELTA frame
+ * with the tiles whose quadrant mean luma, or mean red or blue, moved by
+ * more than SERIAL_LIVE_TILE_THRESHOLD since the host last got them. A delta that
+ * would not be smaller than the full frame is sent as a keyframe instead.
+ *
+ * Tiles are compared by signature rather than against a stored frame, so
+ * changes below the threshold stay on the host until the next keyframe.
+ *
+ * @param   view        Frame to send (any cam_view_format_t).
+ * @param   capture_id  Capture number/ID stored in the header.
+ * @param   format      Pixel format of the tile pixels and raw keyframes.
+ */
+void serial_stream_live_frame(const cam_frame_view_t *view, int capture_id,
+                              stream_pixfmt_t format);
+#endif
+
+#if SERIAL_STREAM_ASYNC_ENABLE
+/**
+ * @brief   Set up non-blocking frame streaming over UART TX DMA.
+ *
+ * @param   dma_channel DMA channel acquired with MXC_DMA_AcquireChannel().
+ *
+ * @return  0 on success, -1 on invalid channel.
+ */
+int serial_stream_async_init(int dma_channel);
+
+/**
+ * @brief   Queue a binary frame for DMA transmission and return.
+ *
+ * The frame (marker, header and payload) is serialized into one of
+ * SERIAL_ASYNC_SLOTS slots, so cnn_buffer may be overwritten by the next
+ * capture as soon as this returns. Blocks only when every slot is queued.
+ *
+ * Anything printed to the console while a frame is in flight ends up inside
+ * the frame; call serial_stream_async_complete() before printing.
+ *
+ * @param   cnn_buffer  CNN input buffer (packed pixels XOR 0x00808080).
+ * @param   width       Image width.
+ * @param   height      Image height.
+ * @param   capture_id  Capture number/ID stored in the header.
+ * @param   format      Pixel format of the payload.
+ *
+ * @return  STREAM_ASYNC_BUSY when queued, STREAM_ASYNC_ERROR otherwise
+ *          (including a compressed payload that does not fit a slot).
+ */
+stream_async_status_t serial_stream_async_start(const uint32_t *cnn_buffer, int width,
+                                                int height, int capture_id,
+                                                stream_pixfmt_t format);
+
+/**
+ * @brief   Queue a frame view for DMA transmission and return.
+ *
+ * As serial_stream_async_start(), with the compression rule of
+ * serial_stream_frame_view().
+ */
+stream_async_status_t serial_stream_async_start_view(const cam_frame_view_t *view,
+                                                     int capture_id, stream_pixfmt_t format);
+
+#if SERIAL_LIVE_DELTA_ENABLE
+/**
+ * @brief   Queue a live frame for DMA transmission and return.
+ *
+ * As serial_stream_live_frame(), using the slots of
+ * serial_stream_async_start_view(). A frame that is rejected makes the next
+ * one a keyframe.
+ */
+stream_async_status_t serial_stream_async_start_live(const cam_frame_view_t *view,
+                                                     int capture_id, stream_pixfmt_t format);
+#endif
+
+/**
+ * @brief   Check whether queued frames are still being sent.
+ *
+ * @return  STREAM_ASYNC_BUSY while sending, STREAM_ASYNC_IDLE when done.
+ */
+stream_async_status_t serial_stream_async_poll(void);
+
+/**
+ * @brief   Wait until every queued frame has left the UART.
+ */
+void serial_stream_async_complete(void);
+
+/**
+ * @brief   Register a function called from the DMA interrupt when the last
+ *          queued frame has been handed to the UART.
+ *
+ * The UART FIFO may still hold a few bytes; serial_stream_async_complete()
+ * returns quickly after this fired.
+ *
+ * @param   callback    Function to call, or NULL to remove it.
+ */
+void serial_stream_async_set_callback(void (*callback)(void));
+#endif /* SERIAL_STREAM_ASYNC_ENABLE */
+
+/**
+ * @brief   Update a running CRC32 (IEEE 802.3, reflected, as zlib.crc32).
+ *
+ * @param   crc     Previous CRC value (0 for the first block).
+ * @param   data    Bytes to add.
+ * @param   len     Number of bytes.
+ *
+ * @return  Updated CRC value.
+ */
+uint32_t serial_crc32(uint32_t crc, const uint8_t *data, uint32_t len);
+
 /**
  * @brief   Send image data over serial in PPM format.
  *          PPM can be opened directly by many image viewers and Python.
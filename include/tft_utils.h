@@ -27,6 +27,23 @@
 #define TFT_CYAN            0x07FF
 #define TFT_MAGENTA         0xF81F
 
+/** Retained overlay items (text fields and bars, see tft_utils_overlay_*) */
+#ifndef TFT_OVERLAY_TEXTS
+#define TFT_OVERLAY_TEXTS   16
+#endif
+#ifndef TFT_OVERLAY_BARS
+#define TFT_OVERLAY_BARS    8
+#endif
+#ifndef TFT_OVERLAY_TEXT_LEN
+#define TFT_OVERLAY_TEXT_LEN 32
+#endif
+
+/** Glyph cell width of the overlay font for per-character redraws; 0 for
+ *  proportional fonts (a changed field is then redrawn as a whole) */
+#ifndef TFT_OVERLAY_GLYPH_WIDTH
+#define TFT_OVERLAY_GLYPH_WIDTH 0
+#endif
+
 /** TFT operation status codes */
 typedef enum {
     TFT_STATUS_OK = 0,
@@ -68,6 +85,31 @@ void tft_utils_display_image(int x, int y, int width, int height,
 void tft_utils_display_cnn_buffer(int x, int y, int width, int height,
                                    const uint32_t *cnn_buffer);
 
+/**
+ * @brief   Open a window for row-by-row drawing with tft_utils_stream_row().
+ *
+ * Rows are converted into a batch buffer and written with one windowed
+ * transfer per batch instead of one per row.
+ *
+ * @param   x           X position on screen.
+ * @param   y           Y position on screen.
+ * @param   width       Image width.
+ * @param   height      Image height (rows to expect).
+ */
+void tft_utils_stream_begin(int x, int y, int width, int height);
+
+/**
+ * @brief   Add the next row of the window (converts to RGB565).
+ *
+ * The batch is written when full and after the last row. Usable from the
+ * capture loop to draw camera rows as they arrive.
+ *
+ * @param   pixels      width words, (B<<16)|(G<<8)|R per pixel.
+ * @param   cnn_format  1 if the words are XOR'd with 0x00808080 (CNN buffer),
+ *                      0 for raw camera words.
+ */
+void tft_utils_stream_row(const uint32_t *pixels, int cnn_format);
+
 /**
  * @brief   Display a text string on the TFT.
  *
@@ -93,9 +135,50 @@ void tft_utils_show_results(const char (*class_names)[20],
                              int num_classes,
                              int predicted_class);
 
+/**
+ * @brief   Draw a retained text field, only where it changed.
+ *
+ * Fields are keyed by position. Unchanged text costs no SPI traffic; when
+ * the new text is narrower in pixels, the rest of the old one is cleared to
+ * bg_color. With TFT_OVERLAY_GLYPH_WIDTH set only the changed character run
+ * is redrawn.
+ *
+ * @param   x           X position.
+ * @param   y           Y position.
+ * @param   text        Text string to display.
+ * @param   fg_color    Foreground color (RGB565).
+ * @param   bg_color    Background color (RGB565).
+ */
+void tft_utils_overlay_text(int x, int y, const char *text,
+                            uint16_t fg_color, uint16_t bg_color);
+
+/**
+ * @brief   Draw a retained horizontal bar, only the part that changed.
+ *
+ * Bars are keyed by position. A longer fill draws the added part, a shorter
+ * one clears the removed part; a color change redraws the fill.
+ *
+ * @param   x           X position.
+ * @param   y           Y position.
+ * @param   width       Full bar width.
+ * @param   height      Bar height.
+ * @param   percent     Filled part (0-100).
+ * @param   color       Fill color (RGB565).
+ * @param   bg_color    Background color (RGB565).
+ */
+void tft_utils_overlay_bar(int x, int y, int width, int height, int percent,
+                           uint16_t color, uint16_t bg_color);
+
+/**
+ * @brief   Forget all retained overlay items (the next draw is full).
+ */
+void tft_utils_overlay_reset(void);
+
 /**
  * @brief   Clear the TFT screen.
  *
+ * Also resets the overlay.
+ *
  * @param   color       Fill color (RGB565).
  */
 void tft_utils_clear(uint16_t color);
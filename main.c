@@ -30,12 +30,34 @@
 #include "camera_utils.h"
 #include "inference_utils.h"
 #include "display_utils.h"
-#ifdef TFT_ENABLE
+#include "profile.h"
+#include "scheduler.h"
+#if MOTION_GATE_ENABLE
+#include "motion.h"
+#endif
+#if TRACKER_ENABLE
+#include "result_tracker.h"
+#endif
+#if BENCHMARK_ENABLE
+#include "benchmark.h"
+#endif
+#if TFT_ENABLE
 #include "tft_utils.h"
 #endif
-#ifdef SERIAL_STREAM_ENABLE
+#if SERIAL_STREAM_ENABLE
 #include "serial_stream.h"
 #endif
+#if FAST_PATH_ENABLE
+#include "cnn_network.h"
+#include FAST_PATH_HEADER
+#endif
+#if CAPTURE_LOG_ENABLE
+#include "capture_log.h"
+#include "uart.h"
+#endif
+#if POWER_PROFILE_ENABLE
+#include "power_profile.h"
+#endif
 
 /*******************************************************************************
  * Definitions - Customize these for your project
@@ -54,11 +76,109 @@ static const char CLASS_NAMES[CNN_NUM_OUTPUTS][20] = {
  * Variables
  ******************************************************************************/
 
+/* Live-feed frames are uploaded over UART TX DMA while the next one is captured */
+#if SERIAL_STREAM_ENABLE && SERIAL_STREAM_ASYNC_ENABLE
+#define LIVE_FEED_UPLOAD    1
+#else
+#define LIVE_FEED_UPLOAD    0
+#endif
+
+/* The live feed picks the slowest power profile that keeps its frame rate */
+#if POWER_PROFILE_ENABLE && POWER_GOVERNOR_ENABLE && LIVE_FEED_FRAME_PERIOD_MS > 0
+#define LIVE_FEED_GOVERNOR  1
+#else
+#define LIVE_FEED_GOVERNOR  0
+#endif
+
+#if LIVE_FEED_UPLOAD || MEMORY_LAYOUT != MEMORY_LAYOUT_LEGACY
+/* No RGB565 copy: the TFT converts from the CNN frame (or camera rows), and
+ * the upload slots reuse its SRAM budget */
+#define RGB565_BUFFER       NULL
+#define RGB565_BUFFER_SIZE  0
+#else
 /** RGB565 buffer for TFT display */
 static uint8_t data565[DATA565_SIZE];
+#define RGB565_BUFFER       data565
+#define RGB565_BUFFER_SIZE  DATA565_SIZE
+#endif
+
+/* The staging copy of the frame is only needed by consumers that read the
+ * pixels back, or when the whole frame is loaded into the FIFO after capture */
+#if MEMORY_LAYOUT == MEMORY_LAYOUT_STREAM
+#if !CAPTURE_FIFO_STREAM_ENABLE
+#error "MEMORY_LAYOUT_STREAM needs CAPTURE_FIFO_STREAM_ENABLE"
+#endif
+#if SERIAL_STREAM_ENABLE || ASCII_ART_ENABLE
+#error "MEMORY_LAYOUT_STREAM keeps no frame for serial images or ASCII art"
+#endif
+#define FRAME_STAGED        0
+#elif TFT_ENABLE || SERIAL_STREAM_ENABLE || ASCII_ART_ENABLE || !CAPTURE_FIFO_STREAM_ENABLE
+#define FRAME_STAGED        1
+#else
+#define FRAME_STAGED        0
+#endif
 
-/** Input buffer for CNN (packed pixels) */
-static uint32_t input_buffer[INPUT_WORDS];
+#if FAST_PATH_ENABLE
+#if CAPTURE_FIFO_STREAM_ENABLE || !CNN_NETWORK_TABLE_ENABLE
+#error "FAST_PATH_ENABLE needs a staged frame (CAPTURE_FIFO_STREAM_ENABLE 0) and CNN_NETWORK_TABLE_ENABLE"
+#endif
+/** Half-resolution input of the fast network */
+#define FAST_PATH_WORDS     ((IMAGE_SIZE_X / 2) * (IMAGE_SIZE_Y / 2))
+#endif
+
+#if CAPTURE_LOG_ENABLE
+#if !FRAME_STAGED
+#error "CAPTURE_LOG_ENABLE needs a kept frame (TFT, serial images, ASCII art or a staged frame)"
+#endif
+/* Console rate before and after a log dump */
+#if SERIAL_STREAM_ENABLE
+#define LOG_CONSOLE_BAUD    SERIAL_STREAM_BAUD
+#else
+#define LOG_CONSOLE_BAUD    CONSOLE_BAUD
+#endif
+/* Console commands: dump the log, erase it */
+#define LOG_CMD_OFFLOAD     'D'
+#define LOG_CMD_ERASE       'E'
+#endif
+
+/* Row callback during capture: motion signature, and TFT drawing when no
+ * frame is kept */
+#if (LIVE_FEED_ENABLE && MOTION_GATE_ENABLE) || (TFT_ENABLE && !FRAME_STAGED)
+#define CAPTURE_ROW_HOOK    1
+#else
+#define CAPTURE_ROW_HOOK    0
+#endif
+
+#if FRAME_STAGED
+/** Input buffers for CNN (packed pixels), one per frame pool slot */
+static uint32_t frame_storage[FRAME_POOL_SLOTS][INPUT_WORDS];
+/** Frame being displayed and streamed */
+static uint32_t *input_buffer = frame_storage[0];
+/** input_buffer as a frame view, read in place by the serial and ASCII outputs */
+static cam_frame_view_t input_view;
+#define CAPTURE_BUFFER      input_buffer
+#else
+#define CAPTURE_BUFFER      NULL
+#endif
+
+#if !CAPTURE_FIFO_STREAM_ENABLE
+/** Slot of input_buffer, owned by FRAME_OWNER_DISPLAY until the next frame */
+static frame_slot_t *display_slot = NULL;
+/** Frame captured ahead while the CNN was busy, waiting to be inferred */
+static frame_slot_t *prefetched_slot = NULL;
+#endif
+
+#if FAST_PATH_ENABLE
+/** Half-resolution network, resident next to the full one */
+CNN_NETWORK_DEFINE(fast_network, FAST_PATH_PREFIX);
+/** Model index of fast_network, -1 when it could not be loaded */
+static int fast_model = -1;
+/** 2x2-binned copy of input_buffer fed to fast_network */
+static uint32_t fast_buffer[FAST_PATH_WORDS];
+/** Frames classified by the fast network, and those escalated to the full one */
+static uint32_t fast_frames = 0;
+static uint32_t fast_escalated = 0;
+#endif
 
 /** Capture counter for image naming */
 static int capture_count = 0;
@@ -70,7 +190,34 @@ static int capture_count = 0;
 static void system_init(void);
 static int hardware_init(void);
 static void wait_for_button(const char *message);
+static cam_status_t capture_and_infer(int *skipped);
+#if CAPTURE_ROW_HOOK
+static void capture_row_hook(int row, const uint32_t *pixels, uint32_t width, void *ctx);
+#endif
+#if FAST_PATH_ENABLE
+static inference_status_t escalate_if_unsure(inference_result_t *result,
+                                             inference_result_mode_t mode);
+#endif
+#if !CAPTURE_FIFO_STREAM_ENABLE
+static cam_status_t capture_slot(frame_slot_t *slot);
+static void release_display_slot(void);
+#if LIVE_FEED_ENABLE
+#if FRAME_POOL_SLOTS > 1
+static void prefetch_frame(void);
+#endif
+static void drop_prefetched_frame(void);
+#endif
+#endif
+#if CAPTURE_LOG_ENABLE
+static void poll_log_command(void);
+#endif
 static void run_inference_loop(void);
+#if LIVE_FEED_ENABLE
+static void on_cnn_done(void);
+#if LIVE_FEED_UPLOAD
+static void on_upload_drained(void);
+#endif
+#endif
 
 /*******************************************************************************
  * Code
@@ -95,9 +242,14 @@ static void system_init(void)
 
     MXC_ICC_Enable(MXC_ICC0); /* Enable cache */
 
+#if POWER_PROFILE_ENABLE
+    /* System clock, CNN clock and boost of the start-up profile */
+    power_profile_select(POWER_PROFILE_DEFAULT);
+#else
     /* Switch to 100 MHz clock */
     MXC_SYS_Clock_Select(MXC_SYS_CLOCK_IPO);
     SystemCoreClockUpdate();
+#endif
 
     printf("Waiting...\n");
 
@@ -105,6 +257,19 @@ static void system_init(void)
     MXC_Delay(SEC(2));
 }
 
+#if POWER_PROFILE_ENABLE
+/**
+ * @brief   Re-time the peripherals divided from the new peripheral clock.
+ */
+static void on_clock_change(void)
+{
+    sched_set_frame_period(sched_get_frame_period());
+    if (camera_utils_reclock() != CAM_STATUS_OK) {
+        printf("Camera re-clock failed!\n");
+    }
+}
+#endif
+
 /**
  * @brief   Initialize hardware peripherals.
  *
@@ -115,6 +280,14 @@ static int hardware_init(void)
     int dma_channel;
     cam_status_t cam_ret;
 
+    /* Cycle counter for stage timing */
+    profile_init();
+
+#if POWER_PROFILE_ENABLE
+    /* Profile switches from here on also re-time the camera and frame timer */
+    power_profile_set_reclock_callback(on_clock_change);
+#endif
+
     /* DMA initialization */
     MXC_DMA_Init();
     dma_channel = MXC_DMA_AcquireChannel();
@@ -125,8 +298,32 @@ static int hardware_init(void)
         printf("Camera initialization failed!\n");
         return -1;
     }
+#if CAMERA_SENSOR_RGB565
+    {
+        cam_capture_config_t cam_cfg;
+
+        /* Fewer bytes per frame over the camera interface */
+        camera_utils_get_config(&cam_cfg);
+        cam_cfg.format = CAM_SENSOR_RGB565;
+        if (camera_utils_configure(&cam_cfg) != CAM_STATUS_OK) {
+            printf("RGB565 camera output failed, using RGB888\n");
+        }
+    }
+#endif
+
+#if SERIAL_STREAM_ENABLE
+    serial_stream_init(SERIAL_STREAM_BAUD);
+#endif
+
+#if LIVE_FEED_UPLOAD
+    /* Second channel for UART TX, next to the camera's */
+    if (serial_stream_async_init(MXC_DMA_AcquireChannel()) != 0) {
+        printf("Serial DMA initialization failed!\n");
+        return -1;
+    }
+#endif
 
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     /* TFT display initialization */
     if (tft_utils_init() != TFT_STATUS_OK) {
         printf("TFT initialization failed! Continuing without display.\n");
@@ -139,6 +336,60 @@ static int hardware_init(void)
         return -1;
     }
 
+#if INFERENCE_FIFO_DMA_ENABLE
+    /* Another channel for the CNN FIFO (CPU loading if none is free) */
+    if (inference_fifo_dma_init(MXC_DMA_AcquireChannel()) != 0) {
+        printf("CNN FIFO DMA unavailable, loading by CPU\n");
+    }
+#endif
+
+#if !CAPTURE_FIFO_STREAM_ENABLE
+    /* Staging slots handed between camera, CNN and display */
+    frame_pool_init(frame_storage[0], FRAME_POOL_SLOTS, INPUT_WORDS);
+#endif
+#if FAST_PATH_ENABLE
+    /* Half-resolution network next to the full one in weight memory */
+    if (fast_network.layers[0].in_w != IMAGE_SIZE_X / 2 ||
+        fast_network.layers[0].in_h != IMAGE_SIZE_Y / 2 ||
+        (fast_model = inference_add_model(&fast_network)) < 0) {
+        printf("Fast path network %s unusable, running full resolution only\n",
+               fast_network.name);
+    }
+#endif
+#if FRAME_STAGED
+    camera_utils_view_cnn(&input_view, input_buffer, IMAGE_SIZE_X, IMAGE_SIZE_Y);
+#endif
+#if CAPTURE_LOG_ENABLE
+    if (capture_log_init() == CAPTURE_LOG_OK) {
+        capture_log_stats_t log_stats;
+
+        capture_log_get_stats(&log_stats);
+        printf("Capture log: boot %u, %u of %u pages used\n", (unsigned)log_stats.boot,
+               (unsigned)log_stats.used_pages, (unsigned)log_stats.pages);
+    } else {
+        printf("Capture log unavailable (flash controller)\n");
+    }
+#endif
+
+#if LIVE_FEED_ENABLE && MOTION_GATE_ENABLE
+    /* Build the frame signature while rows are converted */
+    motion_init(IMAGE_SIZE_X, IMAGE_SIZE_Y);
+#endif
+#if CAPTURE_ROW_HOOK
+    camera_utils_set_row_hook(capture_row_hook, NULL);
+#endif
+
+#if LIVE_FEED_ENABLE
+    /* Interrupt events for the live feed */
+    if (sched_init() != 0) {
+        return -1;
+    }
+    inference_set_done_callback(on_cnn_done);
+#if LIVE_FEED_UPLOAD
+    serial_stream_async_set_callback(on_upload_drained);
+#endif
+#endif
+
     return 0;
 }
 
@@ -156,7 +407,9 @@ static void wait_for_button(const char *message)
         printf("%s\n", message);
     }
     while (!PB_Get(CAPTURE_BUTTON)) {
-        /* wait */
+#if CAPTURE_LOG_ENABLE
+        poll_log_command();
+#endif
     }
 }
 
@@ -170,6 +423,36 @@ static int check_button_press(void)
     return PB_Get(CAPTURE_BUTTON);
 }
 
+#if CAPTURE_LOG_ENABLE
+/**
+ * @brief   Run a capture log command received on the console, if any.
+ */
+static void poll_log_command(void)
+{
+    mxc_uart_regs_t *uart = MXC_UART_GET_UART(CONSOLE_UART);
+    capture_log_status_t ret;
+
+    if (MXC_UART_GetRXFIFOAvailable(uart) == 0) {
+        return;
+    }
+
+    switch (MXC_UART_ReadCharacterRaw(uart)) {
+    case LOG_CMD_OFFLOAD:
+        ret = capture_log_offload(CAPTURE_LOG_OFFLOAD_BAUD, LOG_CONSOLE_BAUD);
+        break;
+    case LOG_CMD_ERASE:
+        ret = capture_log_erase();
+        printf("Capture log erased\n");
+        break;
+    default:
+        return;
+    }
+    if (ret != CAPTURE_LOG_OK) {
+        printf("Capture log flash error!\n");
+    }
+}
+#endif
+
 /**
  * @brief   Clear terminal screen using ANSI escape codes.
  */
@@ -179,45 +462,333 @@ static void clear_screen(void)
     printf("\033[H");
 }
 
+#if CAPTURE_ROW_HOOK
 /**
- * @brief   Run single capture mode.
+ * @brief   Per-row work during capture.
  */
-static void run_single_capture(inference_result_t *result)
+static void capture_row_hook(int row, const uint32_t *pixels, uint32_t width, void *ctx)
+{
+#if LIVE_FEED_ENABLE && MOTION_GATE_ENABLE
+    motion_row_hook(row, pixels, width, ctx);
+#endif
+#if TFT_ENABLE && !FRAME_STAGED
+    /* No frame in SRAM: draw rows as they are captured */
+    if (row == 0) {
+        tft_utils_stream_begin(0, 0, (int)width, IMAGE_SIZE_Y);
+    }
+    tft_utils_stream_row(pixels, 0);
+#endif
+}
+#endif
+
+/**
+ * @brief   Capture a frame and hand it to the CNN.
+ *
+ * With CAPTURE_FIFO_STREAM_ENABLE the CNN is started first and each camera
+ * row goes to the FIFO as it arrives; otherwise the whole frame is captured
+ * and then loaded. The CNN is left running, call inference_wait() next.
+ *
+ * With MOTION_GATE_ENABLE and a non-NULL skipped, a frame that matches the
+ * last inferred one is not inferred: before the FIFO load, or in streaming
+ * mode by stopping the CNN once the frame is in (the remaining layers are
+ * saved). *skipped is then 1 and inference_wait() must not be called.
+ *
+ * @param   skipped     Set to 1 if inference was skipped (NULL: never skip).
+ *
+ * @return  CAM_STATUS_OK when the frame was captured.
+ */
+static cam_status_t capture_and_infer(int *skipped)
 {
     cam_status_t cam_ret;
-#ifdef TFT_ENABLE
-    int confidences[CNN_NUM_OUTPUTS];
+
+    if (skipped != NULL) {
+        *skipped = 0;
+    }
+
+#if CAPTURE_FIFO_STREAM_ENABLE
+    inference_start();
+    PROFILE_BEGIN(PROFILE_STAGE_CAPTURE);
+    cam_ret = camera_utils_capture_stream(CAPTURE_BUFFER, INPUT_WORDS,
+                                          RGB565_BUFFER, RGB565_BUFFER_SIZE);
+    PROFILE_END(PROFILE_STAGE_CAPTURE);
+    if (cam_ret != CAM_STATUS_OK) {
+        inference_abort();
+    }
+#if MOTION_GATE_ENABLE
+    else if (skipped != NULL && !motion_frame_changed()) {
+        inference_abort();
+        *skipped = 1;
+    }
 #endif
+#else
+    frame_slot_t *slot = prefetched_slot;
+
+    if (slot != NULL) {
+        /* Captured while the previous frame was inferred */
+        prefetched_slot = NULL;
+        cam_ret = CAM_STATUS_OK;
+    } else {
+        release_display_slot();
+        slot = frame_pool_acquire_wait(FRAME_OWNER_CAPTURE);
+        cam_ret = capture_slot(slot);
+    }
+    if (cam_ret != CAM_STATUS_OK) {
+        return cam_ret;
+    }
 
-    LED_Off(STATUS_LED1);
-    LED_Off(STATUS_LED2);
+    /* The new frame takes over the display */
+    release_display_slot();
+    display_slot = slot;
+    input_buffer = slot->data;
+    camera_utils_view_cnn(&input_view, input_buffer, IMAGE_SIZE_X, IMAGE_SIZE_Y);
+
+#if MOTION_GATE_ENABLE
+    if (skipped != NULL && !motion_frame_changed()) {
+        frame_pool_release(slot, FRAME_OWNER_INFER);
+        *skipped = 1;
+        return cam_ret;
+    }
+#endif
+#if FAST_PATH_ENABLE
+    if (fast_model >= 0) {
+        /* The display keeps the full frame for escalate_if_unsure() */
+        PROFILE_BEGIN(PROFILE_STAGE_CONVERT);
+        camera_utils_downscale_cnn(slot->data, IMAGE_SIZE_X, IMAGE_SIZE_Y, fast_buffer);
+        PROFILE_END(PROFILE_STAGE_CONVERT);
+        frame_pool_release(slot, FRAME_OWNER_INFER);
+        inference_select_model(fast_model);
+
+        PROFILE_BEGIN(PROFILE_STAGE_FIFO_LOAD);
+        inference_start();
+        inference_load_input(fast_buffer, FAST_PATH_WORDS);
+        PROFILE_END(PROFILE_STAGE_FIFO_LOAD);
+        return cam_ret;
+    }
+#endif
+    PROFILE_BEGIN(PROFILE_STAGE_FIFO_LOAD);
+    /* The DMA (if any) feeds the FIFO while the caller draws the frame; the
+     * slot's INFER ownership ends once the frame is in the FIFO */
+    if (inference_start_slot(slot, INPUT_WORDS) != INFERENCE_OK) {
+        cam_ret = CAM_STATUS_ERROR;
+    }
+    PROFILE_END(PROFILE_STAGE_FIFO_LOAD);
+#endif
 
-    capture_count++;
-    printf("\n=== Capture #%d ===\n", capture_count);
+    return cam_ret;
+}
 
-    /* Capture image from camera */
-    cam_ret = camera_utils_capture(input_buffer, INPUT_WORDS, data565, DATA565_SIZE);
+#if FAST_PATH_ENABLE
+/**
+ * @brief   Re-run a frame on the full network when the fast one is unsure.
+ *
+ * Call after the wait for a frame started by capture_and_infer(). Below
+ * FAST_PATH_ESCALATE_PERCENT confidence the full-resolution frame, still
+ * held by the display, is inferred again and replaces the result.
+ *
+ * @param   result      Fast network result, replaced when escalated.
+ * @param   mode        Result mode for the full network's wait.
+ *
+ * @return  INFERENCE_OK, or the full network's error.
+ */
+static inference_status_t escalate_if_unsure(inference_result_t *result,
+                                             inference_result_mode_t mode)
+{
+    if (fast_model < 0 || inference_get_model() != fast_model) {
+        return INFERENCE_OK;
+    }
+
+    fast_frames++;
+    inference_compute_confidence(result);
+    if (result->confidence_percent >= FAST_PATH_ESCALATE_PERCENT) {
+        return INFERENCE_OK;
+    }
+
+    fast_escalated++;
+    inference_select_model(0);
+    PROFILE_BEGIN(PROFILE_STAGE_FIFO_LOAD);
+    inference_start();
+    inference_load_input(input_buffer, INPUT_WORDS);
+    PROFILE_END(PROFILE_STAGE_FIFO_LOAD);
+
+    return inference_wait_mode(result, mode);
+}
+#endif
+
+#if !CAPTURE_FIFO_STREAM_ENABLE
+/**
+ * @brief   Capture a frame into a pool slot owned by FRAME_OWNER_CAPTURE.
+ *
+ * On success the slot passes to the CNN and the display.
+ */
+static cam_status_t capture_slot(frame_slot_t *slot)
+{
+    cam_status_t cam_ret;
+
+    PROFILE_BEGIN(PROFILE_STAGE_CAPTURE);
+    cam_ret = camera_utils_capture_slot(slot, FRAME_OWNER_INFER | FRAME_OWNER_DISPLAY,
+                                        RGB565_BUFFER, RGB565_BUFFER_SIZE);
+    PROFILE_END(PROFILE_STAGE_CAPTURE);
+
+    return cam_ret;
+}
+
+/**
+ * @brief   Give the displayed frame's slot back to the pool.
+ */
+static void release_display_slot(void)
+{
+    if (display_slot != NULL) {
+        frame_pool_release(display_slot, FRAME_OWNER_DISPLAY);
+        display_slot = NULL;
+    }
+}
+
+#if LIVE_FEED_ENABLE
+#if FRAME_POOL_SLOTS > 1
+/**
+ * @brief   Capture the next frame into a spare slot, if there is one.
+ *
+ * Runs while the CNN works on the current frame; the next
+ * capture_and_infer() then starts on it without waiting for the camera.
+ */
+static void prefetch_frame(void)
+{
+    frame_slot_t *slot;
+    cam_status_t cam_ret;
+
+    if (prefetched_slot != NULL) {
+        return;
+    }
+    slot = frame_pool_acquire(FRAME_OWNER_CAPTURE);
+    if (slot == NULL) {
+        return;
+    }
+
+    cam_ret = capture_slot(slot);
+    if (cam_ret == CAM_STATUS_OK) {
+        prefetched_slot = slot;
+    }
+#if CAMERA_RATE_ADAPT_ENABLE
+    else {
+        /* Clean frames are counted when they are inferred */
+        camera_utils_rate_update(cam_ret);
+    }
+#endif
+}
+#endif
+
+/**
+ * @brief   Drop a frame captured ahead (e.g. when leaving the live feed).
+ */
+static void drop_prefetched_frame(void)
+{
+    if (prefetched_slot != NULL) {
+        frame_pool_release(prefetched_slot, FRAME_OWNER_INFER | FRAME_OWNER_DISPLAY);
+        prefetched_slot = NULL;
+    }
+}
+#endif /* LIVE_FEED_ENABLE */
+#endif
+
+/**
+ * @brief   Capture one frame and run inference on it.
+ *
+ * @return  1 on success, 0 if capture or inference failed.
+ */
+static int capture_single_frame(inference_result_t *result)
+{
+    cam_status_t cam_ret;
+
+    /* Capture image from camera and feed the CNN */
+    cam_ret = capture_and_infer(NULL);
+#if CAMERA_RATE_ADAPT_ENABLE
+    /* Slow the camera down until the frame fits through the stream buffers */
+    while (camera_utils_rate_update(cam_ret) > 0 && cam_ret == CAM_STATUS_OVERFLOW) {
+        printf("Camera overflow, retrying at a lower capture rate\n");
+        cam_ret = capture_and_infer(NULL);
+    }
+#endif
     if (cam_ret == CAM_STATUS_OVERFLOW) {
         printf("Camera overflow! Halting.\n");
         while (1) {
             /* halt */
         }
     }
+    if (cam_ret != CAM_STATUS_OK) {
+        printf("Capture failed!\n");
+        return 0;
+    }
 
-#ifdef TFT_ENABLE
-    /* Display camera image on TFT */
+#if TFT_ENABLE && FRAME_STAGED
+    /* Display camera image on TFT while the CNN finishes */
+    PROFILE_BEGIN(PROFILE_STAGE_TFT);
     tft_utils_display_cnn_buffer(0, 0, IMAGE_SIZE_X, IMAGE_SIZE_Y, input_buffer);
+    PROFILE_END(PROFILE_STAGE_TFT);
 #endif
 
-    /* Start CNN and load input data */
-    inference_start();
-    inference_load_input(input_buffer, INPUT_WORDS);
-
     /* Wait for inference to complete */
     if (inference_wait(result) != INFERENCE_OK) {
         printf("Inference failed!\n");
+        return 0;
+    }
+#if FAST_PATH_ENABLE
+    if (escalate_if_unsure(result, INFERENCE_RESULT_FULL) != INFERENCE_OK) {
+        printf("Inference failed!\n");
+        return 0;
+    }
+#endif
+#if POWER_PROFILE_ENABLE
+    power_profile_record(result->inference_time_us);
+#endif
+
+    return 1;
+}
+
+/**
+ * @brief   Run single capture mode.
+ *
+ * With TRACKER_ENABLE, frames are captured until the smoothed result is
+ * stable (at most TRACKER_SINGLE_MAX_FRAMES) and the smoothed result of
+ * the last frame is reported.
+ */
+static void run_single_capture(inference_result_t *result)
+{
+#if CAMERA_RATE_ADAPT_ENABLE
+    cam_rate_status_t rate;
+#endif
+#if TFT_ENABLE
+    int confidences[CNN_NUM_OUTPUTS];
+#endif
+#if TRACKER_ENABLE
+    result_tracker_t tracker;
+    int frames = 0;
+#endif
+
+    LED_Off(STATUS_LED1);
+    LED_Off(STATUS_LED2);
+
+    capture_count++;
+    printf("\n=== Capture #%d ===\n", capture_count);
+
+    PROFILE_BEGIN(PROFILE_STAGE_FRAME);
+
+#if TRACKER_ENABLE
+    tracker_init(&tracker);
+    do {
+        if (!capture_single_frame(result)) {
+            return;
+        }
+        frames++;
+    } while (tracker_update(&tracker, result) != TRACKER_EVT_STABLE &&
+             frames < TRACKER_SINGLE_MAX_FRAMES);
+    tracker_get_result(&tracker, result, result);
+    printf("%s after %d frame(s)\n", tracker_is_stable(&tracker) ? "Stable" : "Not stable",
+           frames);
+#else
+    if (!capture_single_frame(result)) {
         return;
     }
+#endif
 
     printf("\n*** PASS ***\n\n");
 
@@ -229,7 +800,24 @@ static void run_single_capture(inference_result_t *result)
            CLASS_NAMES[result->predicted_class], 
            result->confidence_percent);
 
-#ifdef SERIAL_STREAM_ENABLE
+#if CAMERA_RATE_ADAPT_ENABLE
+    camera_utils_rate_get(&rate);
+    printf("Camera clock: %u kHz / %u (%u overflowed frames)\n\n",
+           (unsigned)(rate.freq / 1000), (unsigned)(rate.prescaler + 1),
+           (unsigned)rate.overflow_frames);
+#endif
+
+#if CAPTURE_LOG_ENABLE
+    /* Keep the capture for a later offload; full pages go to flash now */
+    if (capture_log_append(&input_view, capture_count, result) != CAPTURE_LOG_OK) {
+        printf("Capture log write failed\n");
+    }
+    while (capture_log_service()) {
+        /* write */
+    }
+#endif
+
+#if SERIAL_STREAM_ENABLE
     /* Send result info for Python script */
     serial_print_capture_info(capture_count, 
                               CLASS_NAMES[result->predicted_class],
@@ -238,153 +826,410 @@ static void run_single_capture(inference_result_t *result)
 
     /* Stream the image to PC */
     printf("Streaming image to PC...\n");
+    PROFILE_BEGIN(PROFILE_STAGE_SERIAL);
+#if SERIAL_STREAM_BINARY
+    serial_stream_frame_view(&input_view, capture_count, SERIAL_STREAM_PIXFMT);
+#else
     serial_send_image_start(IMAGE_SIZE_X, IMAGE_SIZE_Y, capture_count);
     serial_stream_ppm(input_buffer, IMAGE_SIZE_X, IMAGE_SIZE_Y);
     serial_send_image_end();
+#endif
+    PROFILE_END(PROFILE_STAGE_SERIAL);
     printf("Image sent! Use Python script to capture.\n");
 #endif
 
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     /* Display results on TFT */
     for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
         confidences[i] = (1000 * result->softmax[i] + 0x4000) >> 15;
         confidences[i] = confidences[i] / 10;
     }
+    PROFILE_BEGIN(PROFILE_STAGE_TFT);
     tft_utils_show_results(CLASS_NAMES, confidences, CNN_NUM_OUTPUTS, result->predicted_class);
+    PROFILE_END(PROFILE_STAGE_TFT);
 #endif
 
 #if ASCII_ART_ENABLE
     /* Display ASCII art preview */
-    display_ascii_art_from_cnn(input_buffer, IMAGE_SIZE_X, IMAGE_SIZE_Y, 
-                                ASCII_ART_RATIO);
+    display_ascii_art_view(&input_view, ASCII_ART_RATIO);
+#endif
+
+    PROFILE_END(PROFILE_STAGE_FRAME);
+#if PROFILE_ENABLE
+    profile_dump();
 #endif
 }
 
 #if LIVE_FEED_ENABLE
+/** Live feed states, advanced by scheduler events */
+typedef enum {
+    LIVE_WAIT_TICK = 0,     /* Sleep until the next frame period (or exit) */
+    LIVE_CAPTURE,           /* Capture while rows stream into the CNN */
+    LIVE_WAIT_CNN,          /* Sleep until the CNN interrupt */
+    LIVE_WAIT_UPLOAD,       /* Sleep until the previous upload has drained */
+    LIVE_PRESENT,           /* Show the result, queue the upload */
+    LIVE_EXIT
+} live_state_t;
+
+static void on_cnn_done(void)
+{
+    sched_post(SCHED_EVT_CNN_DONE);
+}
+
+#if LIVE_FEED_UPLOAD
+static void on_upload_drained(void)
+{
+    sched_post(SCHED_EVT_TX_DONE);
+}
+#endif
+
+/**
+ * @brief   Show one live feed result on the TFT or console.
+ */
+static void show_live_result(const inference_result_t *result, int frame_count,
+                             const cam_rate_status_t *rate)
+{
+#if MOTION_GATE_ENABLE
+    motion_stats_t motion;
+
+    motion_get_stats(&motion);
+#endif
+#if TFT_ENABLE
+    int confidences[CNN_NUM_OUTPUTS];
+    char buf[32];
+
+    /* Display results on TFT below the image */
+    for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
+        confidences[i] = (1000 * result->softmax[i] + 0x4000) >> 15;
+        confidences[i] = confidences[i] / 10;
+    }
+    
+    /* Show frame count */
+    snprintf(buf, sizeof(buf), "Frame: %d %u.%u fps  ", frame_count,
+             (unsigned)(rate->fps_x100 / 100), (unsigned)(rate->fps_x100 / 10 % 10));
+    tft_utils_overlay_text(140, 10, buf, TFT_WHITE, TFT_BLACK);
+    
+    /* Show prediction with highlight */
+    snprintf(buf, sizeof(buf), ">> %s: %d%% <<", 
+             CLASS_NAMES[result->predicted_class], 
+             result->confidence_percent);
+    tft_utils_overlay_text(140, 40, buf, TFT_YELLOW, TFT_BLACK);
+    
+    /* Show all class confidences */
+    for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
+        uint16_t color = (i == result->predicted_class) ? TFT_GREEN : TFT_WHITE;
+        snprintf(buf, sizeof(buf), "%s: %d%%  ", CLASS_NAMES[i], confidences[i]);
+        tft_utils_overlay_text(140, 70 + (i * 20), buf, color, TFT_BLACK);
+    }
+
+#if MOTION_GATE_ENABLE
+    /* Show skipped (static) frames */
+    snprintf(buf, sizeof(buf), "Skip: %u/%u  ", (unsigned)motion.skipped,
+             (unsigned)motion.frames);
+    tft_utils_overlay_text(140, 70 + (CNN_NUM_OUTPUTS * 20) + 10, buf, TFT_WHITE, TFT_BLACK);
+#endif
+#else
+    /* Move cursor to top-left for console display */
+    clear_screen();
+
+    /* Show frame info and prediction */
+    printf("[LIVE] Frame: %d | %u.%u fps | %s (%d%%)   \n", 
+           frame_count,
+           (unsigned)(rate->fps_x100 / 100), (unsigned)(rate->fps_x100 / 10 % 10),
+           CLASS_NAMES[result->predicted_class], 
+           result->confidence_percent);
+    
+    /* Show confidence bar */
+    printf("[");
+    for (int i = 0; i < 20; i++) {
+        if (i < result->confidence_percent / 5) {
+            putchar('#');
+        } else {
+            putchar('-');
+        }
+    }
+    printf("] ");
+    
+    /* Show which class with indicator */
+    for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
+        int conf = (1000 * result->softmax[i] + 0x4000) >> 15;
+        conf = conf / 10;
+        if (i == result->predicted_class) {
+            printf(">>%s:%d%% ", CLASS_NAMES[i], conf);
+        } else {
+            printf("  %s:%d%% ", CLASS_NAMES[i], conf);
+        }
+    }
+    printf("\n");
+
+#if MOTION_GATE_ENABLE
+    printf("Skipped: %u of %u frames (change %u blocks, diff %u)   \n",
+           (unsigned)motion.skipped, (unsigned)motion.frames,
+           (unsigned)motion.last_blocks, (unsigned)motion.last_sad);
+#endif
+    printf("\n");
+
+#if ASCII_ART_ENABLE
+    /* Display ASCII art preview, redrawing only what changed */
+    display_ascii_art_frame(&input_view, ASCII_ART_RATIO, DISPLAY_ART_DIFF);
+#endif
+
+    printf("\n[Press PB1 to exit live feed]");
+#endif
+}
+
 /**
  * @brief   Run live feed mode with continuous capture.
+ *
+ * Frames start on SCHED_EVT_FRAME_TICK every LIVE_FEED_FRAME_PERIOD_MS (or
+ * back to back when 0). Between events the core sleeps in WFI: during
+ * capture between camera rows, then until the CNN and UART DMA interrupts.
  */
 static void run_live_feed(void)
 {
     inference_result_t result;
     cam_status_t cam_ret;
     int frame_count = 0;
-#ifdef TFT_ENABLE
-    int confidences[CNN_NUM_OUTPUTS];
-    char buf[32];
+    cam_rate_status_t rate = { 0 };
+    live_state_t state = LIVE_WAIT_TICK;
+    uint32_t events;
+    int skipped = 0;
+#if MOTION_GATE_ENABLE
+    motion_stats_t motion;
+#endif
+#if TRACKER_ENABLE
+    result_tracker_t tracker;
+#endif
+#if LIVE_FEED_GOVERNOR
+    uint32_t frame_start = 0;
+    power_profile_t next_profile = power_profile_get();
 #endif
 
     printf("\n=== LIVE FEED MODE ===\n");
     printf("Press PB1 (SW1) to exit live feed\n\n");
     MXC_Delay(MXC_DELAY_SEC(1));
 
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     /* Clear TFT screen */
     tft_utils_clear(TFT_BLACK);
 #else
     /* Clear terminal screen */
     printf("\033[2J");  /* ANSI clear screen */
+#if ASCII_ART_ENABLE
+    display_ascii_art_reset();
 #endif
-    
-    while (1) {
-        /* Check for button press to exit */
-        if (check_button_press()) {
-            printf("\n\nExiting live feed mode...\n");
-            MXC_Delay(MXC_DELAY_MSEC(500));  /* Debounce */
+#endif
+
+    /* Drop the press that selected this mode */
+    sched_take(SCHED_EVT_BUTTON);
+#if SERIAL_STREAM_ENABLE && SERIAL_LIVE_DELTA_ENABLE
+    /* The host starts from a keyframe */
+    serial_stream_live_reset();
+#endif
+#if MOTION_GATE_ENABLE
+    /* The first frame is always inferred */
+    motion_invalidate();
+#endif
+#if TRACKER_ENABLE
+    tracker_init(&tracker);
+#endif
+    sched_set_frame_period(LIVE_FEED_FRAME_PERIOD_MS);
+
+    while (state != LIVE_EXIT) {
+        switch (state) {
+        case LIVE_WAIT_TICK:
+#if CAPTURE_LOG_ENABLE
+            /* Write logged pages to flash until the next frame is due */
+            while (sched_peek(SCHED_EVT_FRAME_TICK | SCHED_EVT_BUTTON) == 0 &&
+                   capture_log_service()) {
+                /* write */
+            }
+#endif
+#if LIVE_FEED_FRAME_PERIOD_MS > 0
+            events = sched_wait(SCHED_EVT_FRAME_TICK | SCHED_EVT_BUTTON);
+#else
+            events = sched_take(SCHED_EVT_BUTTON);
+#endif
+#if LIVE_FEED_GOVERNOR
+            if (next_profile != power_profile_get()) {
+                /* Clocks change with no DMA or capture in flight */
+#if LIVE_FEED_UPLOAD
+                serial_stream_async_complete();
+#endif
+#if !CAPTURE_FIFO_STREAM_ENABLE
+                drop_prefetched_frame();
+#endif
+                power_profile_select(next_profile);
+            }
+#endif
+            state = (events & SCHED_EVT_BUTTON) ? LIVE_EXIT : LIVE_CAPTURE;
             break;
-        }
 
-        /* Capture image from camera */
-        cam_ret = camera_utils_capture(input_buffer, INPUT_WORDS, data565, DATA565_SIZE);
-        if (cam_ret == CAM_STATUS_OVERFLOW) {
-            printf("Camera overflow!\n");
-            continue;
-        }
+        case LIVE_CAPTURE:
+            PROFILE_BEGIN(PROFILE_STAGE_FRAME);
+#if LIVE_FEED_GOVERNOR
+            frame_start = profile_now();
+#endif
+            sched_take(SCHED_EVT_CNN_DONE);
 
-#ifdef TFT_ENABLE
-        /* Display live camera feed on TFT */
-        tft_utils_display_cnn_buffer(0, 0, IMAGE_SIZE_X, IMAGE_SIZE_Y, input_buffer);
+            /* Capture image from camera and feed the CNN */
+            cam_ret = capture_and_infer(&skipped);
+#if CAMERA_RATE_ADAPT_ENABLE
+            camera_utils_rate_update(cam_ret);
+#endif
+            if (cam_ret != CAM_STATUS_OK) {
+#if !LIVE_FEED_UPLOAD
+                /* (with an upload in flight the console belongs to the DMA) */
+                if (cam_ret == CAM_STATUS_OVERFLOW) {
+                    printf("Camera overflow!\n");
+                }
 #endif
+                state = LIVE_WAIT_TICK;
+                break;
+            }
 
-        /* Start CNN and load input data */
-        inference_start();
-        inference_load_input(input_buffer, INPUT_WORDS);
+#if TFT_ENABLE && FRAME_STAGED
+            /* Display live camera feed on TFT while the CNN finishes */
+            PROFILE_BEGIN(PROFILE_STAGE_TFT);
+            tft_utils_display_cnn_buffer(0, 0, IMAGE_SIZE_X, IMAGE_SIZE_Y, input_buffer);
+            PROFILE_END(PROFILE_STAGE_TFT);
+#endif
+            if (skipped) {
+                /* Static scene: keep the last result */
+                frame_count++;
+                state = LIVE_FEED_UPLOAD ? LIVE_WAIT_UPLOAD : LIVE_PRESENT;
+            } else {
+                state = LIVE_WAIT_CNN;
+            }
+            break;
 
-        /* Wait for inference to complete */
-        if (inference_wait(&result) != INFERENCE_OK) {
-            continue;
-        }
+        case LIVE_WAIT_CNN:
+#if !CAPTURE_FIFO_STREAM_ENABLE && FRAME_POOL_SLOTS > 1
+            /* Capture the next frame while the CNN works on this one */
+            prefetch_frame();
+#endif
+            if (!inference_is_done()) {
+                sched_wait(SCHED_EVT_CNN_DONE);
+            }
+            /* Softmax is computed when the result is presented */
+            if (inference_wait_mode(&result, INFERENCE_RESULT_LOGITS) != INFERENCE_OK) {
+                state = LIVE_WAIT_TICK;
+                break;
+            }
+#if FAST_PATH_ENABLE
+            if (escalate_if_unsure(&result, INFERENCE_RESULT_LOGITS) != INFERENCE_OK) {
+                state = LIVE_WAIT_TICK;
+                break;
+            }
+#endif
+#if POWER_PROFILE_ENABLE
+            power_profile_record(result.inference_time_us);
+#endif
+#if TRACKER_ENABLE
+            /* Show the smoothed result instead of the single frame */
+            inference_compute_confidence(&result);
+            tracker_update(&tracker, &result);
+            tracker_get_result(&tracker, &result, &result);
+#endif
 
-        frame_count++;
+            frame_count++;
+#if CAMERA_RATE_ADAPT_ENABLE
+            camera_utils_rate_get(&rate);
+#endif
+            state = LIVE_FEED_UPLOAD ? LIVE_WAIT_UPLOAD : LIVE_PRESENT;
+            break;
 
-#ifdef TFT_ENABLE
-        /* Display results on TFT below the image */
-        for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
-            confidences[i] = (1000 * result.softmax[i] + 0x4000) >> 15;
-            confidences[i] = confidences[i] / 10;
-        }
-        
-        /* Show frame count */
-        snprintf(buf, sizeof(buf), "Frame: %d", frame_count);
-        tft_utils_print(140, 10, buf, TFT_WHITE, TFT_BLACK);
-        
-        /* Show prediction with highlight */
-        snprintf(buf, sizeof(buf), ">> %s: %d%% <<", 
-                 CLASS_NAMES[result.predicted_class], 
-                 result.confidence_percent);
-        tft_utils_print(140, 40, buf, TFT_YELLOW, TFT_BLACK);
-        
-        /* Show all class confidences */
-        for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
-            uint16_t color = (i == result.predicted_class) ? TFT_GREEN : TFT_WHITE;
-            snprintf(buf, sizeof(buf), "%s: %d%%  ", CLASS_NAMES[i], confidences[i]);
-            tft_utils_print(140, 70 + (i * 20), buf, color, TFT_BLACK);
-        }
-#else
-        /* Move cursor to top-left for console display */
-        clear_screen();
-
-        /* Show frame info and prediction */
-        printf("[LIVE] Frame: %d | %s (%d%%)\n", 
-               frame_count,
-               CLASS_NAMES[result.predicted_class], 
-               result.confidence_percent);
-        
-        /* Show confidence bar */
-        printf("[");
-        for (int i = 0; i < 20; i++) {
-            if (i < result.confidence_percent / 5) {
-                putchar('#');
-            } else {
-                putchar('-');
+        case LIVE_WAIT_UPLOAD:
+#if LIVE_FEED_UPLOAD
+            /* Previous frame must be off the wire before the console is used */
+            if (serial_stream_async_poll() == STREAM_ASYNC_BUSY) {
+                sched_wait(SCHED_EVT_TX_DONE);
             }
-        }
-        printf("] ");
-        
-        /* Show which class with indicator */
-        for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
-            int conf = (1000 * result.softmax[i] + 0x4000) >> 15;
-            conf = conf / 10;
-            if (i == result.predicted_class) {
-                printf(">>%s:%d%% ", CLASS_NAMES[i], conf);
-            } else {
-                printf("  %s:%d%% ", CLASS_NAMES[i], conf);
+            serial_stream_async_complete();
+#endif
+            state = LIVE_PRESENT;
+            break;
+
+        case LIVE_PRESENT:
+            inference_compute_confidence(&result);
+            show_live_result(&result, frame_count, &rate);
+#if CAPTURE_LOG_ENABLE
+            /* Static frames (motion gate) are not logged again */
+            if (!skipped) {
+                capture_log_append(&input_view, frame_count, &result);
             }
-        }
-        printf("\n\n");
+#endif
 
-#if ASCII_ART_ENABLE
-        /* Display ASCII art preview */
-        display_ascii_art_from_cnn(input_buffer, IMAGE_SIZE_X, IMAGE_SIZE_Y, 
-                                    ASCII_ART_RATIO);
+#if LIVE_FEED_UPLOAD
+            /* Upload this frame while the next one is captured and inferred */
+            sched_take(SCHED_EVT_TX_DONE);
+            PROFILE_BEGIN(PROFILE_STAGE_SERIAL);
+#if SERIAL_LIVE_DELTA_ENABLE
+            serial_stream_async_start_live(&input_view, frame_count, SERIAL_ASYNC_PIXFMT);
+#else
+            serial_stream_async_start_view(&input_view, frame_count, SERIAL_ASYNC_PIXFMT);
+#endif
+            PROFILE_END(PROFILE_STAGE_SERIAL);
+#elif SERIAL_STREAM_ENABLE && SERIAL_LIVE_DELTA_ENABLE
+            PROFILE_BEGIN(PROFILE_STAGE_SERIAL);
+            serial_stream_live_frame(&input_view, frame_count, SERIAL_LIVE_PIXFMT);
+            PROFILE_END(PROFILE_STAGE_SERIAL);
+#endif
+
+            PROFILE_END(PROFILE_STAGE_FRAME);
+#if LIVE_FEED_GOVERNOR
+            /* Applied at the next tick, before the capture starts */
+            next_profile = power_profile_govern(
+                (profile_now() - frame_start) / (SystemCoreClock / 1000000U),
+                LIVE_FEED_FRAME_PERIOD_MS * 1000U);
 #endif
+            state = LIVE_WAIT_TICK;
+            break;
+
+        default:
+            state = LIVE_EXIT;
+            break;
+        }
+    }
 
-        printf("\n[Press PB1 to exit live feed]");
+    sched_set_frame_period(0);
+#if !CAPTURE_FIFO_STREAM_ENABLE
+    drop_prefetched_frame();
 #endif
 
-        /* Small delay between frames */
-        MXC_Delay(MXC_DELAY_MSEC(LIVE_FEED_DELAY_MS));
+#if LIVE_FEED_UPLOAD
+    serial_stream_async_complete();
+#endif
+    printf("\n\nExiting live feed mode...\n");
+#if CAPTURE_LOG_ENABLE
+    {
+        capture_log_stats_t log_stats;
+
+        capture_log_flush();
+        capture_log_get_stats(&log_stats);
+        printf("Capture log: %u records, %u of %u pages used, %u stalls, %u lost pages\n",
+               (unsigned)log_stats.records, (unsigned)log_stats.used_pages,
+               (unsigned)log_stats.pages, (unsigned)log_stats.stalls,
+               (unsigned)log_stats.lost_pages);
     }
+#endif
+#if MOTION_GATE_ENABLE
+    motion_get_stats(&motion);
+    printf("Motion gate: skipped %u of %u frames\n", (unsigned)motion.skipped,
+           (unsigned)motion.frames);
+#endif
+#if FAST_PATH_ENABLE
+    printf("Fast path: %u of %u frames escalated to full resolution\n",
+           (unsigned)fast_escalated, (unsigned)fast_frames);
+#endif
+#if PROFILE_ENABLE
+    profile_dump();
+#endif
+#if POWER_PROFILE_ENABLE
+    power_profile_print();
+#endif
+    MXC_Delay(MXC_DELAY_MSEC(500));  /* Debounce */
+    sched_take(SCHED_EVT_BUTTON);
 }
 #endif /* LIVE_FEED_ENABLE */
 
@@ -402,11 +1247,17 @@ static void run_inference_loop(void)
 #if LIVE_FEED_ENABLE
         printf("\n=== MODE SELECT ===\n");
         printf("Press PB1 (SW1) briefly for SINGLE CAPTURE\n");
-        printf("Hold PB1 (SW1) for 1 sec for LIVE FEED\n\n");
+        printf("Hold PB1 (SW1) for 1 sec for LIVE FEED\n");
+#if CAPTURE_LOG_ENABLE
+        printf("Run capture_images.py --offload to download the capture log\n");
+#endif
+        printf("\n");
         
         /* Wait for button press */
         while (!check_button_press()) {
-            /* wait */
+#if CAPTURE_LOG_ENABLE
+            poll_log_command();
+#endif
         }
         
         /* Check if held for live feed mode */
@@ -441,6 +1292,43 @@ int main(void)
 
     printf("\n*** CNN Inference Test: %s ***\n", APP_NAME);
 
+#if BENCHMARK_ENABLE
+    /* Sample input only: no camera, display or serial streaming */
+    profile_init();
+    MXC_DMA_Init();
+    if (inference_init() != INFERENCE_OK) {
+        printf("CNN initialization failed! Halting.\n");
+        while (1) {
+            /* halt */
+        }
+    }
+#if POWER_PROFILE_ENABLE
+    {
+        int failed = 0;
+
+        /* Same benchmark at every profile's clocks */
+        for (int p = 0; p < POWER_PROFILE_COUNT; p++) {
+            power_profile_select((power_profile_t)p);
+            printf("\nProfile %s\n", power_profile_desc((power_profile_t)p)->name);
+            if (benchmark_run(BENCHMARK_ITERATIONS) != BENCHMARK_OK) {
+                failed = 1;
+            }
+        }
+        power_profile_print();
+        printf(failed ? "*** FAIL ***\n" : "*** PASS ***\n");
+    }
+#else
+    if (benchmark_run(BENCHMARK_ITERATIONS) == BENCHMARK_OK) {
+        printf("*** PASS ***\n");
+    } else {
+        printf("*** FAIL ***\n");
+    }
+#endif
+    while (1) {
+        /* done */
+    }
+#endif
+
     /* Initialize hardware */
     if (hardware_init() != 0) {
         printf("Hardware initialization failed! Halting.\n");
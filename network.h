@@ -0,0 +1,166 @@
+/**
+ * @file    network.h
+ * @brief   Register tables for horse-or-human_gen, @generated by tools/gen_network.py
+ *          from cnn.c and cnn.h.
+ *
+ * DO NOT EDIT - regenerate this file instead!
+ */
+
+#ifndef NETWORK_H_
+#define NETWORK_H_
+
+#define NETWORK_NAME "horse-or-human_gen"
+#define NETWORK_NUM_LAYERS 7
+#define NETWORK_NUM_REGS 350
+#define NETWORK_NUM_INIT 13
+#define NETWORK_FIFO_CTRL 0x00001908
+#define NETWORK_OUTPUT_ADDR 0x50401000
+#define NETWORK_OUTPUT_WORDS 2
+
+/* in c/h/w, out c/h/w, op, pool, pool size, kernel, ReLU, streaming,
+ * first register, register count, ops, MACs */
+#define NETWORK_LAYERS { \
+    { 3, 128, 128, 16, 128, 128, CNN_OP_CONV2D, CNN_POOL_NONE, 1, 3, 1, 1, 0, 49, 7340032U, 7077888U }, \
+    { 16, 128, 128, 32, 64, 64, CNN_OP_CONV2D, CNN_POOL_MAX, 2, 3, 1, 1, 49, 66, 19267584U, 18874368U }, \
+    { 32, 64, 64, 64, 32, 32, CNN_OP_CONV2D, CNN_POOL_MAX, 2, 3, 1, 0, 115, 50, 19070976U, 18874368U }, \
+    { 64, 32, 32, 32, 16, 16, CNN_OP_CONV2D, CNN_POOL_MAX, 2, 3, 1, 0, 165, 52, 4792320U, 4718592U }, \
+    { 32, 16, 16, 32, 8, 8, CNN_OP_CONV2D, CNN_POOL_MAX, 2, 3, 1, 0, 217, 54, 600064U, 589824U }, \
+    { 32, 8, 8, 16, 8, 8, CNN_OP_CONV2D, CNN_POOL_NONE, 1, 3, 1, 0, 271, 38, 295936U, 294912U }, \
+    { 16, 8, 8, 2, 1, 1, CNN_OP_LINEAR, CNN_POOL_NONE, 1, 1, 0, 0, 309, 41, 2048U, 2048U }, \
+}
+
+/* (quadrant << 14) | (register offset >> 2) */
+#define NETWORK_REG_ADDR { \
+    0x0004, 0x0024, 0x00c4, 0x0104, 0x0164, 0x0284, 0x0184, 0x01a4, \
+    0x01e4, 0x01c4, 0x0204, 0x0244, 0x0264, 0x4004, 0x4024, 0x40c4, \
+    0x4104, 0x4164, 0x4284, 0x4184, 0x41a4, 0x41e4, 0x4204, 0x4244, \
+    0x4264, 0x8004, 0x8024, 0x80c4, 0x8104, 0x8164, 0x8284, 0x8184, \
+    0x81a4, 0x81e4, 0x8204, 0x8244, 0x8264, 0xc004, 0xc024, 0xc0c4, \
+    0xc104, 0xc164, 0xc284, 0xc184, 0xc1a4, 0xc1e4, 0xc204, 0xc244, \
+    0xc264, 0x0005, 0x0025, 0x0065, 0x0085, 0x00a5, 0x00c5, 0x0105, \
+    0x0145, 0x0165, 0x0285, 0x0185, 0x01a5, 0x01e5, 0x0205, 0x0225, \
+    0x0245, 0x4005, 0x4025, 0x4065, 0x4085, 0x40a5, 0x40c5, 0x4105, \
+    0x4145, 0x4165, 0x4285, 0x4185, 0x41a5, 0x41e5, 0x4205, 0x4225, \
+    0x4245, 0x8005, 0x8025, 0x8065, 0x8085, 0x80a5, 0x80c5, 0x8105, \
+    0x8145, 0x8165, 0x8285, 0x8185, 0x81a5, 0x81e5, 0x81c5, 0x8205, \
+    0x8225, 0x8245, 0xc005, 0xc025, 0xc065, 0xc085, 0xc0a5, 0xc0c5, \
+    0xc105, 0xc145, 0xc165, 0xc285, 0xc185, 0xc1a5, 0xc1e5, 0xc1c5, \
+    0xc205, 0xc225, 0xc245, 0x0006, 0x0026, 0x0066, 0x0086, 0x00a6, \
+    0x0106, 0x0146, 0x0166, 0x0286, 0x0186, 0x01a6, 0x01e6, 0x01c6, \
+    0x4006, 0x4026, 0x4066, 0x4086, 0x40a6, 0x4106, 0x4146, 0x4166, \
+    0x4286, 0x4186, 0x41a6, 0x41e6, 0x41c6, 0x8006, 0x8026, 0x8066, \
+    0x8086, 0x80a6, 0x8106, 0x8146, 0x8166, 0x8286, 0x8186, 0x81a6, \
+    0x81e6, 0xc006, 0xc026, 0xc066, 0xc086, 0xc0a6, 0xc106, 0xc146, \
+    0xc166, 0xc286, 0xc186, 0xc1a6, 0xc1e6, 0x0007, 0x0027, 0x0067, \
+    0x0087, 0x00a7, 0x00c7, 0x0107, 0x0167, 0x0287, 0x0187, 0x01a7, \
+    0x01e7, 0x01c7, 0x4007, 0x4027, 0x4067, 0x4087, 0x40a7, 0x40c7, \
+    0x4107, 0x4167, 0x4287, 0x4187, 0x41a7, 0x41e7, 0x41c7, 0x8007, \
+    0x8027, 0x8067, 0x8087, 0x80a7, 0x80c7, 0x8107, 0x8167, 0x8287, \
+    0x8187, 0x81a7, 0x81e7, 0x81c7, 0xc007, 0xc027, 0xc067, 0xc087, \
+    0xc0a7, 0xc0c7, 0xc107, 0xc167, 0xc287, 0xc187, 0xc1a7, 0xc1e7, \
+    0xc1c7, 0x0008, 0x0028, 0x0068, 0x0088, 0x00a8, 0x00c8, 0x0108, \
+    0x0148, 0x0168, 0x0288, 0x0188, 0x01a8, 0x01e8, 0x01c8, 0x4008, \
+    0x4028, 0x4068, 0x4088, 0x40a8, 0x40c8, 0x4108, 0x4148, 0x4168, \
+    0x4288, 0x4188, 0x41a8, 0x41e8, 0x41c8, 0x8008, 0x8028, 0x8068, \
+    0x8088, 0x80a8, 0x80c8, 0x8108, 0x8148, 0x8168, 0x8288, 0x8188, \
+    0x81a8, 0x81e8, 0xc008, 0xc028, 0xc068, 0xc088, 0xc0a8, 0xc0c8, \
+    0xc108, 0xc148, 0xc168, 0xc288, 0xc188, 0xc1a8, 0xc1e8, 0x0009, \
+    0x0029, 0x00c9, 0x0109, 0x0169, 0x0289, 0x0189, 0x01a9, 0x01e9, \
+    0x4009, 0x4029, 0x40c9, 0x4109, 0x4169, 0x4289, 0x4189, 0x41a9, \
+    0x41e9, 0x8009, 0x8029, 0x80c9, 0x8109, 0x8169, 0x8289, 0x8189, \
+    0x81a9, 0x81e9, 0x81c9, 0xc009, 0xc029, 0xc0c9, 0xc109, 0xc169, \
+    0xc289, 0xc189, 0xc1a9, 0xc1e9, 0xc1c9, 0x00ca, 0x00ea, 0x010a, \
+    0x014a, 0x016a, 0x028a, 0x018a, 0x004a, 0x01aa, 0x01ea, 0x01ca, \
+    0x40ca, 0x40ea, 0x410a, 0x414a, 0x416a, 0x428a, 0x418a, 0x404a, \
+    0x41aa, 0x41ea, 0x80ca, 0x80ea, 0x810a, 0x814a, 0x816a, 0x828a, \
+    0x818a, 0x804a, 0x81aa, 0x81ea, 0xc0ca, 0xc0ea, 0xc10a, 0xc14a, \
+    0xc16a, 0xc28a, 0xc18a, 0xc04a, 0xc1aa, 0xc1ea, \
+}
+
+#define NETWORK_REG_VALUE { \
+    0x00010081, 0x00010081, 0x00012400, 0x00002000, 0x00000b20, 0x00007800, \
+    0x00000078, 0x0000007f, 0x00022000, 0x00070007, 0x00000001, 0x00000002, \
+    0x00004000, 0x00010081, 0x00010081, 0x00012400, 0x00002000, 0x00000b20, \
+    0x00007800, 0x00000078, 0x0000007f, 0x00022000, 0x00000001, 0x00000002, \
+    0x00004000, 0x00010081, 0x00010081, 0x00012400, 0x00002000, 0x00000b20, \
+    0x00007800, 0x00000078, 0x0000007f, 0x00022000, 0x00000001, 0x00000002, \
+    0x00004000, 0x00010081, 0x00010081, 0x00012400, 0x00002000, 0x00000b20, \
+    0x00007800, 0x00000078, 0x0000007f, 0x00022000, 0x00000001, 0x00000002, \
+    0x00004000, 0x00010081, 0x00010081, 0x00000001, 0x00000001, 0x00000001, \
+    0x00000800, 0x00002000, 0x00000400, 0x0000cba0, 0x0000f800, 0x000000f8, \
+    0x008000bf, 0x00022000, 0x0000018c, 0x00840021, 0x0000020e, 0x00010081, \
+    0x00010081, 0x00000001, 0x00000001, 0x00000001, 0x00000800, 0x00002000, \
+    0x00000400, 0x00000ba0, 0x0000f800, 0x000000f8, 0x008000bf, 0x00022000, \
+    0x0000018c, 0x00840021, 0x0000020e, 0x00010081, 0x00010081, 0x00000001, \
+    0x00000001, 0x00000001, 0x00000800, 0x00002000, 0x00000400, 0x00000ba0, \
+    0x0000f800, 0x000000f8, 0x008000bf, 0x00022000, 0xfff0fff0, 0x0000018c, \
+    0x00840021, 0x0000020e, 0x00010081, 0x00010081, 0x00000001, 0x00000001, \
+    0x00000001, 0x00000800, 0x00002000, 0x00000400, 0x00000ba0, 0x0000f800, \
+    0x000000f8, 0x008000bf, 0x00022000, 0x000f000f, 0x0000018c, 0x00840021, \
+    0x0000020e, 0x00010041, 0x00010041, 0x00000001, 0x00000001, 0x00000001, \
+    0x00002000, 0x00000800, 0x00002ba0, 0x0001f800, 0x00800278, 0x0000001f, \
+    0x00024000, 0xffffffff, 0x00010041, 0x00010041, 0x00000001, 0x00000001, \
+    0x00000001, 0x00002000, 0x00000800, 0x00000ba0, 0x0001f800, 0x00800278, \
+    0x0000001f, 0x00024000, 0xffffffff, 0x00010041, 0x00010041, 0x00000001, \
+    0x00000001, 0x00000001, 0x00002000, 0x00000800, 0x00000ba0, 0x0001f800, \
+    0x00800278, 0x0000001f, 0x00024000, 0x00010041, 0x00010041, 0x00000001, \
+    0x00000001, 0x00000001, 0x00002000, 0x00000800, 0x00000ba0, 0x0001f800, \
+    0x00800278, 0x0000001f, 0x00024000, 0x00010021, 0x00010021, 0x00000001, \
+    0x00000001, 0x00000001, 0x00000800, 0x00002000, 0x0000eba0, 0x0000f800, \
+    0x02800378, 0x0000000f, 0x00022000, 0xffffffff, 0x00010021, 0x00010021, \
+    0x00000001, 0x00000001, 0x00000001, 0x00000800, 0x00002000, 0x00000ba0, \
+    0x0000f800, 0x02800378, 0x0000000f, 0x00022000, 0xffffffff, 0x00010021, \
+    0x00010021, 0x00000001, 0x00000001, 0x00000001, 0x00000800, 0x00002000, \
+    0x00000ba0, 0x0000f800, 0x02800378, 0x0000000f, 0x00022000, 0xffffffff, \
+    0x00010021, 0x00010021, 0x00000001, 0x00000001, 0x00000001, 0x00000800, \
+    0x00002000, 0x00000ba0, 0x0000f800, 0x02800378, 0x0000000f, 0x00022000, \
+    0xffffffff, 0x00010011, 0x00010011, 0x00000001, 0x00000001, 0x00000001, \
+    0x00010000, 0x00002000, 0x00000800, 0x00002ba0, 0x0000f800, 0x03800478, \
+    0x00000007, 0x00022000, 0xffffffff, 0x00010011, 0x00010011, 0x00000001, \
+    0x00000001, 0x00000001, 0x00010000, 0x00002000, 0x00000800, 0x00000ba0, \
+    0x0000f800, 0x03800478, 0x00000007, 0x00022000, 0xffffffff, 0x00010011, \
+    0x00010011, 0x00000001, 0x00000001, 0x00000001, 0x00010000, 0x00002000, \
+    0x00000800, 0x00000ba0, 0x0000f800, 0x03800478, 0x00000007, 0x00022000, \
+    0x00010011, 0x00010011, 0x00000001, 0x00000001, 0x00000001, 0x00010000, \
+    0x00002000, 0x00000800, 0x00000ba0, 0x0000f800, 0x03800478, 0x00000007, \
+    0x00022000, 0x00010009, 0x00010009, 0x00000800, 0x00002000, 0x0000cb20, \
+    0x00007800, 0x01000178, 0x00000007, 0x00022000, 0x00010009, 0x00010009, \
+    0x00000800, 0x00002000, 0x00000b20, 0x00007800, 0x01000178, 0x00000007, \
+    0x00022000, 0x00010009, 0x00010009, 0x00000800, 0x00002000, 0x00000b20, \
+    0x00007800, 0x01000178, 0x00000007, 0x00022000, 0xffffffff, 0x00010009, \
+    0x00010009, 0x00000800, 0x00002000, 0x00000b20, 0x00007800, 0x01000178, \
+    0x00000007, 0x00022000, 0xffffffff, 0x00000400, 0x00000001, 0x00002000, \
+    0x00000800, 0x00010920, 0x0000080f, 0x28802c78, 0x00000100, 0x003f007f, \
+    0x080e7000, 0xffffffff, 0x00000400, 0x00000001, 0x00002000, 0x00000800, \
+    0x00010920, 0x0000080f, 0x28802c78, 0x00000100, 0x003f007f, 0x080e6000, \
+    0x00000400, 0x00000001, 0x00002000, 0x00000800, 0x00010920, 0x0000080f, \
+    0x28802c78, 0x00000100, 0x003f007f, 0x080e6000, 0x00000400, 0x00000001, \
+    0x00002000, 0x00000800, 0x00010920, 0x0000080f, 0x28802c78, 0x00000100, \
+    0x003f007f, 0x080e6000, \
+}
+
+/* cnn_init(): address, value */
+#define NETWORK_INIT { \
+    0x50001000, 0x00000000, \
+    0x50100000, 0x00108008, \
+    0x50100004, 0x0000040e, \
+    0x50100008, 0x00000006, \
+    0x50500000, 0x00108008, \
+    0x50500004, 0x0000040e, \
+    0x50500008, 0x00000006, \
+    0x50900000, 0x00108008, \
+    0x50900004, 0x0000040e, \
+    0x50900008, 0x00000006, \
+    0x50d00000, 0x00108008, \
+    0x50d00004, 0x0000040e, \
+    0x50d00008, 0x00000006, \
+}
+
+/* cnn_load_bias(): {address, count, bytes...} records, zero terminated */
+#define NETWORK_BIAS { \
+    0x50108000, 2, \
+    0x0e, 0xeb, \
+    0 \
+}
+
+#endif /* NETWORK_H_ */
@@ -14,3 +14,9 @@ VPATH += src
 
 # Include additional header directories
 IPATH += include
+
+# Camera-free benchmark on sampledata.h ("make BENCHMARK=1")
+BENCHMARK ?= 0
+ifeq ($(BENCHMARK),1)
+PROJ_CFLAGS += -DBENCHMARK_ENABLE=1
+endif
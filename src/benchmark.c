@@ -0,0 +1,401 @@
+/**
+ * @file    benchmark.c
+ * @brief   Camera-free inference benchmark implementation for MAX78000 projects.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+/* Platform headers - must come before cnn.h */
+#include "mxc.h"
+
+#include "benchmark.h"
+#include "camera_utils.h"
+#include "inference_utils.h"
+#include "cnn_network.h"
+#include "serial_stream.h"
+#include "profile.h"
+#include "app_config.h"
+#if POWER_PROFILE_ENABLE
+#include "power_profile.h"
+#endif
+#include "cnn.h"
+
+#if BENCHMARK_ENABLE
+
+/* Known-answer test vectors (auto-generated) */
+#include "sampledata.h"
+#include "sampleoutput.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define BENCHMARK_MARKER    "<<<BENCHMARK>>>"
+
+/** Width of the longest histogram bar */
+#define HIST_BAR_WIDTH      40
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const uint32_t s_input[] = SAMPLE_INPUT_0;
+static const uint32_t s_expected[] = SAMPLE_OUTPUT;
+
+/* End-to-end latency of each iteration in cycles */
+static uint32_t s_latency[BENCHMARK_ITERATIONS];
+
+/* Batch pass: every frame is the sample input */
+static const uint32_t *s_batch_inputs[BENCHMARK_ITERATIONS];
+static inference_result_t s_batch_results[BENCHMARK_ITERATIONS];
+
+/* Camera row for the capture conversion timing, and its outputs */
+static uint32_t s_sensor_row[IMAGE_SIZE_X];
+static uint32_t s_convert_cnn[IMAGE_SIZE_X];
+static uint8_t s_convert_rgb565[2 * IMAGE_SIZE_X];
+
+/** Min/avg/max of a timed span in cycles */
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t count;
+} span_stats_t;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/**
+ * @brief   Compare CNN output memory with SAMPLE_OUTPUT.
+ *
+ * SAMPLE_OUTPUT is a list of {address, mask, count, values...} records
+ * terminated by a zero address.
+ *
+ * @return  1 when all words match, 0 otherwise.
+ */
+static int check_output(void)
+{
+    const uint32_t *ptr = s_expected;
+    volatile uint32_t *addr;
+    uint32_t mask, len, i;
+
+    while ((addr = (volatile uint32_t *)*ptr++) != 0) {
+        mask = *ptr++;
+        len = *ptr++;
+        for (i = 0; i < len; i++) {
+            if ((*addr & mask) != *ptr) {
+                printf("Mismatch at 0x%08x: 0x%08x, expected 0x%08x\n",
+                       (unsigned)(uintptr_t)addr, (unsigned)(*addr & mask), (unsigned)*ptr);
+                return 0;
+            }
+            addr++;
+            ptr++;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief   CRC32 of the network's kernel records as loaded into the CNN.
+ *
+ * @param   net     Network descriptor.
+ * @param   words   Receives the number of kernel words.
+ */
+static uint32_t kernels_crc(const cnn_network_t *net, uint32_t *words)
+{
+    const uint32_t *ptr = net->kernels;
+    uint32_t crc = 0;
+    uint32_t len;
+
+    *words = 0;
+    if (ptr == NULL) {
+        return 0;
+    }
+    while (ptr[0] != 0) {
+        len = ptr[1];
+        crc = serial_crc32(crc, (const uint8_t *)ptr, (2 + len) * sizeof(uint32_t));
+        *words += len;
+        ptr += 2 + len;
+    }
+
+    return crc;
+}
+
+/**
+ * @brief   Read the bias memory back and compare it with the network's records.
+ *
+ * Kernel memory is written through a packing address register and can not be
+ * read back word for word; the known-answer output covers the kernels.
+ *
+ * @return  Number of bias bytes that differ.
+ */
+static int check_bias(const cnn_network_t *net)
+{
+    const uint32_t *ptr = net->bias;
+    volatile uint32_t *addr;
+    uint32_t len;
+    int errors = 0;
+
+    if (ptr == NULL) {
+        return 0;
+    }
+    while ((addr = (volatile uint32_t *)*ptr++) != 0) {
+        len = *ptr++;
+        while (len-- > 0) {
+            if ((*addr & 0xFFU) != (*ptr & 0xFFU)) {
+                if (errors == 0) {
+                    printf("Bias mismatch at 0x%08x: 0x%02x, expected 0x%02x\n",
+                           (unsigned)(uintptr_t)addr, (unsigned)(*addr & 0xFFU),
+                           (unsigned)(*ptr & 0xFFU));
+                }
+                errors++;
+            }
+            addr++;
+            ptr++;
+        }
+    }
+
+    return errors;
+}
+
+static void span_add(span_stats_t *span, uint32_t cycles)
+{
+    if (span->count == 0 || cycles < span->min) {
+        span->min = cycles;
+    }
+    if (cycles > span->max) {
+        span->max = cycles;
+    }
+    span->total += cycles;
+    span->count++;
+}
+
+static void span_print(const char *name, const span_stats_t *span, uint32_t cycles_per_us)
+{
+    printf("%s: min %u avg %u max %u\n", name, (unsigned)(span->min / cycles_per_us),
+           (unsigned)(span->total / span->count / cycles_per_us),
+           (unsigned)(span->max / cycles_per_us));
+}
+
+/**
+ * @brief   Time the capture conversion of one frame, IMAGE_SIZE_Y rows through
+ *          camera_utils_convert_row(), once per iteration.
+ *
+ * @param   rgb565  Also write the RGB565 copy (MEMORY_LAYOUT_LEGACY path).
+ */
+static void time_conversion(int n, int rgb565, span_stats_t *span)
+{
+    uint32_t t0;
+    uint32_t cycles;
+    int i, y;
+
+    for (i = 0; i < n; i++) {
+        t0 = profile_now();
+        for (y = 0; y < IMAGE_SIZE_Y; y++) {
+            camera_utils_convert_row((const uint8_t *)s_sensor_row, IMAGE_SIZE_X, s_convert_cnn,
+                                     IMAGE_SIZE_X, rgb565 ? s_convert_rgb565 : NULL,
+                                     rgb565 ? IMAGE_SIZE_X : 0);
+        }
+        cycles = profile_now() - t0;
+
+        span_add(span, cycles);
+        if (!rgb565) {
+            profile_record(PROFILE_STAGE_CONVERT, cycles);
+        }
+    }
+}
+
+/**
+ * @brief   Run all iterations as one batch and return its cycle count.
+ *
+ * @return  Cycles for the batch, 0 on error or if a result differs from
+ *          the single-frame reference.
+ */
+static uint32_t run_batch(int n, const inference_result_t *reference)
+{
+    uint32_t t0;
+    uint32_t cycles;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        s_batch_inputs[i] = s_input;
+    }
+
+    t0 = profile_now();
+    if (inference_run_batch(s_batch_inputs, n, INPUT_WORDS, s_batch_results,
+                            INFERENCE_RESULT_LOGITS) != INFERENCE_OK) {
+        return 0;
+    }
+    cycles = profile_now() - t0;
+
+    for (i = 0; i < n; i++) {
+        if (memcmp(s_batch_results[i].raw_output, reference->raw_output,
+                   sizeof(reference->raw_output)) != 0) {
+            printf("Batch frame %d differs from single-frame output\n", i);
+            return 0;
+        }
+    }
+
+    return cycles;
+}
+
+/**
+ * @brief   Print a latency histogram of BENCHMARK_HIST_BINS equal bins.
+ */
+static void print_histogram(int n, uint32_t min, uint32_t max, uint32_t cycles_per_us)
+{
+    uint32_t bins[BENCHMARK_HIST_BINS];
+    uint32_t width = (max - min) / BENCHMARK_HIST_BINS + 1;
+    uint32_t peak = 0;
+    int i, k;
+
+    memset(bins, 0, sizeof(bins));
+    for (i = 0; i < n; i++) {
+        bins[(s_latency[i] - min) / width]++;
+    }
+    for (i = 0; i < BENCHMARK_HIST_BINS; i++) {
+        if (bins[i] > peak) {
+            peak = bins[i];
+        }
+    }
+
+    printf("histogram (us):\n");
+    for (i = 0; i < BENCHMARK_HIST_BINS; i++) {
+        printf("  %6u-%-6u %4u |", (unsigned)((min + i * width) / cycles_per_us),
+               (unsigned)((min + (i + 1) * width - 1) / cycles_per_us), (unsigned)bins[i]);
+        for (k = 0; k < (int)(bins[i] * HIST_BAR_WIDTH / peak); k++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+}
+
+benchmark_status_t benchmark_run(int iterations)
+{
+    const cnn_network_t *net = inference_get_network();
+    inference_result_t result;
+    span_stats_t convert = { 0 };
+    span_stats_t convert565 = { 0 };
+    span_stats_t fifo = { 0 };
+    uint32_t weights_crc;
+    uint32_t weights_words;
+    int bias_errors;
+    uint32_t t1;
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    uint32_t min = 0xFFFFFFFFU;
+    uint32_t max = 0;
+    uint64_t total = 0;
+    uint64_t cnn_us_total = 0;
+    uint32_t avg_us;
+    uint32_t ips_x100;
+    uint32_t mwords_x100;
+    uint32_t t0;
+    uint32_t batch_cycles;
+    int failures = 0;
+    int i;
+
+    if (iterations < 1 || iterations > BENCHMARK_ITERATIONS) {
+        return BENCHMARK_ERROR;
+    }
+    if (cycles_per_us == 0) {
+        cycles_per_us = 1;
+    }
+
+    printf("Benchmark: %d inferences on sample input\n", iterations);
+    profile_reset();
+
+    /* Weights as built, biases as held by the CNN */
+    weights_crc = kernels_crc(net, &weights_words);
+    bias_errors = check_bias(net);
+
+    /* Sample pixels back in camera format */
+    for (i = 0; i < IMAGE_SIZE_X; i++) {
+        s_sensor_row[i] = s_input[i] ^ 0x00808080U;
+    }
+    time_conversion(iterations, 0, &convert);
+    time_conversion(iterations, 1, &convert565);
+
+    for (i = 0; i < iterations; i++) {
+        t0 = profile_now();
+        inference_start();
+        t1 = profile_now();
+        inference_load_input(s_input, INPUT_WORDS);
+        t1 = profile_now() - t1;
+        if (inference_wait(&result) != INFERENCE_OK) {
+            return BENCHMARK_ERROR;
+        }
+        s_latency[i] = profile_now() - t0;
+        profile_record(PROFILE_STAGE_FIFO_LOAD, t1);
+        span_add(&fifo, t1);
+
+        /* Output stays in CNN memory until the next start */
+        if (!check_output()) {
+            failures++;
+        }
+
+        if (s_latency[i] < min) {
+            min = s_latency[i];
+        }
+        if (s_latency[i] > max) {
+            max = s_latency[i];
+        }
+        total += s_latency[i];
+        cnn_us_total += result.inference_time_us;
+#if POWER_PROFILE_ENABLE
+        power_profile_record(result.inference_time_us);
+#endif
+    }
+
+    /* Stages of the single-frame runs (the batch below would mix in) */
+    profile_dump();
+
+    batch_cycles = run_batch(iterations, &result);
+
+    avg_us = (uint32_t)(total / iterations / cycles_per_us);
+    ips_x100 = (uint32_t)((uint64_t)iterations * 100000000U * cycles_per_us / total);
+
+    printf("\n%s\n", BENCHMARK_MARKER);
+    printf("iterations: %d\n", iterations);
+    printf("mismatches: %d\n", failures);
+    printf("bias_mismatches: %d\n", bias_errors);
+    printf("weights_crc32: 0x%08x\n", (unsigned)weights_crc);
+    printf("weights_words: %u\n", (unsigned)weights_words);
+    printf("clock_mhz: %u\n", (unsigned)cycles_per_us);
+    printf("network_ops: %u\n", (unsigned)cnn_network_ops(net));
+    printf("throughput_ips: %u.%02u\n", (unsigned)(ips_x100 / 100), (unsigned)(ips_x100 % 100));
+    printf("latency_us: min %u avg %u max %u\n", (unsigned)(min / cycles_per_us),
+           (unsigned)avg_us, (unsigned)(max / cycles_per_us));
+    printf("cnn_us_avg: %u\n", (unsigned)(cnn_us_total / iterations));
+    span_print("convert_us", &convert, cycles_per_us);
+    span_print("convert_rgb565_us", &convert565, cycles_per_us);
+    span_print("fifo_load_us", &fifo, cycles_per_us);
+    /* Words per us = Mwords/s */
+    mwords_x100 = (uint32_t)((uint64_t)INPUT_WORDS * fifo.count * 100U * cycles_per_us /
+                             fifo.total);
+    printf("fifo_load_mwords_s: %u.%02u\n", (unsigned)(mwords_x100 / 100),
+           (unsigned)(mwords_x100 % 100));
+    if (batch_cycles > 0) {
+        ips_x100 = (uint32_t)((uint64_t)iterations * 100000000U * cycles_per_us / batch_cycles);
+        printf("batch_ips: %u.%02u\n", (unsigned)(ips_x100 / 100), (unsigned)(ips_x100 % 100));
+    } else {
+        printf("batch_ips: n/a (batch failed)\n");
+        failures++;
+    }
+#if BENCHMARK_POWER_MW > 0
+    /* mW * us = nJ */
+    printf("energy_uj: %u.%03u (at %u mW)\n",
+           (unsigned)(BENCHMARK_POWER_MW * avg_us / 1000U),
+           (unsigned)(BENCHMARK_POWER_MW * avg_us % 1000U), (unsigned)BENCHMARK_POWER_MW);
+#else
+    printf("energy_uj: n/a (set BENCHMARK_POWER_MW)\n");
+#endif
+    print_histogram(iterations, min, max, cycles_per_us);
+    printf("%s\n\n", BENCHMARK_MARKER);
+
+    return (failures == 0 && bias_errors == 0) ? BENCHMARK_OK : BENCHMARK_MISMATCH;
+}
+
+#endif /* BENCHMARK_ENABLE */
@@ -7,6 +7,9 @@
 #include <string.h>
 
 #include "camera_utils.h"
+#include "inference_utils.h"
+#include "profile.h"
+#include "scheduler.h"
 #include "app_config.h"
 
 /* Platform headers */
@@ -14,17 +17,271 @@
 #include "camera.h"
 #include "led.h"
 
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Camera stream buffers hold one pixel per word as 0x00BBGGRR */
+#define CNN_PIXEL_MASK      0x00FFFFFFU
+#define CNN_PIXEL_OFFSET    0x00808080U
+
+/* Sensor clock prescaler register: internal clock = XCLK / (value + 1) */
+#define CAMERA_REG_CLKRC    0x11
+
+/* Sensor array window (OV7692): start and size MSBs, horizontal in units of
+ * 4 pixels, vertical in units of 2 lines, from the origin of the active
+ * 640x480 array at (CAMERA_HSTART_BASE, CAMERA_VSTART_BASE) */
+#ifndef CAMERA_REG_HSTART
+#define CAMERA_REG_HSTART   0x17
+#define CAMERA_REG_HSIZE    0x18
+#define CAMERA_REG_VSTART   0x19
+#define CAMERA_REG_VSIZE    0x1A
+#define CAMERA_HSTART_BASE  0x69
+#define CAMERA_VSTART_BASE  0x0C
+#endif
+#define SENSOR_WIDTH        640
+#define SENSOR_HEIGHT       480
+
+/** One capture rate: camera clock and sensor prescaler */
+typedef struct {
+    uint32_t freq;
+    uint8_t  prescaler;
+} rate_level_t;
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 
 static uint32_t s_image_width  = 0;
 static uint32_t s_image_height = 0;
+static int s_dma_channel = -1;
+
+/* Capture rates, fastest first (effective sensor clock in the comment) */
+static const rate_level_t s_rate_levels[] = {
+    { 12 * 1000 * 1000, 0 },    /* 12 MHz */
+    { 10 * 1000 * 1000, 0 },    /* 10 MHz */
+    {  8 * 1000 * 1000, 0 },    /*  8 MHz */
+    {  5 * 1000 * 1000, 0 },    /*  5 MHz */
+    {  5 * 1000 * 1000, 1 },    /*  2.5 MHz */
+    {  5 * 1000 * 1000, 3 }     /*  1.25 MHz */
+};
+#define NUM_RATE_LEVELS     ((int)(sizeof(s_rate_levels) / sizeof(s_rate_levels[0])))
+
+/* Rate controller state */
+static int s_rate_level = NUM_RATE_LEVELS - 1;
+static uint32_t s_current_freq = 0;
+static uint32_t s_clean_frames = 0;
+static uint32_t s_overflow_frames = 0;
+static uint8_t s_level_failures[NUM_RATE_LEVELS];
+static uint32_t s_last_frame_cycles = 0;
+static uint32_t s_fps_x100 = 0;
+
+/* Optional per-row callback */
+static camera_row_hook_t s_row_hook = NULL;
+static void *s_row_hook_ctx = NULL;
+
+/* Sensor-side capture configuration */
+static cam_capture_config_t s_config = { 0, 0, 0, 0, 1, CAM_SENSOR_RGB888 };
+
+/* RGB565 rows expanded to camera words */
+static uint32_t s_row_rgb[IMAGE_SIZE_X];
 
 /*******************************************************************************
  * Code
  ******************************************************************************/
 
+/*
+ * Row conversion kernels. A camera word is already in the CNN layout
+ * (B<<16)|(G<<8)|R, so a CNN word is one load, mask and XOR. RGB565 is built
+ * two pixels at a time in halfword lanes and stored big-endian (TFT order).
+ * Callers clamp the pixel counts to the buffers once per row.
+ */
+
+static inline uint32_t pixel_to_cnn(uint32_t px)
+{
+    return (px & CNN_PIXEL_MASK) ^ CNN_PIXEL_OFFSET;
+}
+
+static inline uint32_t pixel_to_rgb565(uint32_t px)
+{
+    return ((px & 0xF8U) << 8) | ((px >> 5) & 0x07E0U) | ((px >> 19) & 0x001FU);
+}
+
+/* Two pixels as four big-endian RGB565 bytes, pixel 0 first */
+static inline uint32_t pixels_to_rgb565x2(uint32_t p0, uint32_t p1)
+{
+    uint32_t r, g, b;
+
+#if defined(__ARM_FEATURE_DSP)
+    uint32_t rb0 = __UXTB16(p0);        /* 0x00BB00RR */
+    uint32_t rb1 = __UXTB16(p1);
+
+    r = __PKHBT(rb0, rb1, 16);          /* R1 : R0 */
+    b = __PKHTB(rb1, rb0, 16);          /* B1 : B0 */
+    g = __PKHBT(p0 >> 8, p1 >> 8, 16);  /* G1 : G0 in the low byte of each lane */
+#else
+    r = (p0 & 0xFFU) | ((p1 & 0xFFU) << 16);
+    b = ((p0 >> 16) & 0xFFU) | (p1 & 0x00FF0000U);
+    g = ((p0 >> 8) & 0xFFU) | ((p1 << 8) & 0x00FF0000U);
+#endif
+
+    r = ((r & 0x00F800F8U) << 8) | ((g & 0x00FC00FCU) << 3) | ((b & 0x00F800F8U) >> 3);
+
+#if defined(__ARM_FEATURE_DSP)
+    return __REV16(r);
+#else
+    return ((r & 0x00FF00FFU) << 8) | ((r >> 8) & 0x00FF00FFU);
+#endif
+}
+
+static void convert_row_cnn(const uint32_t *src, uint32_t *cnn, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        cnn[i] = pixel_to_cnn(src[i]);
+    }
+}
+
+static void convert_row_rgb565(const uint32_t *src, uint8_t *rgb565, uint32_t n)
+{
+    uint32_t i;
+    uint32_t v;
+
+    for (i = 0; i + 1 < n; i += 2) {
+        __UNALIGNED_UINT32_WRITE(&rgb565[2 * i], pixels_to_rgb565x2(src[i], src[i + 1]));
+    }
+    if (i < n) {
+        v = pixel_to_rgb565(src[i]);
+        rgb565[2 * i]     = (uint8_t)(v >> 8);
+        rgb565[2 * i + 1] = (uint8_t)v;
+    }
+}
+
+/* Both outputs in one pass over the stream buffer */
+static void convert_row_cnn_rgb565(const uint32_t *src, uint32_t *cnn, uint8_t *rgb565,
+                                   uint32_t n)
+{
+    uint32_t i;
+    uint32_t p0, p1;
+
+    for (i = 0; i + 1 < n; i += 2) {
+        p0 = src[i];
+        p1 = src[i + 1];
+        cnn[i]     = pixel_to_cnn(p0);
+        cnn[i + 1] = pixel_to_cnn(p1);
+        __UNALIGNED_UINT32_WRITE(&rgb565[2 * i], pixels_to_rgb565x2(p0, p1));
+    }
+    if (i < n) {
+        cnn[i] = pixel_to_cnn(src[i]);
+        convert_row_rgb565(&src[i], &rgb565[2 * i], 1);
+    }
+}
+
+/**
+ * @brief   Convert one camera row, each output clamped to its own count.
+ */
+static void convert_row(const uint32_t *src, uint32_t *cnn, uint32_t n_cnn,
+                        uint8_t *rgb565, uint32_t n_rgb565)
+{
+    if (n_rgb565 == n_cnn) {
+        convert_row_cnn_rgb565(src, cnn, rgb565, n_cnn);
+        return;
+    }
+
+    convert_row_cnn(src, cnn, n_cnn);
+    if (n_rgb565 > 0) {
+        convert_row_rgb565(src, rgb565, n_rgb565);
+    }
+}
+
+/**
+ * @brief   Pixels of a row that still fit in an RGB565 buffer at offset j.
+ */
+static inline uint32_t rgb565_fit(const uint8_t *rgb565_buffer, uint32_t rgb565_size,
+                                  uint32_t j, uint32_t w)
+{
+    uint32_t room;
+
+    if (rgb565_buffer == NULL || j >= rgb565_size) {
+        return 0;
+    }
+    room = (rgb565_size - j) / 2;
+    return (room < w) ? room : w;
+}
+
+/**
+ * @brief   Expand a big-endian RGB565 row into 0x00BBGGRR camera words.
+ *
+ * Each 5/6-bit channel is widened with its top bits, so full scale stays
+ * 0xFF as with RGB888 output.
+ */
+static void expand_row_rgb565(const uint8_t *src, uint32_t *dst, uint32_t n)
+{
+    uint32_t px, r, g, b;
+
+    for (uint32_t i = 0; i < n; i++) {
+        px = ((uint32_t)src[2 * i] << 8) | src[2 * i + 1];
+        r = (px >> 8) & 0xF8U;
+        g = (px >> 3) & 0xFCU;
+        b = (px << 3) & 0xF8U;
+        dst[i] = (r | (r >> 5)) | ((g | (g >> 6)) << 8) | ((b | (b >> 5)) << 16);
+    }
+}
+
+/**
+ * @brief   Camera words of a stream buffer row, expanded if the sensor
+ *          sends RGB565.
+ */
+static inline const uint32_t *sensor_row(const uint8_t *data, uint32_t w)
+{
+    if (s_config.format == CAM_SENSOR_RGB565) {
+        expand_row_rgb565(data, s_row_rgb, (w < IMAGE_SIZE_X) ? w : IMAGE_SIZE_X);
+        return s_row_rgb;
+    }
+    return (const uint32_t *)data;
+}
+
+/**
+ * @brief   Program the sensor array window of s_config.
+ */
+static void apply_window(void)
+{
+    uint32_t x = s_config.crop_x;
+    uint32_t y = s_config.crop_y;
+    uint32_t w = s_config.crop_w ? s_config.crop_w : SENSOR_WIDTH;
+    uint32_t h = s_config.crop_h ? s_config.crop_h : SENSOR_HEIGHT;
+
+    if (s_config.crop_w == 0 && s_config.crop_h == 0) {
+        return;     /* Driver default */
+    }
+
+    camera_write_reg(CAMERA_REG_HSTART, (uint8_t)(CAMERA_HSTART_BASE + x / 4));
+    camera_write_reg(CAMERA_REG_HSIZE, (uint8_t)(w / 4));
+    camera_write_reg(CAMERA_REG_VSTART, (uint8_t)(CAMERA_VSTART_BASE + y / 2));
+    camera_write_reg(CAMERA_REG_VSIZE, (uint8_t)(h / 2));
+}
+
+/**
+ * @brief   Full sensor setup for s_config: output size, format and window.
+ */
+static int setup_sensor(void)
+{
+    int ret;
+
+    if (s_config.format == CAM_SENSOR_RGB565) {
+        /* Two pixels per 32-bit FIFO word */
+        ret = camera_setup(s_image_width / s_config.binning, s_image_height / s_config.binning,
+                           PIXFORMAT_RGB565, FIFO_FOUR_BYTE, STREAMING_DMA, s_dma_channel);
+    } else {
+        ret = camera_setup(s_image_width / s_config.binning, s_image_height / s_config.binning,
+                           PIXFORMAT_RGB888, FIFO_THREE_BYTE, STREAMING_DMA, s_dma_channel);
+    }
+    if (ret == STATUS_OK) {
+        apply_window();
+    }
+
+    return ret;
+}
+
 cam_status_t camera_utils_init(uint32_t freq, uint32_t width, uint32_t height,
                                 int dma_channel)
 {
@@ -32,86 +289,286 @@ cam_status_t camera_utils_init(uint32_t freq, uint32_t width, uint32_t height,
 
     s_image_width  = width;
     s_image_height = height;
+    s_dma_channel  = dma_channel;
+    s_current_freq = freq;
+
+    /* Start the rate controller at the fastest undivided entry not above freq */
+    for (int i = 0; i < NUM_RATE_LEVELS; i++) {
+        if (s_rate_levels[i].freq <= freq && s_rate_levels[i].prescaler == 0) {
+            s_rate_level = i;
+            break;
+        }
+    }
 
     printf("Init Camera.\n");
     camera_init(freq);
 
-    ret = camera_setup(width, height, PIXFORMAT_RGB888,
-                       FIFO_THREE_BYTE, STREAMING_DMA, dma_channel);
+    ret = setup_sensor();
     if (ret != STATUS_OK) {
         printf("Error returned from setting up camera. Error %d\n", ret);
         return CAM_STATUS_ERROR;
     }
 
     /* Prevent streaming overflow by setting camera clock prescaler */
-    camera_write_reg(0x11, 0x00);
+    camera_write_reg(CAMERA_REG_CLKRC, 0x00);
+
+    return CAM_STATUS_OK;
+}
+
+/**
+ * @brief   Wait for the next camera stream buffer.
+ *
+ * @return  The buffer, or NULL when the frame ended without one.
+ */
+static uint8_t *wait_stream_buffer(void)
+{
+    uint8_t *data;
+
+#if CAMERA_WAIT_WFI
+    /* Sleep between the camera DMA interrupts */
+    SCHED_SLEEP_WHILE((data = get_camera_stream_buffer()) == NULL && !camera_is_image_rcv());
+#else
+    while ((data = get_camera_stream_buffer()) == NULL) {
+        if (camera_is_image_rcv()) {
+            break;
+        }
+    }
+#endif
+
+    return data;
+}
+
+/**
+ * @brief   Switch the camera to a rate table entry.
+ *
+ * @return  CAM_STATUS_OK, or CAM_STATUS_ERROR if the sensor did not come
+ *          back at the new camera clock (the old level is restored).
+ */
+static cam_status_t apply_rate_level(int level)
+{
+    const rate_level_t *rate = &s_rate_levels[level];
+    cam_status_t status = CAM_STATUS_OK;
+
+    s_clean_frames = 0;
+    s_last_frame_cycles = 0;
+
+    if (rate->freq != s_current_freq) {
+        /* New XCLK: the sensor is reset, so redo the full setup */
+        camera_init(rate->freq);
+        if (setup_sensor() != STATUS_OK) {
+            camera_init(s_current_freq);
+            setup_sensor();
+            level = s_rate_level;
+            rate = &s_rate_levels[level];
+            status = CAM_STATUS_ERROR;
+        }
+        s_current_freq = rate->freq;
+    }
+    camera_write_reg(CAMERA_REG_CLKRC, rate->prescaler);
+    s_rate_level = level;
+
+    return status;
+}
+
+cam_status_t camera_utils_configure(const cam_capture_config_t *config)
+{
+    static const cam_capture_config_t defaults = { 0, 0, 0, 0, 1, CAM_SENSOR_RGB888 };
+    cam_capture_config_t old = s_config;
+
+    if (config == NULL) {
+        config = &defaults;
+    }
+    if ((config->binning != 1 && config->binning != 2 && config->binning != 4) ||
+        config->crop_x + config->crop_w > SENSOR_WIDTH ||
+        config->crop_y + config->crop_h > SENSOR_HEIGHT ||
+        (config->crop_w == 0) != (config->crop_h == 0)) {
+        return CAM_STATUS_ERROR;
+    }
+    /* The FIFO and the CNN take exactly one network input per frame */
+    if (s_image_width / config->binning != IMAGE_SIZE_X ||
+        s_image_height / config->binning != IMAGE_SIZE_Y) {
+        return CAM_STATUS_ERROR;
+    }
+    /* The sensor scaler only shrinks the window */
+    if (config->crop_w != 0 &&
+        (config->crop_w < IMAGE_SIZE_X || config->crop_h < IMAGE_SIZE_Y)) {
+        return CAM_STATUS_ERROR;
+    }
+
+    s_config = *config;
+    if (setup_sensor() != STATUS_OK) {
+        s_config = old;
+        setup_sensor();
+        return CAM_STATUS_ERROR;
+    }
+    /* camera_setup() resets the prescaler */
+    camera_write_reg(CAMERA_REG_CLKRC, s_rate_levels[s_rate_level].prescaler);
 
     return CAM_STATUS_OK;
 }
 
+void camera_utils_get_config(cam_capture_config_t *config)
+{
+    if (config != NULL) {
+        *config = s_config;
+    }
+}
+
+void camera_utils_set_row_hook(camera_row_hook_t hook, void *ctx)
+{
+    s_row_hook = hook;
+    s_row_hook_ctx = ctx;
+}
+
+int camera_utils_rate_update(cam_status_t capture_status)
+{
+    uint32_t now = profile_now();
+    uint32_t period;
+    int wait;
+
+    if (capture_status == CAM_STATUS_OVERFLOW) {
+        s_overflow_frames++;
+        if (s_level_failures[s_rate_level] < 8) {
+            s_level_failures[s_rate_level]++;
+        }
+        if (s_rate_level < NUM_RATE_LEVELS - 1) {
+            return (apply_rate_level(s_rate_level + 1) == CAM_STATUS_OK) ? 1 : -1;
+        }
+        s_clean_frames = 0;
+        return 0;
+    }
+    if (capture_status != CAM_STATUS_OK) {
+        return 0;
+    }
+
+    /* Frame period across the whole pipeline, smoothed 1/8 */
+    if (s_last_frame_cycles != 0) {
+        period = now - s_last_frame_cycles;
+        if (period > 0) {
+            uint32_t fps = (uint32_t)((uint64_t)SystemCoreClock * 100 / period);
+            s_fps_x100 = (s_fps_x100 == 0) ? fps : s_fps_x100 + ((int32_t)(fps - s_fps_x100) / 8);
+        }
+    }
+    s_last_frame_cycles = now;
+
+    if (s_rate_level == 0) {
+        return 0;
+    }
+
+    /* Faster level that failed before: back off exponentially */
+    wait = CAMERA_RATE_PROBE_FRAMES << s_level_failures[s_rate_level - 1];
+    if (++s_clean_frames >= (uint32_t)wait) {
+        if (apply_rate_level(s_rate_level - 1) != CAM_STATUS_OK) {
+            /* Count it like an overflow so the level is probed less often */
+            if (s_level_failures[s_rate_level - 1] < 8) {
+                s_level_failures[s_rate_level - 1]++;
+            }
+            return -1;
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+void camera_utils_rate_get(cam_rate_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+    status->level = s_rate_level;
+    status->freq = s_current_freq;
+    status->prescaler = s_rate_levels[s_rate_level].prescaler;
+    status->fps_x100 = s_fps_x100;
+    status->overflow_frames = s_overflow_frames;
+}
+
+cam_status_t camera_utils_reclock(void)
+{
+    /* XCLK is divided from the peripheral clock when the camera is set up */
+    camera_init(s_current_freq);
+    if (setup_sensor() != STATUS_OK) {
+        return CAM_STATUS_ERROR;
+    }
+    camera_write_reg(CAMERA_REG_CLKRC, s_rate_levels[s_rate_level].prescaler);
+
+    /* Frame times were measured in cycles of the old clock */
+    s_clean_frames = 0;
+    s_last_frame_cycles = 0;
+
+    return CAM_STATUS_OK;
+}
+
+const uint32_t *camera_utils_convert_row(const uint8_t *data, uint32_t width, uint32_t *cnn,
+                                         uint32_t n_cnn, uint8_t *rgb565, uint32_t n_rgb565)
+{
+    const uint32_t *pixels = sensor_row(data, width);
+
+    convert_row(pixels, cnn, n_cnn, rgb565, n_rgb565);
+    return pixels;
+}
+
 cam_status_t camera_utils_capture(uint32_t *cnn_buffer, uint32_t cnn_buffer_size,
                                    uint8_t *rgb565_buffer, uint32_t rgb565_size)
 {
     uint8_t *raw;
     uint32_t imgLen;
     uint32_t w, h;
-    int cnt = 0;
-    uint8_t r, g, b;
-    uint16_t rgb;
-    int j = 0;
+    uint32_t cnt = 0;
+    uint32_t j = 0;
+    uint32_t n_cnn, n_rgb565;
+    uint8_t *rgb_dst;
     uint8_t *data = NULL;
+    const uint32_t *pixels;
     stream_stat_t *stat;
+    uint32_t t0;
+    uint32_t convert_cycles = 0;
 
     camera_start_capture_image();
 
     /* Get image pointer/length/width/height from camera driver */
     camera_get_image(&raw, &imgLen, &w, &h);
-    printf("W:%d H:%d L:%d\n", (int)w, (int)h, (int)imgLen);
+    if (s_config.format == CAM_SENSOR_RGB565 && w > IMAGE_SIZE_X) {
+        /* RGB565 rows are expanded into an IMAGE_SIZE_X staging row */
+        return CAM_STATUS_ERROR;
+    }
 
     /* Read image streaming buffers line by line */
     for (int row = 0; row < (int)h; row++) {
         /* Wait until camera streaming buffer is available */
-        while ((data = get_camera_stream_buffer()) == NULL) {
-            if (camera_is_image_rcv()) {
-                break;
-            }
+        data = wait_stream_buffer();
+
+        if (data == NULL) {
+            break;
         }
 
-        j = 0;
-        /*
-         * Data format from camera is assumed to be 4 bytes per pixel: 0x00 B G R
-         * (k increments by 4)
-         */
-        for (int k = 0; k < (int)(4 * w); k += 4) {
-            r = data[k];
-            g = data[k + 1];
-            b = data[k + 2];
-
-            /* Check buffer bounds */
-            if ((uint32_t)cnt < cnn_buffer_size) {
-                /* Store packed pixel for CNN as (B<<16)|(G<<8)|R then XOR to convert to signed range */
-                cnn_buffer[cnt] = ((uint32_t)b << 16) | ((uint32_t)g << 8) | (uint32_t)r;
-                cnn_buffer[cnt] ^= 0x00808080U;
-                cnt++;
-            }
+        t0 = PROFILE_NOW();
 
-            /* Convert to RGB565 for display if buffer provided */
-            if (rgb565_buffer != NULL && (uint32_t)(j + 1) < rgb565_size) {
-                rgb = (uint16_t)(((r & 0b11111000) << 8) | ((g & 0b11111100) << 3) | (b >> 3));
-                rgb565_buffer[j]     = (uint8_t)((rgb >> 8) & 0xFF);
-                rgb565_buffer[j + 1] = (uint8_t)(rgb & 0xFF);
-                j += 2;
-            }
+        /* Data format from camera is 4 bytes per pixel: 0x00 B G R */
+        n_cnn = (cnt < cnn_buffer_size) ? cnn_buffer_size - cnt : 0;
+        n_cnn = (n_cnn < w) ? n_cnn : w;
+        n_rgb565 = rgb565_fit(rgb565_buffer, rgb565_size, j, w);
+        rgb_dst = (n_rgb565 > 0) ? &rgb565_buffer[j] : NULL;
+
+        pixels = camera_utils_convert_row(data, w, &cnn_buffer[cnt], n_cnn, rgb_dst, n_rgb565);
+        cnt += n_cnn;
+        j += 2 * n_rgb565;
+
+        convert_cycles += PROFILE_NOW() - t0;
+
+        if (s_row_hook != NULL) {
+            s_row_hook(row, pixels, w, s_row_hook_ctx);
         }
 
         /* Release the stream buffer back to camera driver */
         release_camera_stream_buffer();
     }
+    PROFILE_RECORD(PROFILE_STAGE_CONVERT, convert_cycles);
 
     /* Check streaming stats for overflow */
     stat = get_camera_stream_statistic();
     if (stat->overflow_count > 0) {
-        printf("OVERFLOW DISP = %d\n", stat->overflow_count);
+        /* No print: the console may be carrying a binary frame upload */
 #ifdef OVERFLOW_LED
         LED_On(OVERFLOW_LED);
 #endif
@@ -121,6 +578,102 @@ cam_status_t camera_utils_capture(uint32_t *cnn_buffer, uint32_t cnn_buffer_size
     return CAM_STATUS_OK;
 }
 
+cam_status_t camera_utils_capture_slot(frame_slot_t *slot, uint32_t next_owners,
+                                       uint8_t *rgb565_buffer, uint32_t rgb565_size)
+{
+    cam_status_t status;
+
+    if (slot == NULL) {
+        return CAM_STATUS_ERROR;
+    }
+
+    status = camera_utils_capture(slot->data, slot->words, rgb565_buffer, rgb565_size);
+    frame_pool_hand_off(slot, FRAME_OWNER_CAPTURE,
+                        (status == CAM_STATUS_OK) ? next_owners : 0);
+
+    return status;
+}
+
+cam_status_t camera_utils_capture_stream(uint32_t *cnn_buffer, uint32_t cnn_buffer_size,
+                                          uint8_t *rgb565_buffer, uint32_t rgb565_size)
+{
+    /* Row staging used when the caller does not keep a copy of the frame */
+    static uint32_t row_words[IMAGE_SIZE_X];
+    uint8_t *raw;
+    uint32_t imgLen;
+    uint32_t w, h;
+    uint32_t cnt = 0;
+    uint32_t j = 0;
+    uint32_t n_rgb565;
+    uint8_t *rgb_dst;
+    uint8_t *data = NULL;
+    const uint32_t *pixels;
+    uint32_t *dst;
+    stream_stat_t *stat;
+    cam_status_t status = CAM_STATUS_OK;
+    uint32_t t0;
+    uint32_t convert_cycles = 0;
+    uint32_t fifo_cycles = 0;
+
+    camera_start_capture_image();
+
+    camera_get_image(&raw, &imgLen, &w, &h);
+    if (w > IMAGE_SIZE_X) {
+        return CAM_STATUS_ERROR;
+    }
+
+    for (int row = 0; row < (int)h; row++) {
+        /* Wait until camera streaming buffer is available */
+        data = wait_stream_buffer();
+        if (data == NULL) {
+            /* Frame ended early, the CNN is still waiting for rows */
+            status = CAM_STATUS_ERROR;
+            break;
+        }
+
+        t0 = PROFILE_NOW();
+
+        /* Convert in place into the caller's copy when it has room */
+        if (cnn_buffer != NULL && cnt + w <= cnn_buffer_size) {
+            dst = &cnn_buffer[cnt];
+        } else {
+            dst = row_words;
+        }
+
+        n_rgb565 = rgb565_fit(rgb565_buffer, rgb565_size, j, w);
+        rgb_dst = (n_rgb565 > 0) ? &rgb565_buffer[j] : NULL;
+        pixels = camera_utils_convert_row(data, w, dst, w, rgb_dst, n_rgb565);
+        j += 2 * n_rgb565;
+
+        convert_cycles += PROFILE_NOW() - t0;
+
+        if (s_row_hook != NULL) {
+            s_row_hook(row, pixels, w, s_row_hook_ctx);
+        }
+
+        /* Give the stream buffer back before blocking on the FIFO */
+        release_camera_stream_buffer();
+
+        /* Feed layer 0 while the camera fills the next stream buffer */
+        t0 = PROFILE_NOW();
+        inference_load_input(dst, w);
+        fifo_cycles += PROFILE_NOW() - t0;
+        cnt += w;
+    }
+    PROFILE_RECORD(PROFILE_STAGE_CONVERT, convert_cycles);
+    PROFILE_RECORD(PROFILE_STAGE_FIFO_LOAD, fifo_cycles);
+
+    stat = get_camera_stream_statistic();
+    if (stat->overflow_count > 0) {
+#ifdef OVERFLOW_LED
+        LED_On(OVERFLOW_LED);
+#endif
+        return CAM_STATUS_OVERFLOW;
+    }
+
+    return status;
+}
+
 cam_status_t camera_utils_get_image(uint8_t **buffer, uint32_t *length,
                                      uint32_t *width, uint32_t *height)
 {
@@ -132,3 +685,101 @@ cam_status_t camera_utils_get_image(uint8_t **buffer, uint32_t *length,
 
     return CAM_STATUS_OK;
 }
+
+void camera_utils_view_cnn(cam_frame_view_t *view, const uint32_t *cnn_buffer,
+                           uint32_t width, uint32_t height)
+{
+    view->data = (const uint8_t *)cnn_buffer;
+    view->width = width;
+    view->height = height;
+    view->stride = width * sizeof(uint32_t);
+    view->format = CAM_VIEW_CNN;
+}
+
+void camera_utils_view_rgb565(cam_frame_view_t *view, const uint8_t *rgb565_buffer,
+                              uint32_t width, uint32_t height)
+{
+    view->data = rgb565_buffer;
+    view->width = width;
+    view->height = height;
+    view->stride = width * 2;
+    view->format = CAM_VIEW_RGB565;
+}
+
+cam_status_t camera_utils_get_view(cam_frame_view_t *view)
+{
+    uint8_t *raw;
+    uint32_t len, w, h;
+
+    if (view == NULL) {
+        return CAM_STATUS_ERROR;
+    }
+
+    camera_get_image(&raw, &len, &w, &h);
+    if (s_config.format == CAM_SENSOR_RGB565) {
+        camera_utils_view_rgb565(view, raw, w, h);
+    } else {
+        view->data = raw;
+        view->width = w;
+        view->height = h;
+        view->stride = w * sizeof(uint32_t);
+        view->format = CAM_VIEW_RGB888;
+    }
+    if (raw == NULL || len < view->stride * h) {
+        return CAM_STATUS_ERROR;
+    }
+
+    return CAM_STATUS_OK;
+}
+
+void camera_utils_view_row_rgb(const cam_frame_view_t *view, uint32_t y, uint32_t *dst)
+{
+    const uint32_t *src = (const uint32_t *)cam_view_row(view, y);
+    uint32_t x;
+
+    switch (view->format) {
+    case CAM_VIEW_CNN:
+        /* Word-wide XOR, no per-channel unpack */
+        for (x = 0; x < view->width; x++) {
+            dst[x] = (src[x] ^ 0x00808080U) & 0x00FFFFFFU;
+        }
+        break;
+    case CAM_VIEW_RGB888:
+        for (x = 0; x < view->width; x++) {
+            dst[x] = src[x] & 0x00FFFFFFU;
+        }
+        break;
+    default:
+        for (x = 0; x < view->width; x++) {
+            dst[x] = cam_view_rgb(view, x, y);
+        }
+        break;
+    }
+}
+
+void camera_utils_downscale_cnn(const uint32_t *src, uint32_t width, uint32_t height,
+                                uint32_t *dst)
+{
+    const uint32_t *row0, *row1;
+    uint32_t a, b, c, d;
+    uint32_t rb, g;
+
+    for (uint32_t y = 0; y + 1 < height; y += 2) {
+        row0 = src + y * width;
+        row1 = row0 + width;
+        for (uint32_t x = 0; x + 1 < width; x += 2) {
+            a = row0[x] ^ 0x00808080U;
+            b = row0[x + 1] ^ 0x00808080U;
+            c = row1[x] ^ 0x00808080U;
+            d = row1[x + 1] ^ 0x00808080U;
+
+            /* R and B in separate 16-bit lanes, G on its own, rounded */
+            rb = (a & 0x00FF00FFU) + (b & 0x00FF00FFU) + (c & 0x00FF00FFU) +
+                 (d & 0x00FF00FFU) + 0x00020002U;
+            g = (a & 0x0000FF00U) + (b & 0x0000FF00U) + (c & 0x0000FF00U) +
+                (d & 0x0000FF00U) + 0x00000200U;
+
+            *dst++ = (((rb >> 2) & 0x00FF00FFU) | ((g >> 2) & 0x0000FF00U)) ^ 0x00808080U;
+        }
+    }
+}
@@ -0,0 +1,532 @@
+/**
+ * @file    capture_log.c
+ * @brief   Persistent capture log implementation for MAX78000 CNN projects.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "capture_log.h"
+#include "image_codec.h"
+#include "serial_stream.h"
+#include "app_config.h"
+#include "mxc.h"
+#include "flc.h"
+
+#if CAPTURE_LOG_ENABLE
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define LOG_MARKER          "<<<LOG>>>"
+
+#define PAGE_SIZE           MXC_FLASH_PAGE_SIZE
+
+/* Top CAPTURE_LOG_PAGES pages of internal flash, unless placed elsewhere */
+#ifndef CAPTURE_LOG_BASE
+#define CAPTURE_LOG_BASE    (MXC_FLASH_MEM_BASE + MXC_FLASH_MEM_SIZE - \
+                             CAPTURE_LOG_PAGES * MXC_FLASH_PAGE_SIZE)
+#endif
+
+/* Bytes programmed per capture_log_service() step (multiple of 16) */
+#ifndef CAPTURE_LOG_PROGRAM_BYTES
+#define CAPTURE_LOG_PROGRAM_BYTES 2048
+#endif
+
+/* Payload chunk size */
+#define CHUNK_SIZE          512
+
+/* Page header field without a record start */
+#define NO_RECORD           0xFFFFU
+
+/* Record header size */
+#define RECORD_HEADER_SIZE  (24 + 2 * CNN_NUM_OUTPUTS)
+
+/* Page buffer states */
+typedef enum {
+    BUF_FREE = 0,
+    BUF_FILLING,            /* Receiving records */
+    BUF_FULL                /* Queued for erase and programming */
+} buf_state_t;
+
+/* One flash page staged in SRAM */
+typedef struct {
+    uint32_t    data[PAGE_SIZE / 4];
+    uint32_t    page;       /* Index in the ring */
+    uint32_t    len;        /* Bytes filled, header included */
+    uint32_t    written;    /* Bytes programmed */
+    int         erased;
+    buf_state_t state;
+} page_buf_t;
+
+/* Payload being chunked into the log */
+typedef struct {
+    uint8_t  buf[CHUNK_SIZE];
+    uint32_t len;
+    uint32_t crc;
+} chunk_sink_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static page_buf_t s_bufs[CAPTURE_LOG_BUFFERS];
+static int s_fill = -1;                     /* Buffer receiving records, -1 none */
+
+/* Full buffers in page order */
+static int s_queue[CAPTURE_LOG_BUFFERS];
+static int s_q_head = 0;
+static int s_q_count = 0;
+
+static uint32_t s_erase[CAPTURE_LOG_PAGES]; /* Erase count per page */
+static uint8_t s_valid[CAPTURE_LOG_PAGES];  /* Page holds a programmed header */
+static uint32_t s_next_page = 0;            /* Ring index of the next new page */
+static uint32_t s_seq = 0;                  /* Sequence number of the next page */
+static int s_ready = 0;
+
+static chunk_sink_t s_chunk;
+static capture_log_stats_t s_stats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void put_le16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+static uint32_t get_le16(const volatile uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static uint32_t get_le32(const volatile uint8_t *p)
+{
+    return get_le16(p) | (get_le16(p + 2) << 16);
+}
+
+static uint32_t page_addr(uint32_t page)
+{
+    return CAPTURE_LOG_BASE + page * PAGE_SIZE;
+}
+
+static void free_buffers(void)
+{
+    for (int i = 0; i < CAPTURE_LOG_BUFFERS; i++) {
+        s_bufs[i].state = BUF_FREE;
+    }
+    s_fill = -1;
+    s_q_head = 0;
+    s_q_count = 0;
+}
+
+/* Start the next ring page in a free buffer */
+static void start_page(int idx)
+{
+    page_buf_t *buf = &s_bufs[idx];
+    uint8_t *hdr = (uint8_t *)buf->data;
+
+    memset(buf->data, 0xFF, sizeof(buf->data));
+    buf->page = s_next_page;
+    buf->len = CAPTURE_LOG_PAGE_HEADER;
+    buf->written = 0;
+    buf->erased = 0;
+    buf->state = BUF_FILLING;
+    s_next_page = (s_next_page + 1) % CAPTURE_LOG_PAGES;
+
+    memcpy(hdr, CAPTURE_LOG_PAGE_MAGIC, 4);
+    put_le32(&hdr[4], s_seq++);
+    put_le32(&hdr[8], s_erase[buf->page] + 1);     /* Count after the coming erase */
+    put_le16(&hdr[12], NO_RECORD);
+    put_le16(&hdr[14], s_stats.boot);
+
+    s_fill = idx;
+}
+
+/* Queue the filling buffer for flash */
+static void close_page(void)
+{
+    s_bufs[s_fill].state = BUF_FULL;
+    s_queue[(s_q_head + s_q_count) % CAPTURE_LOG_BUFFERS] = s_fill;
+    s_q_count++;
+    s_fill = -1;
+}
+
+/* Make sure a buffer is filling, writing queued pages if none is free */
+static void acquire_page(void)
+{
+    int stalled = 0;
+
+    while (s_fill < 0) {
+        for (int i = 0; i < CAPTURE_LOG_BUFFERS; i++) {
+            if (s_bufs[i].state == BUF_FREE) {
+                start_page(i);
+                break;
+            }
+        }
+        if (s_fill < 0) {
+            if (!stalled) {
+                s_stats.stalls++;
+                stalled = 1;
+            }
+            capture_log_service();
+        }
+    }
+}
+
+static void log_write(const uint8_t *data, uint32_t len)
+{
+    page_buf_t *buf;
+    uint32_t n;
+
+    while (len > 0) {
+        acquire_page();
+        buf = &s_bufs[s_fill];
+        n = PAGE_SIZE - buf->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy((uint8_t *)buf->data + buf->len, data, n);
+        buf->len += n;
+        data += n;
+        len -= n;
+        if (buf->len == PAGE_SIZE) {
+            close_page();
+        }
+    }
+}
+
+/* Record the offset of a record starting in the current page */
+static void mark_record_start(void)
+{
+    uint8_t *hdr;
+
+    acquire_page();
+    hdr = (uint8_t *)s_bufs[s_fill].data;
+    if (get_le16(&hdr[12]) == NO_RECORD) {
+        put_le16(&hdr[12], s_bufs[s_fill].len);
+    }
+}
+
+static void chunk_flush(chunk_sink_t *cs)
+{
+    uint8_t len[2];
+
+    put_le16(len, cs->len);
+    log_write(len, sizeof(len));
+    log_write(cs->buf, cs->len);
+    cs->len = 0;
+}
+
+static void chunk_sink(void *ctx, const uint8_t *data, uint32_t len)
+{
+    chunk_sink_t *cs = (chunk_sink_t *)ctx;
+    uint32_t n;
+
+    cs->crc = serial_crc32(cs->crc, data, len);
+    while (len > 0) {
+        n = CHUNK_SIZE - cs->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(cs->buf + cs->len, data, n);
+        cs->len += n;
+        data += n;
+        len -= n;
+        if (cs->len == CHUNK_SIZE) {
+            chunk_flush(cs);
+        }
+    }
+}
+
+capture_log_status_t capture_log_init(void)
+{
+    const volatile uint8_t *hdr;
+    uint32_t seq, max_seq = 0;
+    uint32_t newest = 0;
+    uint32_t boot = 0;
+    int found = 0;
+
+    if (MXC_FLC_Init() != E_NO_ERROR) {
+        return CAPTURE_LOG_FLASH_ERROR;
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.pages = CAPTURE_LOG_PAGES;
+    free_buffers();
+
+    for (uint32_t p = 0; p < CAPTURE_LOG_PAGES; p++) {
+        hdr = (const volatile uint8_t *)page_addr(p);
+        s_valid[p] = (memcmp((const void *)hdr, CAPTURE_LOG_PAGE_MAGIC, 4) == 0);
+        s_erase[p] = 0;
+        if (!s_valid[p]) {
+            continue;
+        }
+
+        seq = get_le32(&hdr[4]);
+        s_erase[p] = get_le32(&hdr[8]);
+        if (!found || seq > max_seq) {
+            max_seq = seq;
+            newest = p;
+        }
+        if (get_le16(&hdr[14]) > boot) {
+            boot = get_le16(&hdr[14]);
+        }
+        if (s_erase[p] > s_stats.max_erase) {
+            s_stats.max_erase = s_erase[p];
+        }
+        s_stats.used_pages++;
+        found = 1;
+    }
+
+    /* Continue after the newest page; the oldest ones are overwritten first */
+    s_next_page = found ? (newest + 1) % CAPTURE_LOG_PAGES : 0;
+    s_seq = found ? max_seq + 1 : 0;
+    s_stats.boot = (uint16_t)(boot + 1);
+    s_ready = 1;
+
+    return CAPTURE_LOG_OK;
+}
+
+capture_log_status_t capture_log_append(const cam_frame_view_t *view, int capture_id,
+                                        const inference_result_t *result)
+{
+    uint8_t hdr[RECORD_HEADER_SIZE];
+    uint8_t crc[4];
+    uint8_t px[3];
+    uint32_t rgb;
+    uint32_t lost;
+    image_codec_t codec = CAPTURE_LOG_CODEC;
+
+    if (!s_ready || view == NULL || view->data == NULL || result == NULL) {
+        return CAPTURE_LOG_ERROR;
+    }
+    /* The codecs read a packed CNN buffer, other views are stored as pixels */
+    if (view->format != CAM_VIEW_CNN || view->stride != view->width * sizeof(uint32_t)) {
+        codec = IMAGE_CODEC_NONE;
+    }
+    lost = s_stats.lost_pages;
+
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, CAPTURE_LOG_RECORD_MAGIC, 4);
+    put_le32(&hdr[4], (uint32_t)capture_id);
+    hdr[8] = (uint8_t)codec;
+    hdr[9] = (uint8_t)STREAM_PIXFMT_RGB888;
+    put_le16(&hdr[10], view->width);
+    put_le16(&hdr[12], view->height);
+    hdr[14] = (uint8_t)result->predicted_class;
+    hdr[15] = (uint8_t)result->confidence_percent;
+    put_le32(&hdr[16], result->inference_time_us);
+    hdr[20] = CNN_NUM_OUTPUTS;
+    for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
+        put_le16(&hdr[24 + 2 * i], (uint16_t)result->softmax[i]);
+    }
+
+    mark_record_start();
+    log_write(hdr, sizeof(hdr));
+
+    /* One pass: chunk lengths and the trailing CRC need no size up front */
+    memset(&s_chunk, 0, sizeof(s_chunk));
+    if (codec != IMAGE_CODEC_NONE) {
+        image_codec_encode(codec, (const uint32_t *)view->data, (int)view->width,
+                           (int)view->height, CAPTURE_LOG_QUALITY, chunk_sink, &s_chunk);
+    } else {
+        for (uint32_t y = 0; y < view->height; y++) {
+            for (uint32_t x = 0; x < view->width; x++) {
+                rgb = cam_view_rgb(view, x, y);
+                px[0] = (uint8_t)(rgb & 0xFF);
+                px[1] = (uint8_t)((rgb >> 8) & 0xFF);
+                px[2] = (uint8_t)((rgb >> 16) & 0xFF);
+                chunk_sink(&s_chunk, px, sizeof(px));
+            }
+        }
+    }
+    if (s_chunk.len > 0) {
+        chunk_flush(&s_chunk);
+    }
+    chunk_flush(&s_chunk);      /* Zero length ends the payload */
+    put_le32(crc, s_chunk.crc);
+    log_write(crc, sizeof(crc));
+
+    s_stats.records++;
+    return (s_stats.lost_pages == lost) ? CAPTURE_LOG_OK : CAPTURE_LOG_FLASH_ERROR;
+}
+
+int capture_log_service(void)
+{
+    page_buf_t *buf;
+    uint32_t addr;
+    uint32_t end;
+    uint32_t n;
+
+    if (s_q_count == 0) {
+        return 0;
+    }
+
+    buf = &s_bufs[s_queue[s_q_head]];
+    addr = page_addr(buf->page);
+    /* A partial page is programmed up to its last 128-bit flash word */
+    end = (buf->len + 15U) & ~15U;
+
+    if (!buf->erased) {
+        s_valid[buf->page] = 0;
+        if (MXC_FLC_PageErase(addr) != E_NO_ERROR) {
+            end = 0;
+        } else {
+            s_erase[buf->page]++;
+            if (s_erase[buf->page] > s_stats.max_erase) {
+                s_stats.max_erase = s_erase[buf->page];
+            }
+            buf->erased = 1;
+            return 1;
+        }
+    } else {
+        n = end - buf->written;
+        if (n > CAPTURE_LOG_PROGRAM_BYTES) {
+            n = CAPTURE_LOG_PROGRAM_BYTES;
+        }
+        if (MXC_FLC_Write(addr + buf->written, n, &buf->data[buf->written / 4]) !=
+            E_NO_ERROR) {
+            end = 0;
+        } else {
+            buf->written += n;
+        }
+    }
+
+    if (end == 0) {
+        /* Records in this page are lost; the host resyncs on the next page */
+        s_stats.lost_pages++;
+    } else if (buf->written < end) {
+        return 1;
+    } else if (!s_valid[buf->page]) {
+        s_valid[buf->page] = 1;
+        if (s_stats.used_pages < CAPTURE_LOG_PAGES) {
+            s_stats.used_pages++;
+        }
+    }
+
+    buf->state = BUF_FREE;
+    s_q_head = (s_q_head + 1) % CAPTURE_LOG_BUFFERS;
+    s_q_count--;
+    return s_q_count > 0;
+}
+
+capture_log_status_t capture_log_flush(void)
+{
+    uint32_t lost = s_stats.lost_pages;
+
+    if (!s_ready) {
+        return CAPTURE_LOG_ERROR;
+    }
+    if (s_fill >= 0 && s_bufs[s_fill].len > CAPTURE_LOG_PAGE_HEADER) {
+        close_page();
+    }
+    while (capture_log_service()) {
+        /* write */
+    }
+
+    return (s_stats.lost_pages == lost) ? CAPTURE_LOG_OK : CAPTURE_LOG_FLASH_ERROR;
+}
+
+capture_log_status_t capture_log_offload(uint32_t baud, uint32_t restore_baud)
+{
+    mxc_uart_regs_t *uart = MXC_UART_GET_UART(CONSOLE_UART);
+    capture_log_status_t ret;
+    uint8_t hdr[16];
+    uint8_t crc_bytes[4];
+    uint32_t crc = 0;
+    uint32_t pages = 0;
+    uint32_t p;
+    int len;
+
+    ret = capture_log_flush();
+    if (ret == CAPTURE_LOG_ERROR) {
+        return ret;
+    }
+
+    for (uint32_t i = 0; i < CAPTURE_LOG_PAGES; i++) {
+        pages += s_valid[i];
+    }
+
+    printf("\n%s\n", LOG_MARKER);
+    printf("PAGES:%u\n", (unsigned)pages);
+    printf("BAUD:%u\n", (unsigned)baud);
+    serial_stream_init(baud);
+    /* Give the host time to follow the rate change */
+    MXC_Delay(MXC_DELAY_MSEC(100));
+
+    memcpy(hdr, CAPTURE_LOG_DUMP_MAGIC, 4);
+    hdr[4] = CAPTURE_LOG_DUMP_VERSION;
+    hdr[5] = 0;
+    hdr[6] = 0;
+    hdr[7] = 0;
+    put_le32(&hdr[8], pages);
+    put_le32(&hdr[12], PAGE_SIZE);
+    len = sizeof(hdr);
+    MXC_UART_Write(uart, hdr, &len);
+
+    /* Pages go out straight from flash, oldest (after the newest) first */
+    for (uint32_t i = 0; i < CAPTURE_LOG_PAGES; i++) {
+        p = (s_next_page + i) % CAPTURE_LOG_PAGES;
+        if (!s_valid[p]) {
+            continue;
+        }
+        crc = serial_crc32(crc, (const uint8_t *)page_addr(p), PAGE_SIZE);
+        len = PAGE_SIZE;
+        MXC_UART_Write(uart, (const uint8_t *)page_addr(p), &len);
+    }
+    put_le32(crc_bytes, crc);
+    len = sizeof(crc_bytes);
+    MXC_UART_Write(uart, crc_bytes, &len);
+
+    serial_stream_init(restore_baud);
+    MXC_Delay(MXC_DELAY_MSEC(100));
+    printf("\nLog offloaded: %u pages\n", (unsigned)pages);
+
+    return ret;
+}
+
+capture_log_status_t capture_log_erase(void)
+{
+    capture_log_status_t ret = CAPTURE_LOG_OK;
+
+    if (!s_ready) {
+        return CAPTURE_LOG_ERROR;
+    }
+
+    free_buffers();
+    for (uint32_t p = 0; p < CAPTURE_LOG_PAGES; p++) {
+        if (MXC_FLC_PageErase(page_addr(p)) != E_NO_ERROR) {
+            ret = CAPTURE_LOG_FLASH_ERROR;
+            continue;
+        }
+        s_erase[p]++;
+        if (s_erase[p] > s_stats.max_erase) {
+            s_stats.max_erase = s_erase[p];
+        }
+        s_valid[p] = 0;
+    }
+    /* Page sequence numbers keep counting, so the ring order stays intact */
+    s_next_page = 0;
+    s_stats.used_pages = 0;
+
+    return ret;
+}
+
+void capture_log_get_stats(capture_log_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
+
+#endif /* CAPTURE_LOG_ENABLE */
@@ -0,0 +1,182 @@
+/**
+ * @file    cnn_network.c
+ * @brief   Table-driven CNN network descriptor implementation for MAX78000 projects.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "cnn_network.h"
+#include "app_config.h"
+#include "network.h"
+#if CNN_NETWORK_TABLE_ENABLE
+#include "weights.h"
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Register blocks of the four CNN quadrants */
+#define CNN_QUADRANT_BASE       0x50100000U
+#define CNN_QUADRANT_STRIDE     0x00400000U
+
+/* FIFO control register */
+#define CNN_FIFO_CTRL           ((volatile uint32_t *)0x50000000)
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const cnn_layer_desc_t s_layers[NETWORK_NUM_LAYERS] = NETWORK_LAYERS;
+static const uint16_t s_reg_addr[NETWORK_NUM_REGS] = NETWORK_REG_ADDR;
+static const uint32_t s_reg_value[NETWORK_NUM_REGS] = NETWORK_REG_VALUE;
+static const uint32_t s_init[2 * NETWORK_NUM_INIT] = NETWORK_INIT;
+static const uint32_t s_bias[] = NETWORK_BIAS;
+#if CNN_NETWORK_TABLE_ENABLE
+/* Replaces the cnn.c copy, which is then unreferenced */
+static const uint32_t s_kernels[] = KERNELS;
+#endif
+
+const cnn_network_t cnn_network_default = {
+    NETWORK_NAME,
+    s_layers,
+    NETWORK_NUM_LAYERS,
+    NETWORK_NUM_REGS,
+    s_reg_addr,
+    s_reg_value,
+    NETWORK_FIFO_CTRL,
+    NETWORK_NUM_INIT,
+    s_init,
+#if CNN_NETWORK_TABLE_ENABLE
+    s_kernels,
+#else
+    NULL,
+#endif
+    s_bias,
+    NETWORK_OUTPUT_ADDR,
+    NETWORK_OUTPUT_WORDS
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void cnn_network_init(const cnn_network_t *net)
+{
+    for (uint32_t i = 0; i < net->num_init; i++) {
+        *(volatile uint32_t *)net->init[2 * i] = net->init[2 * i + 1];
+    }
+}
+
+void cnn_network_configure(const cnn_network_t *net)
+{
+    volatile uint32_t *reg;
+    uint32_t code;
+
+    for (uint32_t i = 0; i < net->num_regs; i++) {
+        code = net->reg_addr[i];
+        reg = (volatile uint32_t *)(CNN_QUADRANT_BASE + (code >> 14) * CNN_QUADRANT_STRIDE +
+                                    ((code & 0x3FFFU) << 2));
+        *reg = net->reg_value[i];
+    }
+
+    *CNN_FIFO_CTRL = net->fifo_ctrl;
+}
+
+void cnn_network_load_weights(const cnn_network_t *net)
+{
+    volatile uint32_t *addr;
+    const uint32_t *ptr = net->kernels;
+    uint32_t len;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    while ((addr = (volatile uint32_t *)*ptr++) != 0) {
+        *((volatile uint8_t *)((uint32_t)addr | 1)) = 0x01;    /* Set address */
+        len = *ptr++;
+        while (len-- > 0) {
+            *addr++ = *ptr++;
+        }
+    }
+}
+
+void cnn_network_load_bias(const cnn_network_t *net)
+{
+    volatile uint32_t *addr;
+    const uint32_t *ptr = net->bias;
+    uint32_t len;
+
+    /* One bias byte per 32-bit word, as memcpy_8to32() in cnn.c */
+    while ((addr = (volatile uint32_t *)*ptr++) != 0) {
+        len = *ptr++;
+        while (len-- > 0) {
+            *addr++ = *ptr++;
+        }
+    }
+}
+
+void cnn_network_unload(const cnn_network_t *net, uint32_t *out)
+{
+    volatile uint32_t *addr = (volatile uint32_t *)net->output_addr;
+
+    for (uint32_t i = 0; i < net->output_words; i++) {
+        *out++ = *addr++;
+    }
+}
+
+uint32_t cnn_network_ops(const cnn_network_t *net)
+{
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < net->num_layers; i++) {
+        total += net->layers[i].ops;
+    }
+    return total;
+}
+
+uint32_t cnn_network_macs(const cnn_network_t *net)
+{
+    uint32_t total = 0;
+
+    for (uint32_t i = 0; i < net->num_layers; i++) {
+        total += net->layers[i].macs;
+    }
+    return total;
+}
+
+void cnn_network_output_shape(const cnn_network_t *net, uint32_t *ch, uint32_t *h,
+                              uint32_t *w)
+{
+    const cnn_layer_desc_t *last = &net->layers[net->num_layers - 1];
+
+    if (ch != NULL) {
+        *ch = last->out_ch;
+    }
+    if (h != NULL) {
+        *h = last->out_h;
+    }
+    if (w != NULL) {
+        *w = last->out_w;
+    }
+}
+
+void cnn_network_print(const cnn_network_t *net)
+{
+    static const char *const op_names[] = { "passthrough", "conv1d", "conv2d", "linear" };
+    const cnn_layer_desc_t *l;
+
+    printf("Network %s: %u layers, %u ops, %u registers\n", net->name,
+           (unsigned)net->num_layers, (unsigned)cnn_network_ops(net),
+           (unsigned)net->num_regs);
+    for (uint32_t i = 0; i < net->num_layers; i++) {
+        l = &net->layers[i];
+        printf("  %u: %ux%ux%u -> %ux%ux%u %s k%u%s%s\n", (unsigned)i,
+               (unsigned)l->in_ch, (unsigned)l->in_h, (unsigned)l->in_w,
+               (unsigned)l->out_ch, (unsigned)l->out_h, (unsigned)l->out_w,
+               op_names[l->op & 3], (unsigned)l->kernel,
+               (l->pool == CNN_POOL_NONE) ? "" : " pool", l->relu ? " relu" : "");
+    }
+}
@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include "display_utils.h"
+#include "camera_utils.h"
 #include "app_config.h"
 
 /*******************************************************************************
@@ -20,152 +21,288 @@ static const char *BRIGHTNESS_EXTENDED =
 /* Standard brightness ramp (10 levels) - good balance of detail and speed */
 static const char *BRIGHTNESS_STANDARD = "@%#*+=-:. ";
 
+/* Widest row rendered (wider views are clipped) */
+#define ART_ROW_MAX         IMAGE_SIZE_X
+
+/* Largest frame kept for diff updates: the app frame at ASCII_ART_RATIO */
+#define ART_MAX_COLS        ((IMAGE_SIZE_X + ASCII_ART_RATIO - 1) / ASCII_ART_RATIO)
+#define ART_MAX_ROWS        ((IMAGE_SIZE_Y + 2 * ASCII_ART_RATIO - 1) / (2 * ASCII_ART_RATIO))
+
+/* Output buffer: one full frame of that size with its newlines */
+#define ART_OUT_SIZE        ((ART_MAX_COLS + 1) * ART_MAX_ROWS)
+
+/* Unchanged cells bridged by rewriting them instead of a cursor move */
+#define ART_DIFF_GAP        4
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* Character per luma level for s_lut_ramp */
+static char s_lut[256];
+static const char *s_lut_ramp = NULL;
+
+static char s_row[ART_ROW_MAX];
+
+/* Last frame drawn, the reference of diff updates */
+static char s_prev[ART_MAX_COLS * ART_MAX_ROWS];
+static uint32_t s_prev_cols = 0;
+static uint32_t s_prev_rows = 0;
+
+static char s_out[ART_OUT_SIZE];
+static uint32_t s_out_len = 0;
+static int s_out_overflow = 0;
+static int s_out_flush = 1;         /* Write out a full buffer (0: diff frames) */
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
 
-void display_ascii_art(const uint8_t *img, int width, int height,
-                       int ratio, const char *brightness)
+/* Map luma 0-255 to the ramp: dark pixels get dense characters */
+static void build_lut(const char *bstr)
 {
-    int x, y;
-    uint8_t r, g, b;
-    uint8_t Y;
-    const uint8_t *srcPtr;
-    size_t num_chars;
-    const char *bstr;
-    int char_idx;
+    uint32_t num_chars = (uint32_t)strlen(bstr);
 
-    if (img == NULL) {
+    if (s_lut_ramp == bstr) {
         return;
     }
+    for (uint32_t y = 0; y < 256; y++) {
+        s_lut[y] = bstr[(num_chars - 1) - (y * (num_chars - 1)) / 255];
+    }
+    s_lut_ramp = bstr;
+}
 
-    /* Use default brightness if not specified */
-    bstr = (brightness != NULL) ? brightness : BRIGHTNESS_STANDARD;
-    num_chars = strlen(bstr);
+static void out_flush(void)
+{
+    if (s_out_len > 0) {
+        fwrite(s_out, 1, s_out_len, stdout);
+    }
+    s_out_len = 0;
+}
 
-    /* Ensure ratio is at least 1 */
-    if (ratio < 1) {
-        ratio = 1;
-    }
-
-    /* Aspect ratio correction: terminal chars are ~2x taller than wide
-     * So we skip 2x more rows than columns */
-    int x_step = ratio;
-    int y_step = ratio * 2;  /* Compensate for terminal character aspect ratio */
-
-    for (y = 0; y < height; y += y_step) {
-        for (x = 0; x < width; x += x_step) {
-            /* Calculate position in buffer (4 bytes per pixel: R,G,B,0) */
-            srcPtr = img + (y * width + x) * 4;
-            
-            r = srcPtr[0];
-            g = srcPtr[1];
-            b = srcPtr[2];
-
-            /* Improved luminance using BT.601 coefficients (fixed-point) 
-             * Y = 0.299*R + 0.587*G + 0.114*B 
-             * Approximated as: Y = (77*R + 150*G + 29*B) >> 8 */
-            Y = (uint8_t)(((uint16_t)(77 * r) + (uint16_t)(150 * g) + (uint16_t)(29 * b)) >> 8);
-
-            /* Map luminance to character index */
-            char_idx = (Y * (num_chars - 1)) / 255;
-            
-            /* Invert: dark pixels = dense chars, bright pixels = sparse chars */
-            putchar(bstr[(num_chars - 1) - char_idx]);
+static void out_write(const char *data, uint32_t len)
+{
+    uint32_t n;
+
+    while (len > 0) {
+        if (s_out_len == ART_OUT_SIZE) {
+            if (!s_out_flush) {
+                s_out_overflow = 1;
+                return;
+            }
+            out_flush();
+        }
+        n = ART_OUT_SIZE - s_out_len;
+        if (n > len) {
+            n = len;
         }
-        putchar('\n');
+        memcpy(s_out + s_out_len, data, n);
+        s_out_len += n;
+        data += n;
+        len -= n;
     }
 }
 
-void display_ascii_art_from_cnn(const uint32_t *cnn_buffer, int width, int height,
-                                 int ratio)
+/* ANSI cursor move "ESC [ n code" */
+static void out_move(uint32_t n, char code)
 {
-    int x, y;
-    uint8_t r, g, b;
-    uint8_t Y;
-    uint32_t pixel;
-    size_t num_chars;
-    const char *bstr = BRIGHTNESS_STANDARD;
-    int char_idx;
-    int idx;
+    char seq[12];
+    int len = snprintf(seq, sizeof(seq), "\033[%u%c", (unsigned)n, code);
 
-    if (cnn_buffer == NULL) {
-        return;
+    out_write(seq, (uint32_t)len);
+}
+
+/* Characters of one output row: shift-based luma (r + 2g + b) / 4 */
+static void render_row(const cam_frame_view_t *view, uint32_t y, uint32_t ratio, uint32_t cols)
+{
+    const uint32_t *words = (const uint32_t *)cam_view_row(view, y);
+    uint32_t flip = (view->format == CAM_VIEW_CNN) ? 0x00808080U : 0;
+    uint32_t px;
+
+    for (uint32_t c = 0; c < cols; c++) {
+        if (view->format == CAM_VIEW_RGB565) {
+            px = cam_view_rgb(view, c * ratio, y);
+        } else {
+            px = words[c * ratio] ^ flip;
+        }
+        s_row[c] = s_lut[((px & 0xFFU) + ((px >> 7) & 0x1FEU) + ((px >> 16) & 0xFFU)) >> 2];
     }
+}
+
+/* Emit the cells of row r that differ from prev, moving the cursor from
+ * (*cur_r, *cur_c) */
+static void diff_row(const char *prev, uint32_t r, uint32_t cols, uint32_t *cur_r,
+                     uint32_t *cur_c)
+{
+    uint32_t c = 0;
+    uint32_t end;
+    uint32_t gap;
+
+    while (c < cols) {
+        if (s_row[c] == prev[c]) {
+            c++;
+            continue;
+        }
+
+        /* Span of changes, bridging short unchanged runs */
+        end = c + 1;
+        gap = 0;
+        for (uint32_t i = end; i < cols && gap <= ART_DIFF_GAP; i++) {
+            if (s_row[i] != prev[i]) {
+                end = i + 1;
+                gap = 0;
+            } else {
+                gap++;
+            }
+        }
+
+        if (r != *cur_r) {
+            out_write("\r", 1);
+            out_move(r - *cur_r, 'B');
+            *cur_r = r;
+            *cur_c = 0;
+        }
+        if (c > *cur_c) {
+            out_move(c - *cur_c, 'C');
+        } else if (c < *cur_c) {
+            out_write("\r", 1);
+            if (c > 0) {
+                out_move(c, 'C');
+            }
+        }
+        out_write(&s_row[c], end - c);
+        *cur_c = end;
+        c = end;
+    }
+}
 
-    num_chars = strlen(bstr);
+/* Render every ratio-th pixel of every 2*ratio-th row (aspect correction)
+ * into s_out, written with a single fwrite() when the frame fits */
+static void render_view(const cam_frame_view_t *view, int ratio, const char *bstr,
+                        display_art_mode_t mode)
+{
+    uint32_t step;
+    uint32_t cols, rows;
+    uint32_t cur_r = 0, cur_c = 0;
+    int keep, diff;
 
     /* Ensure ratio is at least 1 */
-    if (ratio < 1) {
-        ratio = 1;
-    }
-
-    /* Aspect ratio correction */
-    int x_step = ratio;
-    int y_step = ratio * 2;
-
-    for (y = 0; y < height; y += y_step) {
-        for (x = 0; x < width; x += x_step) {
-            idx = y * width + x;
-            
-            /* CNN buffer format: (B<<16)|(G<<8)|R XOR 0x00808080 */
-            pixel = cnn_buffer[idx] ^ 0x00808080U;
-            r = (uint8_t)(pixel & 0xFF);
-            g = (uint8_t)((pixel >> 8) & 0xFF);
-            b = (uint8_t)((pixel >> 16) & 0xFF);
-
-            /* BT.601 luminance */
-            Y = (uint8_t)(((uint16_t)(77 * r) + (uint16_t)(150 * g) + (uint16_t)(29 * b)) >> 8);
-
-            /* Map luminance to character */
-            char_idx = (Y * (num_chars - 1)) / 255;
-            putchar(bstr[(num_chars - 1) - char_idx]);
+    step = (ratio < 1) ? 1 : (uint32_t)ratio;
+    cols = (view->width + step - 1) / step;
+    rows = (view->height + 2 * step - 1) / (2 * step);
+    if (cols > ART_ROW_MAX) {
+        cols = ART_ROW_MAX;
+    }
+    build_lut(bstr);
+
+    keep = (cols * rows <= sizeof(s_prev));
+    diff = keep && mode == DISPLAY_ART_DIFF && s_prev_cols == cols && s_prev_rows == rows;
+
+    s_out_len = 0;
+    s_out_overflow = 0;
+    s_out_flush = !diff;
+    for (uint32_t r = 0; r < rows; r++) {
+        render_row(view, r * 2 * step, step, cols);
+        if (diff) {
+            diff_row(&s_prev[r * cols], r, cols, &cur_r, &cur_c);
+        } else {
+            out_write(s_row, cols);
+            out_write("\n", 1);
+        }
+        if (keep) {
+            memcpy(&s_prev[r * cols], s_row, cols);
         }
-        putchar('\n');
     }
+
+    if (diff && s_out_overflow) {
+        /* More changes than a full frame: redraw it from s_prev */
+        s_out_len = 0;
+        s_out_flush = 1;
+        for (uint32_t r = 0; r < rows; r++) {
+            out_write(&s_prev[r * cols], cols);
+            out_write("\n", 1);
+        }
+    } else if (diff) {
+        /* Leave the cursor below the frame, as a full frame does */
+        out_write("\r", 1);
+        if (rows > cur_r) {
+            out_move(rows - cur_r, 'B');
+        }
+    }
+    s_out_flush = 1;
+    out_flush();
+    fflush(stdout);
+
+    s_prev_cols = keep ? cols : 0;
+    s_prev_rows = keep ? rows : 0;
 }
 
-void display_ascii_art_detailed(const uint32_t *cnn_buffer, int width, int height,
-                                 int ratio)
+void display_ascii_art(const uint8_t *img, int width, int height,
+                       int ratio, const char *brightness)
 {
-    int x, y;
-    uint8_t r, g, b;
-    uint8_t Y;
-    uint32_t pixel;
-    size_t num_chars;
-    const char *bstr = BRIGHTNESS_EXTENDED;
-    int char_idx;
-    int idx;
+    cam_frame_view_t view;
 
-    if (cnn_buffer == NULL) {
+    if (img == NULL) {
         return;
     }
 
-    num_chars = strlen(bstr);
+    /* R,G,B,0 bytes are the camera's little-endian 32-bit words */
+    view.data = img;
+    view.width = (uint32_t)width;
+    view.height = (uint32_t)height;
+    view.stride = (uint32_t)width * 4;
+    view.format = CAM_VIEW_RGB888;
+
+    /* Use default brightness if not specified */
+    render_view(&view, ratio, (brightness != NULL) ? brightness : BRIGHTNESS_STANDARD,
+                DISPLAY_ART_FULL);
+}
+
+void display_ascii_art_view(const cam_frame_view_t *view, int ratio)
+{
+    display_ascii_art_frame(view, ratio, DISPLAY_ART_FULL);
+}
 
-    if (ratio < 1) {
-        ratio = 1;
+void display_ascii_art_frame(const cam_frame_view_t *view, int ratio,
+                             display_art_mode_t mode)
+{
+    if (view == NULL || view->data == NULL) {
+        return;
     }
 
-    int x_step = ratio;
-    int y_step = ratio * 2;
+    render_view(view, ratio, BRIGHTNESS_STANDARD, mode);
+}
 
-    for (y = 0; y < height; y += y_step) {
-        for (x = 0; x < width; x += x_step) {
-            idx = y * width + x;
-            
-            pixel = cnn_buffer[idx] ^ 0x00808080U;
-            r = (uint8_t)(pixel & 0xFF);
-            g = (uint8_t)((pixel >> 8) & 0xFF);
-            b = (uint8_t)((pixel >> 16) & 0xFF);
+void display_ascii_art_reset(void)
+{
+    s_prev_cols = 0;
+    s_prev_rows = 0;
+}
 
-            Y = (uint8_t)(((uint16_t)(77 * r) + (uint16_t)(150 * g) + (uint16_t)(29 * b)) >> 8);
+void display_ascii_art_from_cnn(const uint32_t *cnn_buffer, int width, int height,
+                                 int ratio)
+{
+    cam_frame_view_t view;
 
-            char_idx = (Y * (num_chars - 1)) / 255;
-            putchar(bstr[(num_chars - 1) - char_idx]);
-        }
-        putchar('\n');
+    if (cnn_buffer == NULL) {
+        return;
     }
+
+    camera_utils_view_cnn(&view, cnn_buffer, (uint32_t)width, (uint32_t)height);
+    render_view(&view, ratio, BRIGHTNESS_STANDARD, DISPLAY_ART_FULL);
+}
+
+void display_ascii_art_detailed(const uint32_t *cnn_buffer, int width, int height,
+                                 int ratio)
+{
+    cam_frame_view_t view;
+
+    if (cnn_buffer == NULL) {
+        return;
+    }
+
+    camera_utils_view_cnn(&view, cnn_buffer, (uint32_t)width, (uint32_t)height);
+    render_view(&view, ratio, BRIGHTNESS_EXTENDED, DISPLAY_ART_FULL);
 }
 
 void display_separator(int width, char ch)
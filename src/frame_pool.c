@@ -0,0 +1,100 @@
+/**
+ * @file    frame_pool.c
+ * @brief   Frame buffer pool implementation for MAX78000 CNN pipelines.
+ */
+
+#include <stddef.h>
+
+#include "frame_pool.h"
+#include "scheduler.h"
+
+/* Platform headers */
+#include "mxc.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static frame_slot_t s_slots[FRAME_POOL_MAX_SLOTS];
+static int s_num_slots = 0;
+static uint32_t s_next_id = 0;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+int frame_pool_init(uint32_t *storage, int slots, uint32_t slot_words)
+{
+    if (storage == NULL || slots < 1 || slots > FRAME_POOL_MAX_SLOTS || slot_words == 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < slots; i++) {
+        s_slots[i].data = storage + (uint32_t)i * slot_words;
+        s_slots[i].words = slot_words;
+        s_slots[i].owners = 0;
+        s_slots[i].frame_id = 0;
+    }
+    s_num_slots = slots;
+    s_next_id = 0;
+
+    return 0;
+}
+
+frame_slot_t *frame_pool_acquire(uint32_t owners)
+{
+    frame_slot_t *slot = NULL;
+
+    __disable_irq();
+    for (int i = 0; i < s_num_slots; i++) {
+        /* Oldest free frame first, so slots rotate */
+        if (s_slots[i].owners == 0 &&
+            (slot == NULL || s_slots[i].frame_id < slot->frame_id)) {
+            slot = &s_slots[i];
+        }
+    }
+    if (slot != NULL) {
+        slot->owners = owners;
+        slot->frame_id = ++s_next_id;
+    }
+    __enable_irq();
+
+    return slot;
+}
+
+frame_slot_t *frame_pool_acquire_wait(uint32_t owners)
+{
+    frame_slot_t *slot;
+
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    while ((slot = frame_pool_acquire(owners)) == NULL) {
+        SCHED_SLEEP_WHILE(frame_pool_free_count() == 0);
+    }
+
+    return slot;
+}
+
+void frame_pool_hand_off(frame_slot_t *slot, uint32_t from, uint32_t to)
+{
+    __disable_irq();
+    slot->owners = (slot->owners & ~from) | to;
+    __enable_irq();
+}
+
+void frame_pool_release(frame_slot_t *slot, uint32_t owner)
+{
+    frame_pool_hand_off(slot, owner, 0);
+}
+
+int frame_pool_free_count(void)
+{
+    int count = 0;
+
+    for (int i = 0; i < s_num_slots; i++) {
+        if (s_slots[i].owners == 0) {
+            count++;
+        }
+    }
+
+    return count;
+}
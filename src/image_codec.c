@@ -0,0 +1,622 @@
+/**
+ * @file    image_codec.c
+ * @brief   Image compression implementation for MAX78000 CNN projects.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "image_codec.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Encoded bytes are batched before calling the sink */
+#define OUT_BUF_SIZE        64
+
+/* DRLE limits */
+#define RLE_MAX_LITERAL     128
+#define RLE_MIN_RUN         3
+#define RLE_MAX_RUN         130
+
+/* Integer forward DCT (IJG "islow") constants, 13-bit fixed point */
+#define CONST_BITS          13
+#define PASS1_BITS          2
+#define FIX_0_298631336     2446
+#define FIX_0_390180644     3196
+#define FIX_0_541196100     4433
+#define FIX_0_765366865     6270
+#define FIX_0_899976223     7373
+#define FIX_1_175875602     9633
+#define FIX_1_501321110     12299
+#define FIX_1_847759065     15137
+#define FIX_1_961570560     16069
+#define FIX_2_053119869     16819
+#define FIX_2_562915447     20995
+#define FIX_3_072711026     25172
+#define DESCALE(x, n)       (((x) + (1 << ((n) - 1))) >> (n))
+
+typedef struct {
+    image_codec_sink_t sink;
+    void *ctx;
+    uint8_t buf[OUT_BUF_SIZE];
+    uint32_t len;
+} out_stream_t;
+
+typedef struct {
+    out_stream_t out;
+    uint32_t bitbuf;
+    int bitcnt;
+    int prev_dc[3];
+    uint16_t qdiv[2][64];       /* 8 * quantizer, natural order (FDCT is scaled by 8) */
+} jpeg_state_t;
+
+typedef struct {
+    uint16_t code;
+    uint8_t size;
+} huff_code_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* Zigzag position -> natural (row-major) index */
+static const uint8_t zigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/* ITU T.81 Annex K quantization tables, natural order */
+static const uint8_t std_qt_luma[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+static const uint8_t std_qt_chroma[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+/* ITU T.81 Annex K Huffman tables: code counts per length 1..16, then values */
+static const uint8_t dc_luma_bits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+static const uint8_t dc_chroma_bits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+static const uint8_t dc_vals[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+
+static const uint8_t ac_luma_bits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+static const uint8_t ac_luma_vals[162] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static const uint8_t ac_chroma_bits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+static const uint8_t ac_chroma_vals[162] = {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+/* Code tables derived from the above on first use, indexed by symbol */
+static huff_code_t s_dc_codes[2][12];
+static huff_code_t s_ac_codes[2][256];
+static int s_huff_ready = 0;
+
+/*******************************************************************************
+ * Output
+ ******************************************************************************/
+
+static void out_flush(out_stream_t *out)
+{
+    if (out->len > 0) {
+        out->sink(out->ctx, out->buf, out->len);
+        out->len = 0;
+    }
+}
+
+static void out_byte(out_stream_t *out, uint8_t b)
+{
+    out->buf[out->len++] = b;
+    if (out->len == OUT_BUF_SIZE) {
+        out_flush(out);
+    }
+}
+
+static void out_bytes(out_stream_t *out, const uint8_t *data, uint32_t len)
+{
+    while (len-- > 0) {
+        out_byte(out, *data++);
+    }
+}
+
+static void out_be16(out_stream_t *out, uint32_t v)
+{
+    out_byte(out, (uint8_t)(v >> 8));
+    out_byte(out, (uint8_t)(v & 0xFF));
+}
+
+/*******************************************************************************
+ * Delta + RLE
+ ******************************************************************************/
+
+static void rle_flush_literals(out_stream_t *out, uint8_t *lit, int *lit_n)
+{
+    if (*lit_n > 0) {
+        out_byte(out, (uint8_t)(*lit_n - 1));
+        out_bytes(out, lit, (uint32_t)*lit_n);
+        *lit_n = 0;
+    }
+}
+
+/* Close the pending run: long runs are coded, short ones become literals */
+static void rle_end_run(out_stream_t *out, uint8_t *lit, int *lit_n,
+                        uint8_t run_val, int run_n)
+{
+    if (run_n >= RLE_MIN_RUN) {
+        rle_flush_literals(out, lit, lit_n);
+        out_byte(out, (uint8_t)(0x80 | (run_n - RLE_MIN_RUN)));
+        out_byte(out, run_val);
+        return;
+    }
+
+    while (run_n-- > 0) {
+        lit[(*lit_n)++] = run_val;
+        if (*lit_n == RLE_MAX_LITERAL) {
+            rle_flush_literals(out, lit, lit_n);
+        }
+    }
+}
+
+static void encode_drle(out_stream_t *out, const uint32_t *cnn_buffer, int num_pixels)
+{
+    uint8_t lit[RLE_MAX_LITERAL];
+    int lit_n = 0;
+    uint8_t run_val = 0;
+    int run_n = 0;
+    uint8_t prev;
+    uint8_t cur;
+    uint8_t d;
+
+    /* One plane per channel (R, G, B) keeps smooth gradients as runs */
+    for (int shift = 0; shift < 24; shift += 8) {
+        prev = 0;
+        for (int i = 0; i < num_pixels; i++) {
+            cur = (uint8_t)(((cnn_buffer[i] ^ 0x00808080U) >> shift) & 0xFF);
+            d = (uint8_t)(cur - prev);
+            prev = cur;
+
+            if (run_n > 0 && d == run_val && run_n < RLE_MAX_RUN) {
+                run_n++;
+                continue;
+            }
+            rle_end_run(out, lit, &lit_n, run_val, run_n);
+            run_val = d;
+            run_n = 1;
+        }
+    }
+
+    rle_end_run(out, lit, &lit_n, run_val, run_n);
+    rle_flush_literals(out, lit, &lit_n);
+}
+
+/*******************************************************************************
+ * Baseline JPEG
+ ******************************************************************************/
+
+static void huff_build(huff_code_t *codes, const uint8_t *bits, const uint8_t *vals)
+{
+    uint16_t code = 0;
+    int k = 0;
+
+    for (int len = 1; len <= 16; len++) {
+        for (int i = 0; i < bits[len - 1]; i++) {
+            codes[vals[k]].code = code++;
+            codes[vals[k]].size = (uint8_t)len;
+            k++;
+        }
+        code <<= 1;
+    }
+}
+
+static void huff_init(void)
+{
+    if (s_huff_ready) {
+        return;
+    }
+
+    huff_build(s_dc_codes[0], dc_luma_bits, dc_vals);
+    huff_build(s_dc_codes[1], dc_chroma_bits, dc_vals);
+    huff_build(s_ac_codes[0], ac_luma_bits, ac_luma_vals);
+    huff_build(s_ac_codes[1], ac_chroma_bits, ac_chroma_vals);
+    s_huff_ready = 1;
+}
+
+static void put_bits(jpeg_state_t *st, uint32_t value, int size)
+{
+    uint8_t b;
+
+    st->bitbuf = (st->bitbuf << size) | (value & ((1U << size) - 1));
+    st->bitcnt += size;
+
+    while (st->bitcnt >= 8) {
+        b = (uint8_t)(st->bitbuf >> (st->bitcnt - 8));
+        out_byte(&st->out, b);
+        if (b == 0xFF) {
+            out_byte(&st->out, 0x00);  /* Byte stuffing */
+        }
+        st->bitcnt -= 8;
+    }
+}
+
+static void put_huff(jpeg_state_t *st, const huff_code_t *hc)
+{
+    put_bits(st, hc->code, hc->size);
+}
+
+/* Number of bits needed for |v| (JPEG magnitude category) */
+static int bit_length(int v)
+{
+    int n = 0;
+
+    if (v < 0) {
+        v = -v;
+    }
+    while (v) {
+        n++;
+        v >>= 1;
+    }
+    return n;
+}
+
+static void fdct_islow(int32_t *data)
+{
+    int32_t tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+    int32_t tmp10, tmp11, tmp12, tmp13;
+    int32_t z1, z2, z3, z4, z5;
+    int32_t *p;
+
+    /* Pass 1: rows, result scaled up by 2^PASS1_BITS */
+    for (p = data; p < data + 64; p += 8) {
+        tmp0 = p[0] + p[7];
+        tmp7 = p[0] - p[7];
+        tmp1 = p[1] + p[6];
+        tmp6 = p[1] - p[6];
+        tmp2 = p[2] + p[5];
+        tmp5 = p[2] - p[5];
+        tmp3 = p[3] + p[4];
+        tmp4 = p[3] - p[4];
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        p[0] = (tmp10 + tmp11) << PASS1_BITS;
+        p[4] = (tmp10 - tmp11) << PASS1_BITS;
+
+        z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        p[2] = DESCALE(z1 + tmp13 * FIX_0_765366865, CONST_BITS - PASS1_BITS);
+        p[6] = DESCALE(z1 - tmp12 * FIX_1_847759065, CONST_BITS - PASS1_BITS);
+
+        z1 = tmp4 + tmp7;
+        z2 = tmp5 + tmp6;
+        z3 = tmp4 + tmp6;
+        z4 = tmp5 + tmp7;
+        z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        p[7] = DESCALE(tmp4 + z1 + z3, CONST_BITS - PASS1_BITS);
+        p[5] = DESCALE(tmp5 + z2 + z4, CONST_BITS - PASS1_BITS);
+        p[3] = DESCALE(tmp6 + z2 + z3, CONST_BITS - PASS1_BITS);
+        p[1] = DESCALE(tmp7 + z1 + z4, CONST_BITS - PASS1_BITS);
+    }
+
+    /* Pass 2: columns, output is 8x the true DCT coefficients */
+    for (p = data; p < data + 8; p++) {
+        tmp0 = p[0] + p[56];
+        tmp7 = p[0] - p[56];
+        tmp1 = p[8] + p[48];
+        tmp6 = p[8] - p[48];
+        tmp2 = p[16] + p[40];
+        tmp5 = p[16] - p[40];
+        tmp3 = p[24] + p[32];
+        tmp4 = p[24] - p[32];
+
+        tmp10 = tmp0 + tmp3;
+        tmp13 = tmp0 - tmp3;
+        tmp11 = tmp1 + tmp2;
+        tmp12 = tmp1 - tmp2;
+
+        p[0] = DESCALE(tmp10 + tmp11, PASS1_BITS);
+        p[32] = DESCALE(tmp10 - tmp11, PASS1_BITS);
+
+        z1 = (tmp12 + tmp13) * FIX_0_541196100;
+        p[16] = DESCALE(z1 + tmp13 * FIX_0_765366865, CONST_BITS + PASS1_BITS);
+        p[48] = DESCALE(z1 - tmp12 * FIX_1_847759065, CONST_BITS + PASS1_BITS);
+
+        z1 = tmp4 + tmp7;
+        z2 = tmp5 + tmp6;
+        z3 = tmp4 + tmp6;
+        z4 = tmp5 + tmp7;
+        z5 = (z3 + z4) * FIX_1_175875602;
+
+        tmp4 *= FIX_0_298631336;
+        tmp5 *= FIX_2_053119869;
+        tmp6 *= FIX_3_072711026;
+        tmp7 *= FIX_1_501321110;
+        z1 *= -FIX_0_899976223;
+        z2 *= -FIX_2_562915447;
+        z3 = z3 * -FIX_1_961570560 + z5;
+        z4 = z4 * -FIX_0_390180644 + z5;
+
+        p[56] = DESCALE(tmp4 + z1 + z3, CONST_BITS + PASS1_BITS);
+        p[40] = DESCALE(tmp5 + z2 + z4, CONST_BITS + PASS1_BITS);
+        p[24] = DESCALE(tmp6 + z2 + z3, CONST_BITS + PASS1_BITS);
+        p[8] = DESCALE(tmp7 + z1 + z4, CONST_BITS + PASS1_BITS);
+    }
+}
+
+/* Transform, quantize and entropy-code one 8x8 block (level-shifted samples) */
+static void encode_block(jpeg_state_t *st, int32_t *block, int comp)
+{
+    const uint16_t *qdiv = st->qdiv[comp == 0 ? 0 : 1];
+    const huff_code_t *dc = s_dc_codes[comp == 0 ? 0 : 1];
+    const huff_code_t *ac = s_ac_codes[comp == 0 ? 0 : 1];
+    int32_t v;
+    int q[64];
+    int diff;
+    int nbits;
+    int run = 0;
+    int last_nz = 0;
+
+    fdct_islow(block);
+
+    /* Quantize in zigzag order with rounding to nearest */
+    for (int k = 0; k < 64; k++) {
+        int div = qdiv[zigzag[k]];
+
+        v = block[zigzag[k]];
+        q[k] = (v >= 0) ? (v + div / 2) / div : -((-v + div / 2) / div);
+        if (q[k] != 0) {
+            last_nz = k;
+        }
+    }
+
+    /* DC: difference to previous block of the same component */
+    diff = q[0] - st->prev_dc[comp];
+    st->prev_dc[comp] = q[0];
+    nbits = bit_length(diff);
+    put_huff(st, &dc[nbits]);
+    if (nbits) {
+        put_bits(st, (uint32_t)(diff < 0 ? diff - 1 : diff), nbits);
+    }
+
+    /* AC: (run, size) symbols, ZRL for 16 zeros, EOB after the last non-zero */
+    for (int k = 1; k <= last_nz; k++) {
+        if (q[k] == 0) {
+            run++;
+            continue;
+        }
+        while (run > 15) {
+            put_huff(st, &ac[0xF0]);
+            run -= 16;
+        }
+        nbits = bit_length(q[k]);
+        put_huff(st, &ac[(run << 4) | nbits]);
+        put_bits(st, (uint32_t)(q[k] < 0 ? q[k] - 1 : q[k]), nbits);
+        run = 0;
+    }
+    if (last_nz < 63) {
+        put_huff(st, &ac[0x00]);
+    }
+}
+
+static void jpeg_write_dht(out_stream_t *out, int tc_th, const uint8_t *bits,
+                           const uint8_t *vals, int nvals)
+{
+    out_be16(out, 0xFFC4);
+    out_be16(out, (uint32_t)(2 + 1 + 16 + nvals));
+    out_byte(out, (uint8_t)tc_th);
+    out_bytes(out, bits, 16);
+    out_bytes(out, vals, (uint32_t)nvals);
+}
+
+static void jpeg_write_headers(jpeg_state_t *st, int width, int height,
+                               const uint8_t qt[2][64])
+{
+    static const uint8_t app0[] = {
+        0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01,
+        0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00
+    };
+    out_stream_t *out = &st->out;
+
+    out_be16(out, 0xFFD8);                  /* SOI */
+    out_bytes(out, app0, sizeof(app0));
+
+    /* DQT: both tables in zigzag order */
+    out_be16(out, 0xFFDB);
+    out_be16(out, 2 + 2 * 65);
+    for (int t = 0; t < 2; t++) {
+        out_byte(out, (uint8_t)t);
+        for (int k = 0; k < 64; k++) {
+            out_byte(out, qt[t][zigzag[k]]);
+        }
+    }
+
+    /* SOF0: 8-bit, 3 components, Y 2x2, Cb/Cr 1x1 */
+    out_be16(out, 0xFFC0);
+    out_be16(out, 8 + 3 * 3);
+    out_byte(out, 8);
+    out_be16(out, (uint32_t)height);
+    out_be16(out, (uint32_t)width);
+    out_byte(out, 3);
+    out_byte(out, 1); out_byte(out, 0x22); out_byte(out, 0);
+    out_byte(out, 2); out_byte(out, 0x11); out_byte(out, 1);
+    out_byte(out, 3); out_byte(out, 0x11); out_byte(out, 1);
+
+    jpeg_write_dht(out, 0x00, dc_luma_bits, dc_vals, 12);
+    jpeg_write_dht(out, 0x10, ac_luma_bits, ac_luma_vals, 162);
+    jpeg_write_dht(out, 0x01, dc_chroma_bits, dc_vals, 12);
+    jpeg_write_dht(out, 0x11, ac_chroma_bits, ac_chroma_vals, 162);
+
+    /* SOS */
+    out_be16(out, 0xFFDA);
+    out_be16(out, 6 + 2 * 3);
+    out_byte(out, 3);
+    out_byte(out, 1); out_byte(out, 0x00);
+    out_byte(out, 2); out_byte(out, 0x11);
+    out_byte(out, 3); out_byte(out, 0x11);
+    out_byte(out, 0);
+    out_byte(out, 63);
+    out_byte(out, 0);
+}
+
+static void encode_jpeg(jpeg_state_t *st, const uint32_t *cnn_buffer,
+                        int width, int height, int quality)
+{
+    uint8_t qt[2][64];
+    int32_t yblk[4][64];
+    int32_t cb[64];
+    int32_t cr[64];
+    int scale;
+    int t;
+
+    huff_init();
+
+    /* IJG quality scaling */
+    if (quality < 1) {
+        quality = 1;
+    } else if (quality > 100) {
+        quality = 100;
+    }
+    scale = (quality < 50) ? (5000 / quality) : (200 - 2 * quality);
+    for (int i = 0; i < 64; i++) {
+        t = (std_qt_luma[i] * scale + 50) / 100;
+        qt[0][i] = (uint8_t)(t < 1 ? 1 : (t > 255 ? 255 : t));
+        t = (std_qt_chroma[i] * scale + 50) / 100;
+        qt[1][i] = (uint8_t)(t < 1 ? 1 : (t > 255 ? 255 : t));
+        st->qdiv[0][i] = (uint16_t)(qt[0][i] << 3);
+        st->qdiv[1][i] = (uint16_t)(qt[1][i] << 3);
+    }
+
+    jpeg_write_headers(st, width, height, (const uint8_t (*)[64])qt);
+
+    /* 16x16 MCUs; edge pixels are replicated for partial MCUs */
+    for (int my = 0; my < height; my += 16) {
+        for (int mx = 0; mx < width; mx += 16) {
+            memset(cb, 0, sizeof(cb));
+            memset(cr, 0, sizeof(cr));
+
+            for (int y = 0; y < 16; y++) {
+                int sy = (my + y < height) ? my + y : height - 1;
+
+                for (int x = 0; x < 16; x++) {
+                    int sx = (mx + x < width) ? mx + x : width - 1;
+                    uint32_t pixel = cnn_buffer[sy * width + sx] ^ 0x00808080U;
+                    int r = (int)(pixel & 0xFF);
+                    int g = (int)((pixel >> 8) & 0xFF);
+                    int b = (int)((pixel >> 16) & 0xFF);
+                    int ci = (y >> 1) * 8 + (x >> 1);
+
+                    /* BT.601 full-range YCbCr, level-shifted by -128 */
+                    yblk[((y >> 3) << 1) | (x >> 3)][(y & 7) * 8 + (x & 7)] =
+                        ((77 * r + 150 * g + 29 * b + 128) >> 8) - 128;
+                    cb[ci] += (-43 * r - 85 * g + 128 * b);
+                    cr[ci] += (128 * r - 107 * g - 21 * b);
+                }
+            }
+
+            /* 2x2 chroma average: four samples, each scaled by 256 */
+            for (int i = 0; i < 64; i++) {
+                cb[i] = (cb[i] + 512) >> 10;
+                cr[i] = (cr[i] + 512) >> 10;
+            }
+
+            for (int i = 0; i < 4; i++) {
+                encode_block(st, yblk[i], 0);
+            }
+            encode_block(st, cb, 1);
+            encode_block(st, cr, 2);
+        }
+    }
+
+    /* Pad the last byte with 1-bits, then EOI */
+    if (st->bitcnt > 0) {
+        put_bits(st, 0x7F, 8 - st->bitcnt);
+    }
+    out_be16(&st->out, 0xFFD9);
+}
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+int image_codec_encode(image_codec_t codec, const uint32_t *cnn_buffer,
+                       int width, int height, int quality,
+                       image_codec_sink_t sink, void *ctx)
+{
+    jpeg_state_t st;
+
+    if (cnn_buffer == NULL || sink == NULL || width <= 0 || height <= 0) {
+        return -1;
+    }
+
+    memset(&st, 0, sizeof(st));
+    st.out.sink = sink;
+    st.out.ctx = ctx;
+
+    switch (codec) {
+    case IMAGE_CODEC_DRLE:
+        encode_drle(&st.out, cnn_buffer, width * height);
+        break;
+
+    case IMAGE_CODEC_JPEG:
+        encode_jpeg(&st, cnn_buffer, width, height, quality);
+        break;
+
+    default:
+        return -1;
+    }
+
+    out_flush(&st.out);
+
+    return 0;
+}
@@ -3,6 +3,7 @@
  * @brief   CNN inference utilities implementation for MAX78000 projects.
  */
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -10,7 +11,29 @@
 #include "mxc.h"
 
 #include "inference_utils.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "app_config.h"
 #include "cnn.h"
+#include "cnn_network.h"
+#if INFERENCE_WEIGHT_DMA_ENABLE || INFERENCE_FIFO_DMA_ENABLE
+#include "dma.h"
+#endif
+#if INFERENCE_WEIGHT_DMA_ENABLE && !CNN_NETWORK_TABLE_ENABLE
+#include "weights.h"
+#endif
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* CNN FIFO registers */
+#define CNN_FIFO_STAT       ((volatile uint32_t *)0x50000004)
+#define CNN_FIFO_DATA       ((volatile uint32_t *)0x50000008)
+
+#if INFERENCE_FIFO_DMA_ENABLE && !defined(INFERENCE_FIFO_DMA_REQSEL)
+#error "INFERENCE_FIFO_DMA_ENABLE needs INFERENCE_FIFO_DMA_REQSEL (CNN FIFO DMA request)"
+#endif
 
 /*******************************************************************************
  * Variables
@@ -19,20 +42,249 @@
 /* Define cnn_time here - declared extern in cnn.h, used by CNN ISR */
 volatile uint32_t cnn_time;
 
+/* Set once weights and biases are in CNN SRAM, cleared when power is removed */
+static int s_weights_loaded = 0;
+
+/* CNN clock source and divider, applied by cold_start() */
+static uint32_t s_cnn_clksel = MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK;
+static uint32_t s_cnn_clkdiv = MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV1;
+
+/* Network programmed by configure() */
+static const cnn_network_t *s_network = &cnn_network_default;
+
+#if CNN_NETWORK_TABLE_ENABLE
+/* Networks with weights in CNN SRAM, s_network is one of them */
+static const cnn_network_t *s_models[INFERENCE_MAX_MODELS] = { &cnn_network_default };
+static int s_num_models = 1;
+static int s_model = 0;
+#endif
+
+/* Called from the CNN interrupt after CNN_ISR() */
+static void (*s_done_callback)(void) = NULL;
+
+/* DMA FIFO load */
+static int s_fifo_dma_ch = -1;
+static volatile int s_fifo_dma_busy = 0;
+static void (*s_fifo_dma_callback)(void) = NULL;
+
+/* Slot loaded by inference_start_slot(), released when the FIFO has it */
+static frame_slot_t *volatile s_loading_slot = NULL;
+
+/* Batch in progress (inference_run_batch), advanced by the CNN interrupt */
+static inference_result_t *s_batch_results = NULL;
+static int s_batch_count = 0;
+static volatile int s_batch_started = 0;
+static volatile int s_batch_done = 0;
+
+#if CNN_NUM_OUTPUTS == 2
+/* softmax_q17p14_q15() of two outputs, indexed by (margin + 8191) >> 14:
+ * { top, runner-up } in Q15. Margins of 16 << 14 and more give { 32767, 0 }. */
+static const q15_t s_binary_softmax[17][2] = {
+    { 16384, 16384 }, { 21845, 10922 }, { 26214, 6553 }, { 29127, 3640 },
+    { 30840, 1927 },  { 31775, 992 },   { 32263, 504 },  { 32513, 254 },
+    { 32640, 127 },   { 32704, 63 },    { 32736, 31 },   { 32752, 15 },
+    { 32760, 7 },     { 32764, 3 },     { 32766, 1 },    { 32767, 0 },
+    { 32767, 0 }
+};
+#endif
+
+#if INFERENCE_WEIGHT_DMA_ENABLE && !CNN_NETWORK_TABLE_ENABLE
+/* Same table as cnn.c; cnn_load_weights() is then unreferenced, so only this
+ * copy is linked */
+static const uint32_t s_kernels[] = KERNELS;
+#endif
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
 
-inference_status_t inference_init(void)
+/* Defined in the generated cnn.c */
+void CNN_ISR(void);
+
+/**
+ * @brief   Stop the state machines and set the layer count.
+ */
+static void init_state(void)
 {
-    /* Enable peripheral, enable CNN interrupt, turn on CNN clock
-     * CNN clock: APB (50 MHz) div 1 */
-    cnn_enable(MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK, MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV1);
+#if CNN_NETWORK_TABLE_ENABLE
+    cnn_network_init(s_network);
+#else
+    cnn_init();
+#endif
+}
+
+/**
+ * @brief   Program the accelerator registers (after init_state()).
+ */
+static void configure(void)
+{
+#if CNN_NETWORK_TABLE_ENABLE
+    cnn_network_configure(s_network);
+#else
+    cnn_configure();
+#endif
+}
 
-    cnn_init();          /* Bring state machine into consistent state */
+static void unload(uint32_t *out)
+{
+#if CNN_NETWORK_TABLE_ENABLE
+    cnn_network_unload(s_network, out);
+#else
+    cnn_unload(out);
+#endif
+}
+
+static void cnn_done_isr(void)
+{
+    CNN_ISR();
+
+    if (s_batch_results != NULL) {
+        /* Output memory is reused by the next frame: unload, then restart */
+        unload((uint32_t *)s_batch_results[s_batch_done].raw_output);
+        s_batch_results[s_batch_done].inference_time_us = cnn_time;
+        s_batch_done++;
+
+        if (s_batch_done < s_batch_count) {
+            cnn_start();
+            s_batch_started++;
+            return;
+        }
+    }
+
+    if (s_done_callback != NULL) {
+        s_done_callback();
+    }
+}
+
+#if INFERENCE_WEIGHT_DMA_ENABLE
+/**
+ * @brief   Load kernels with memory-to-memory DMA, one block per transfer.
+ *
+ * Same record walk as cnn_load_weights(): {address, count, words...},
+ * terminated by a zero address. The CPU only writes the address-set byte
+ * per block. Without a free DMA channel the words are copied by the CPU.
+ */
+static void load_weights_dma(const uint32_t *kernels)
+{
+    mxc_dma_config_t config;
+    mxc_dma_srcdst_t srcdst;
+    volatile uint32_t *addr;
+    const uint32_t *ptr = kernels;
+    uint32_t len;
+    int ch;
+
+    ch = MXC_DMA_AcquireChannel();
+
+    config.ch = ch;
+    config.reqsel = MXC_DMA_REQUEST_MEMTOMEM;
+    config.srcwd = MXC_DMA_WIDTH_WORD;
+    config.dstwd = MXC_DMA_WIDTH_WORD;
+    config.srcinc_en = 1;
+    config.dstinc_en = 1;
+
+    while ((addr = (volatile uint32_t *)*ptr++) != 0) {
+        *((volatile uint8_t *)((uint32_t)addr | 1)) = 0x01; /* Set address */
+        len = *ptr++;
+
+        if (ch < 0) {
+            memcpy32((uint32_t *)addr, ptr, (int)len);
+            ptr += len;
+            continue;
+        }
+
+        srcdst.ch = ch;
+        srcdst.source = (void *)ptr;
+        srcdst.dest = (void *)addr;
+        srcdst.len = (int)(len * sizeof(uint32_t));
+        MXC_DMA_ConfigChannel(config, srcdst);
+        MXC_DMA_Start(ch);
+
+        while ((MXC_DMA->ch[ch].status & MXC_F_DMA_STATUS_STATUS) != 0) {
+            /* wait for the block */
+        }
+        MXC_DMA_ChannelClearFlags(ch, MXC_DMA_ChannelGetFlags(ch));
+
+        ptr += len;
+    }
+
+    if (ch >= 0) {
+        MXC_DMA_ReleaseChannel(ch);
+    }
+}
+#endif
+
+#if INFERENCE_FIFO_DMA_ENABLE
+/* Runs from the DMA interrupt when the last word has gone to the FIFO */
+static void fifo_dma_callback(int ch, int err)
+{
+    (void)ch;
+    (void)err;
+
+    s_fifo_dma_busy = 0;
+    if (s_fifo_dma_callback != NULL) {
+        s_fifo_dma_callback();
+    }
+}
+
+static void fifo_dma_isr(void)
+{
+    MXC_DMA_Handler();
+}
+#endif
+
+#if CNN_NETWORK_TABLE_ENABLE
+/**
+ * @brief   Load one network's kernels and biases at their own offsets.
+ */
+static void load_model(const cnn_network_t *net)
+{
+#if INFERENCE_WEIGHT_DMA_ENABLE
+    load_weights_dma(net->kernels);
+#else
+    cnn_network_load_weights(net);
+#endif
+    cnn_network_load_bias(net);
+}
+#endif
+
+/**
+ * @brief   Power up the CNN and load every network (cold start).
+ */
+static void cold_start(void)
+{
+    /* Enable peripheral, enable CNN interrupt, turn on CNN clock
+     * CNN clock: APB (50 MHz) div 1 unless inference_set_clock() chose another */
+    cnn_enable(s_cnn_clksel, s_cnn_clkdiv);
+    MXC_NVIC_SetVector(CNN_IRQn, cnn_done_isr);  /* Wrap CNN_ISR for the callback */
+
+    init_state();        /* Bring state machine into consistent state */
+#if CNN_NETWORK_TABLE_ENABLE
+    for (int i = 0; i < s_num_models; i++) {
+        load_model(s_models[i]);    /* Load kernels and biases */
+    }
+#else
+#if INFERENCE_WEIGHT_DMA_ENABLE
+    load_weights_dma(s_kernels);    /* Load kernels */
+#else
     cnn_load_weights();  /* Load kernels */
+#endif
     cnn_load_bias();     /* Load biases */
-    cnn_configure();     /* Configure state machine */
+#endif
+    configure();         /* Configure state machine */
+
+    s_weights_loaded = 1;
+}
+
+inference_status_t inference_init(void)
+{
+    /* Results hold CNN_NUM_OUTPUTS words */
+    if (s_network->output_words != CNN_NUM_OUTPUTS) {
+        printf("Network %s has %u outputs, built for %d\n", s_network->name,
+               (unsigned)s_network->output_words, CNN_NUM_OUTPUTS);
+        return INFERENCE_ERROR;
+    }
+
+    cold_start();
 
     return INFERENCE_OK;
 }
@@ -44,12 +296,117 @@ void inference_load_input(const uint32_t *input_data, uint32_t num_words)
 
     for (i = 0; i < num_words; i++) {
         /* Wait for FIFO not full */
-        while (((*((volatile uint32_t *)0x50000004) & 1)) != 0) {
+        while ((*CNN_FIFO_STAT & 1) != 0) {
             /* spin */
         }
         /* Write to CNN FIFO register */
-        *((volatile uint32_t *)0x50000008) = *in++;
+        *CNN_FIFO_DATA = *in++;
+    }
+}
+
+int inference_fifo_dma_init(int dma_channel)
+{
+#if INFERENCE_FIFO_DMA_ENABLE
+    if (dma_channel < 0) {
+        return -1;
+    }
+    s_fifo_dma_ch = dma_channel;
+
+    MXC_DMA_SetCallback(s_fifo_dma_ch, fifo_dma_callback);
+    MXC_NVIC_SetVector(MXC_DMA_CH_GET_IRQ(s_fifo_dma_ch), fifo_dma_isr);
+    NVIC_EnableIRQ(MXC_DMA_CH_GET_IRQ(s_fifo_dma_ch));
+
+    return 0;
+#else
+    (void)dma_channel;
+    return -1;
+#endif
+}
+
+inference_status_t inference_load_input_dma(const uint32_t *input_data, uint32_t num_words,
+                                            void (*callback)(void))
+{
+#if INFERENCE_FIFO_DMA_ENABLE
+    mxc_dma_config_t config;
+    mxc_dma_srcdst_t srcdst;
+#endif
+
+    if (input_data == NULL || s_fifo_dma_busy) {
+        return INFERENCE_ERROR;
+    }
+
+#if INFERENCE_FIFO_DMA_ENABLE
+    if (s_fifo_dma_ch >= 0) {
+        config.ch = s_fifo_dma_ch;
+        config.reqsel = INFERENCE_FIFO_DMA_REQSEL;
+        config.srcwd = MXC_DMA_WIDTH_WORD;
+        config.dstwd = MXC_DMA_WIDTH_WORD;
+        config.srcinc_en = 1;
+        config.dstinc_en = 0;
+
+        srcdst.ch = s_fifo_dma_ch;
+        srcdst.source = (void *)input_data;
+        srcdst.dest = (void *)CNN_FIFO_DATA;
+        srcdst.len = (int)(num_words * sizeof(uint32_t));
+
+        s_fifo_dma_callback = callback;
+        s_fifo_dma_busy = 1;
+
+        MXC_DMA_ConfigChannel(config, srcdst);
+        MXC_DMA_EnableInt(s_fifo_dma_ch);
+        MXC_DMA_SetChannelInterruptEn(s_fifo_dma_ch, 0, 1);  /* Count-to-zero */
+        MXC_DMA_Start(s_fifo_dma_ch);
+
+        return INFERENCE_OK;
+    }
+#endif
+
+    /* No DMA channel: CPU copy */
+    inference_load_input(input_data, num_words);
+    if (callback != NULL) {
+        callback();
+    }
+
+    return INFERENCE_OK;
+}
+
+/* Runs when the slot's last word is in the FIFO */
+static void slot_loaded(void)
+{
+    frame_slot_t *slot = s_loading_slot;
+
+    s_loading_slot = NULL;
+    if (slot != NULL) {
+        frame_pool_release(slot, FRAME_OWNER_INFER);
+    }
+}
+
+inference_status_t inference_start_slot(frame_slot_t *slot, uint32_t num_words)
+{
+    if (slot == NULL || num_words > slot->words || s_loading_slot != NULL) {
+        return INFERENCE_ERROR;
+    }
+
+    inference_start();
+    s_loading_slot = slot;
+    if (inference_load_input_dma(slot->data, num_words, slot_loaded) != INFERENCE_OK) {
+        s_loading_slot = NULL;
+        inference_abort();
+        return INFERENCE_ERROR;
     }
+
+    return INFERENCE_OK;
+}
+
+int inference_load_input_busy(void)
+{
+    return s_fifo_dma_busy;
+}
+
+void inference_load_input_wait(void)
+{
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk; /* Ensure SLEEPDEEP=0 */
+    SCHED_SLEEP_WHILE(s_fifo_dma_busy);
 }
 
 inference_status_t inference_run(inference_result_t *result)
@@ -71,33 +428,55 @@ void inference_start(void)
     cnn_time = 0;
 
     /* Start CNN processing */
+    PROFILE_BEGIN(PROFILE_STAGE_CNN);
     cnn_start();
 }
 
-inference_status_t inference_wait(inference_result_t *result)
+/**
+ * @brief   Argmax of raw_output and its margin over the runner-up.
+ */
+static void classify_logits(inference_result_t *result)
 {
     int i;
-    int max_idx = 0;
-    q15_t max_val = 0;
+    int top = 0;
+    int32_t second = INT32_MIN;
 
-    if (result == NULL) {
-        return INFERENCE_ERROR;
+    for (i = 1; i < CNN_NUM_OUTPUTS; i++) {
+        if (result->raw_output[i] > result->raw_output[top]) {
+            second = result->raw_output[top];
+            top = i;
+        } else if (result->raw_output[i] > second) {
+            second = result->raw_output[i];
+        }
     }
 
-    /* Wait for CNN to finish (cnn_time set by ISR) */
-    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk; /* Ensure SLEEPDEEP=0 */
-    while (cnn_time == 0) {
-        __WFI();
-    }
+    result->predicted_class = top;
+    result->margin = (CNN_NUM_OUTPUTS > 1) ? result->raw_output[top] - second : 0;
+}
 
-    /* Capture inference time */
-    result->inference_time_us = cnn_time;
+void inference_compute_confidence(inference_result_t *result)
+{
+    int i;
+    int max_idx = 0;
+    q15_t max_val = 0;
 
-    /* Unload CNN output */
-    cnn_unload((uint32_t *)result->raw_output);
+    if (result == NULL || result->softmax_valid) {
+        return;
+    }
+
+#if CNN_NUM_OUTPUTS == 2
+    {
+        int top = result->raw_output[1] > result->raw_output[0];
+        uint32_t margin = (uint32_t)(result->raw_output[top] - result->raw_output[1 - top]);
+        uint32_t k = (margin >= (16U << 14)) ? 16 : (margin + 8191) >> 14;
 
+        result->softmax[top] = s_binary_softmax[k][0];
+        result->softmax[1 - top] = s_binary_softmax[k][1];
+    }
+#else
     /* Compute softmax */
     softmax_q17p14_q15((const q31_t *)result->raw_output, CNN_NUM_OUTPUTS, result->softmax);
+#endif
 
     /* Find the class with highest probability */
     max_val = result->softmax[0];
@@ -114,21 +493,236 @@ inference_status_t inference_wait(inference_result_t *result)
     /* Convert Q15 softmax to percentage (0-100) */
     /* Q15 max is 32767 = 100%, so multiply by 100 and divide by 32768 */
     result->confidence_percent = (max_val * 100) >> 15;
+    result->softmax_valid = 1;
+}
+
+inference_status_t inference_wait(inference_result_t *result)
+{
+    return inference_wait_mode(result, INFERENCE_RESULT_FULL);
+}
+
+inference_status_t inference_wait_mode(inference_result_t *result, inference_result_mode_t mode)
+{
+    if (result == NULL) {
+        return INFERENCE_ERROR;
+    }
+
+    /* Wait for CNN to finish (cnn_time set by ISR) */
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk; /* Ensure SLEEPDEEP=0 */
+    SCHED_SLEEP_WHILE(cnn_time == 0);
+    PROFILE_END(PROFILE_STAGE_CNN);
+
+    /* Capture inference time */
+    result->inference_time_us = cnn_time;
+
+    PROFILE_BEGIN(PROFILE_STAGE_SOFTMAX);
+
+    /* Unload CNN output */
+    unload((uint32_t *)result->raw_output);
+
+    classify_logits(result);
+    result->softmax_valid = 0;
+    if (mode == INFERENCE_RESULT_FULL) {
+        inference_compute_confidence(result);
+    }
+
+    PROFILE_END(PROFILE_STAGE_SOFTMAX);
+
+    return INFERENCE_OK;
+}
+
+inference_status_t inference_run_batch(const uint32_t *const *inputs, int count,
+                                       uint32_t num_words, inference_result_t *results,
+                                       inference_result_mode_t mode)
+{
+    int i;
+
+    if (inputs == NULL || results == NULL || count < 1) {
+        return INFERENCE_ERROR;
+    }
+
+    s_batch_count = count;
+    s_batch_started = 1;
+    s_batch_done = 0;
+    s_batch_results = results;
+
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk; /* Ensure SLEEPDEEP=0 */
+    PROFILE_BEGIN(PROFILE_STAGE_CNN);
+    cnn_start();
+
+    for (i = 0; i < count; i++) {
+        /* The interrupt restarts the CNN for frame i once frame i-1 is done */
+        SCHED_SLEEP_WHILE(s_batch_started <= i);
+        inference_load_input(inputs[i], num_words);
+    }
+    SCHED_SLEEP_WHILE(s_batch_done < count);
+    PROFILE_END(PROFILE_STAGE_CNN);
+
+    s_batch_results = NULL;
+
+    PROFILE_BEGIN(PROFILE_STAGE_SOFTMAX);
+    for (i = 0; i < count; i++) {
+        classify_logits(&results[i]);
+        results[i].softmax_valid = 0;
+        if (mode == INFERENCE_RESULT_FULL) {
+            inference_compute_confidence(&results[i]);
+        }
+    }
+    PROFILE_END(PROFILE_STAGE_SOFTMAX);
+
+    return INFERENCE_OK;
+}
+
+int inference_is_done(void)
+{
+    return cnn_time != 0;
+}
+
+void inference_set_done_callback(void (*callback)(void))
+{
+    s_done_callback = callback;
+}
+
+void inference_abort(void)
+{
+#if INFERENCE_FIFO_DMA_ENABLE
+    if (s_fifo_dma_busy) {
+        MXC_DMA_Stop(s_fifo_dma_ch);
+        s_fifo_dma_busy = 0;
+    }
+#endif
+    if (s_loading_slot != NULL) {
+        slot_loaded();
+    }
+    cnn_stop();
+    init_state();
+    configure();
+
+    cnn_time = 0;
+}
+
+void inference_sleep(inference_sleep_t mode)
+{
+    cnn_stop();
+
+    if (mode == INFERENCE_SLEEP_RETAIN && s_weights_loaded) {
+        /* Clock gate only: CNN SRAM stays powered */
+        MXC_SYS_ClockDisable(MXC_SYS_PERIPH_CLOCK_CNN);
+    } else {
+        cnn_disable();
+        s_weights_loaded = 0;
+    }
+}
+
+inference_status_t inference_resume(void)
+{
+    if (!s_weights_loaded) {
+        cold_start();
+        return INFERENCE_OK;
+    }
+
+    /* Warm restart: weights and biases are retained, reprogram registers */
+    MXC_SYS_ClockEnable(MXC_SYS_PERIPH_CLOCK_CNN);
+    init_state();
+    configure();
+    cnn_time = 0;
 
     return INFERENCE_OK;
 }
 
+int inference_weights_retained(void)
+{
+    return s_weights_loaded;
+}
+
+void inference_set_clock(uint32_t clock_source, uint32_t clock_divider)
+{
+    s_cnn_clksel = clock_source;
+    s_cnn_clkdiv = clock_divider;
+
+    if (s_weights_loaded) {
+        /* Same fields as cnn_enable(), without its power-on reset */
+        MXC_GCR->pclkdiv = (MXC_GCR->pclkdiv &
+                            ~(MXC_F_GCR_PCLKDIV_CNNCLKDIV | MXC_F_GCR_PCLKDIV_CNNCLKSEL)) |
+                           clock_divider | clock_source;
+    }
+}
+
 void inference_disable(void)
 {
-    cnn_disable();
+    inference_sleep(INFERENCE_SLEEP_POWER_OFF);
 }
 
 inference_status_t inference_enable(void)
 {
-    /* Re-enable CNN clock */
-    MXC_SYS_ClockEnable(MXC_SYS_PERIPH_CLOCK_CNN);
+    return inference_resume();
+}
+
+const cnn_network_t *inference_get_network(void)
+{
+    return s_network;
+}
+
+int inference_add_model(const cnn_network_t *net)
+{
+#if CNN_NETWORK_TABLE_ENABLE
+    if (net == NULL || net->kernels == NULL || s_num_models == INFERENCE_MAX_MODELS ||
+        net->output_words != CNN_NUM_OUTPUTS) {
+        return -1;
+    }
+
+    s_models[s_num_models] = net;
+
+    /* Already running: load next to the resident networks, else at cold start */
+    if (s_weights_loaded) {
+        cnn_stop();
+        load_model(net);
+        init_state();
+        configure();
+        cnn_time = 0;
+    }
+
+    return s_num_models++;
+#else
+    (void)net;
+    return -1;
+#endif
+}
+
+inference_status_t inference_select_model(int model)
+{
+#if CNN_NETWORK_TABLE_ENABLE
+    if (model < 0 || model >= s_num_models) {
+        return INFERENCE_ERROR;
+    }
+    if (model == s_model) {
+        return INFERENCE_OK;
+    }
+
+    s_model = model;
+    s_network = s_models[model];
+
+    /* Weights are resident: only the layer program changes */
+    if (s_weights_loaded) {
+        cnn_stop();
+        init_state();
+        configure();
+        cnn_time = 0;
+    }
 
     return INFERENCE_OK;
+#else
+    return (model == 0) ? INFERENCE_OK : INFERENCE_ERROR;
+#endif
+}
+
+int inference_get_model(void)
+{
+#if CNN_NETWORK_TABLE_ENABLE
+    return s_model;
+#else
+    return 0;
+#endif
 }
 
 void inference_print_results(const inference_result_t *result,
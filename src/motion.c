@@ -0,0 +1,153 @@
+/**
+ * @file    motion.c
+ * @brief   Motion gating implementation for MAX78000 CNN live feeds.
+ */
+
+#include <string.h>
+
+#include "motion.h"
+#include "app_config.h"
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+/* Block sums of r + 2g + b */
+static uint32_t s_current[MOTION_GRID * MOTION_GRID];
+static uint32_t s_reference[MOTION_GRID * MOTION_GRID];
+
+static int s_block_w = 1;
+static int s_block_h = 1;
+static int s_block_px = 1;
+static int s_have_reference = 0;
+static uint32_t s_skip_run = 0;
+
+/* Region of interest in blocks, end exclusive */
+static int s_roi_x0 = 0;
+static int s_roi_y0 = 0;
+static int s_roi_x1 = MOTION_GRID;
+static int s_roi_y1 = MOTION_GRID;
+
+static motion_stats_t s_stats;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void motion_init(int width, int height)
+{
+    s_block_w = (width >= MOTION_GRID) ? width / MOTION_GRID : 1;
+    s_block_h = (height >= MOTION_GRID) ? height / MOTION_GRID : 1;
+    s_block_px = s_block_w * s_block_h;
+
+    s_roi_x0 = 0;
+    s_roi_y0 = 0;
+    s_roi_x1 = MOTION_GRID;
+    s_roi_y1 = MOTION_GRID;
+
+    s_have_reference = 0;
+    s_skip_run = 0;
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+void motion_set_roi(int x, int y, int width, int height)
+{
+    s_roi_x0 = x / s_block_w;
+    s_roi_y0 = y / s_block_h;
+    s_roi_x1 = (x + width + s_block_w - 1) / s_block_w;
+    s_roi_y1 = (y + height + s_block_h - 1) / s_block_h;
+
+    if (s_roi_x1 > MOTION_GRID) {
+        s_roi_x1 = MOTION_GRID;
+    }
+    if (s_roi_y1 > MOTION_GRID) {
+        s_roi_y1 = MOTION_GRID;
+    }
+}
+
+void motion_row_hook(int row, const uint32_t *pixels, uint32_t width, void *ctx)
+{
+    uint32_t *blocks;
+    uint32_t px;
+    uint32_t sum;
+    int by = row / s_block_h;
+    int bx;
+
+    (void)ctx;
+
+    if (row == 0) {
+        memset(s_current, 0, sizeof(s_current));
+    }
+    if (by >= MOTION_GRID) {
+        return;
+    }
+
+    blocks = &s_current[by * MOTION_GRID];
+    for (bx = 0; bx < MOTION_GRID && (uint32_t)((bx + 1) * s_block_w) <= width; bx++) {
+        sum = 0;
+        for (int i = 0; i < s_block_w; i++) {
+            px = *pixels++;
+            /* Luma approximation r + 2g + b */
+            sum += (px & 0xFFU) + ((px >> 7) & 0x1FEU) + ((px >> 16) & 0xFFU);
+        }
+        blocks[bx] += sum;
+    }
+}
+
+int motion_frame_changed(void)
+{
+    uint32_t changed_blocks = 0;
+    uint32_t sad = 0;
+    uint32_t roi_blocks = 0;
+    int32_t diff;
+    int changed;
+
+    s_stats.frames++;
+
+    /* Block means in luma levels (sum / pixels / 4) */
+    for (int by = s_roi_y0; by < s_roi_y1; by++) {
+        for (int bx = s_roi_x0; bx < s_roi_x1; bx++) {
+            int i = by * MOTION_GRID + bx;
+
+            diff = ((int32_t)s_current[i] - (int32_t)s_reference[i]) / (4 * s_block_px);
+            if (diff < 0) {
+                diff = -diff;
+            }
+            sad += (uint32_t)diff;
+            if (diff > MOTION_BLOCK_THRESHOLD) {
+                changed_blocks++;
+            }
+            roi_blocks++;
+        }
+    }
+
+    s_stats.last_blocks = changed_blocks;
+    s_stats.last_sad = (roi_blocks > 0) ? sad / roi_blocks : 0;
+
+    changed = !s_have_reference ||
+              changed_blocks >= MOTION_MIN_BLOCKS ||
+              s_skip_run >= MOTION_MAX_SKIP;
+
+    if (changed) {
+        memcpy(s_reference, s_current, sizeof(s_reference));
+        s_have_reference = 1;
+        s_skip_run = 0;
+    } else {
+        s_skip_run++;
+        s_stats.skipped++;
+    }
+
+    return changed;
+}
+
+void motion_invalidate(void)
+{
+    s_have_reference = 0;
+}
+
+void motion_get_stats(motion_stats_t *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
+}
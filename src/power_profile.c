@@ -0,0 +1,260 @@
+/**
+ * @file    power_profile.c
+ * @brief   Power/performance profiles implementation for MAX78000 CNN projects.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Platform headers - must come before cnn.h */
+#include "mxc.h"
+#include "uart.h"
+
+#include "power_profile.h"
+#include "inference_utils.h"
+#include "app_config.h"
+#include "cnn.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Oscillator frequencies */
+#define POWER_IPO_HZ        100000000U
+#define POWER_ISO_HZ        60000000U
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static const power_profile_desc_t s_profiles[POWER_PROFILE_COUNT] = {
+    /* name              system clock   div  CNN clock source                  div boost */
+    { "max-throughput", MXC_SYS_CLOCK_IPO, 1, MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK, 1, 1 },
+    { "balanced",       MXC_SYS_CLOCK_IPO, 1, MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK, 2, 0 },
+    { "low-energy",     MXC_SYS_CLOCK_ISO, 1, MXC_S_GCR_PCLKDIV_CNNCLKSEL_PCLK, 2, 0 },
+};
+
+/* Divider register values by log2 of the divider */
+static const mxc_sys_system_clock_div_t s_sys_divs[] = {
+    MXC_SYS_CLOCK_DIV_1, MXC_SYS_CLOCK_DIV_2, MXC_SYS_CLOCK_DIV_4, MXC_SYS_CLOCK_DIV_8,
+    MXC_SYS_CLOCK_DIV_16, MXC_SYS_CLOCK_DIV_32, MXC_SYS_CLOCK_DIV_64, MXC_SYS_CLOCK_DIV_128
+};
+static const uint32_t s_cnn_divs[] = {
+    MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV1, MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV2,
+    MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV4, MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV8,
+    MXC_S_GCR_PCLKDIV_CNNCLKDIV_DIV16
+};
+
+static power_profile_t s_profile = POWER_PROFILE_MAX_THROUGHPUT;
+static int s_applied = 0;               /* Set once a profile was programmed */
+static void (*s_reclock_callback)(void) = NULL;
+
+/* Measured inference times per profile */
+static uint64_t s_total_us[POWER_PROFILE_COUNT];
+static uint32_t s_samples[POWER_PROFILE_COUNT];
+static uint32_t s_last_us[POWER_PROFILE_COUNT];
+
+/* Frames in a row that would also fit the next slower profile */
+static uint32_t s_calm_frames = 0;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+/**
+ * @brief   log2 of a power-of-two divider, clamped to max_shift.
+ */
+static uint32_t div_shift(uint32_t div, uint32_t max_shift)
+{
+    uint32_t shift = 0;
+
+    while (shift < max_shift && (2U << shift) <= div) {
+        shift++;
+    }
+    return shift;
+}
+
+static uint32_t sys_hz(const power_profile_desc_t *p)
+{
+    uint32_t osc = (p->sys_clock == MXC_SYS_CLOCK_ISO) ? POWER_ISO_HZ : POWER_IPO_HZ;
+
+    return osc >> div_shift(p->sys_div, 7);
+}
+
+static uint32_t cnn_hz(const power_profile_desc_t *p)
+{
+    /* PCLK is half the system clock */
+    uint32_t src = (p->cnn_clksel == MXC_S_GCR_PCLKDIV_CNNCLKSEL_ISO) ? POWER_ISO_HZ
+                                                                      : sys_hz(p) / 2;
+
+    return src >> div_shift(p->cnn_div, 4);
+}
+
+/**
+ * @brief   Estimated active power: static part, then core and CNN parts
+ *          proportional to their clocks (the CNN part raised by boost).
+ */
+static uint32_t power_uw(const power_profile_desc_t *p)
+{
+    uint32_t cnn_uw = POWER_CNN_UW_PER_MHZ * (cnn_hz(p) / 1000000U);
+
+#if POWER_BOOST_ENABLE
+    if (p->boost) {
+        cnn_uw = cnn_uw * POWER_BOOST_PERCENT / 100U;
+    }
+#endif
+    return POWER_STATIC_UW + POWER_CORE_UW_PER_MHZ * (sys_hz(p) / 1000000U) + cnn_uw;
+}
+
+power_profile_status_t power_profile_select(power_profile_t profile)
+{
+    const power_profile_desc_t *next = power_profile_desc(profile);
+    const power_profile_desc_t *cur = &s_profiles[s_profile];
+    mxc_uart_regs_t *uart = MXC_UART_GET_UART(CONSOLE_UART);
+    int reclock;
+    int baud;
+
+    if (next == NULL) {
+        return POWER_PROFILE_ERROR;
+    }
+    reclock = !s_applied || next->sys_clock != cur->sys_clock || next->sys_div != cur->sys_div;
+
+#if POWER_BOOST_ENABLE
+    /* Supply up before the clocks rise, down once they dropped */
+    if (next->boost) {
+        cnn_boost_enable(POWER_BOOST_PORT, POWER_BOOST_PIN);
+    }
+#endif
+
+    if (reclock) {
+        /* The baud divider is computed from PCLK: let the UART drain first */
+        baud = MXC_UART_GetFrequency(uart);
+        fflush(stdout);
+        while (MXC_UART_GetActive(uart)) {
+            /* wait */
+        }
+
+        MXC_SYS_Clock_Select((mxc_sys_system_clock_t)next->sys_clock);
+        MXC_SYS_SetClockDiv(s_sys_divs[div_shift(next->sys_div, 7)]);
+        SystemCoreClockUpdate();
+
+        if (baud > 0) {
+            MXC_UART_SetFrequency(uart, (unsigned int)baud, MXC_UART_APB_CLK);
+        }
+    }
+    inference_set_clock(next->cnn_clksel, s_cnn_divs[div_shift(next->cnn_div, 4)]);
+
+#if POWER_BOOST_ENABLE
+    if (!next->boost) {
+        cnn_boost_disable(POWER_BOOST_PORT, POWER_BOOST_PIN);
+    }
+#endif
+
+    s_profile = profile;
+    s_applied = 1;
+    s_calm_frames = 0;
+
+    if (reclock && s_reclock_callback != NULL) {
+        s_reclock_callback();
+    }
+    return POWER_PROFILE_OK;
+}
+
+power_profile_t power_profile_get(void)
+{
+    return s_profile;
+}
+
+const power_profile_desc_t *power_profile_desc(power_profile_t profile)
+{
+    if ((unsigned)profile >= POWER_PROFILE_COUNT) {
+        return NULL;
+    }
+    return &s_profiles[profile];
+}
+
+void power_profile_set_reclock_callback(void (*callback)(void))
+{
+    s_reclock_callback = callback;
+}
+
+void power_profile_record(uint32_t inference_us)
+{
+    s_total_us[s_profile] += inference_us;
+    s_samples[s_profile]++;
+    s_last_us[s_profile] = inference_us;
+}
+
+void power_profile_get_stats(power_profile_t profile, power_profile_stats_t *stats)
+{
+    const power_profile_desc_t *p = power_profile_desc(profile);
+
+    if (p == NULL || stats == NULL) {
+        return;
+    }
+    stats->samples = s_samples[profile];
+    stats->last_us = s_last_us[profile];
+    stats->avg_us = s_samples[profile] ? (uint32_t)(s_total_us[profile] / s_samples[profile]) : 0;
+    stats->sys_hz = sys_hz(p);
+    stats->cnn_hz = cnn_hz(p);
+    stats->power_uw = power_uw(p);
+    /* uW * us = pJ */
+    stats->energy_nj = (uint32_t)((uint64_t)stats->power_uw * stats->avg_us / 1000U);
+}
+
+power_profile_t power_profile_govern(uint32_t busy_us, uint32_t period_us)
+{
+    const power_profile_desc_t *cur = &s_profiles[s_profile];
+    const power_profile_desc_t *slower;
+    uint64_t cnn_us, other_us, predicted;
+
+    if (period_us == 0) {
+        return s_profile;
+    }
+
+    if ((uint64_t)busy_us * 100U > (uint64_t)period_us * POWER_GOVERNOR_HIGH_PERCENT) {
+        s_calm_frames = 0;
+        return (s_profile > 0) ? (power_profile_t)(s_profile - 1) : s_profile;
+    }
+
+    if (s_profile + 1 >= POWER_PROFILE_COUNT || s_samples[s_profile] == 0) {
+        return s_profile;
+    }
+    slower = &s_profiles[s_profile + 1];
+
+    /* Inference time scales with the CNN clock, the rest with the core clock */
+    cnn_us = s_total_us[s_profile] / s_samples[s_profile];
+    if (cnn_us > busy_us) {
+        cnn_us = busy_us;
+    }
+    other_us = busy_us - cnn_us;
+    predicted = other_us * sys_hz(cur) / sys_hz(slower) + cnn_us * cnn_hz(cur) / cnn_hz(slower);
+
+    if (predicted * 100U < (uint64_t)period_us * POWER_GOVERNOR_LOW_PERCENT) {
+        if (++s_calm_frames >= POWER_GOVERNOR_SETTLE_FRAMES) {
+            s_calm_frames = 0;
+            return (power_profile_t)(s_profile + 1);
+        }
+    } else {
+        s_calm_frames = 0;
+    }
+    return s_profile;
+}
+
+void power_profile_print(void)
+{
+    power_profile_stats_t st;
+
+    printf("Power profiles (power estimated from the clocks):\n");
+    for (int i = 0; i < POWER_PROFILE_COUNT; i++) {
+        power_profile_get_stats((power_profile_t)i, &st);
+        printf("%c %-14s sys %3u MHz, cnn %2u MHz%s: %u inferences, avg %u us, "
+               "~%u.%03u mW, ~%u.%03u uJ/inference\n",
+               (i == (int)s_profile) ? '*' : ' ', s_profiles[i].name,
+               (unsigned)(st.sys_hz / 1000000U), (unsigned)(st.cnn_hz / 1000000U),
+               (POWER_BOOST_ENABLE && s_profiles[i].boost) ? ", boost" : "",
+               (unsigned)st.samples, (unsigned)st.avg_us,
+               (unsigned)(st.power_uw / 1000U), (unsigned)(st.power_uw % 1000U),
+               (unsigned)(st.energy_nj / 1000U), (unsigned)(st.energy_nj % 1000U));
+    }
+}
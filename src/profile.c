@@ -0,0 +1,150 @@
+/**
+ * @file    profile.c
+ * @brief   Per-stage latency profiling implementation for MAX78000 projects.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "profile.h"
+
+/* Platform headers */
+#include "mxc.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+#define PROFILE_MARKER      "<<<PROFILE>>>"
+
+/** Statistics for one stage */
+typedef struct {
+    uint32_t start;                         /* Cycle count at profile_begin() */
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t ring[PROFILE_RING_SIZE];       /* Most recent samples */
+    uint32_t head;
+} stage_stats_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static stage_stats_t s_stats[PROFILE_NUM_STAGES];
+
+/* Indexed by profile_stage_t */
+static const char *const s_stage_names[PROFILE_NUM_STAGES] = {
+    "capture",
+    "convert",
+    "fifo_load",
+    "cnn",
+    "softmax",
+    "tft",
+    "serial",
+    "frame"
+};
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+void profile_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    profile_reset();
+}
+
+void profile_reset(void)
+{
+    memset(s_stats, 0, sizeof(s_stats));
+}
+
+void profile_begin(profile_stage_t stage)
+{
+    if (stage < PROFILE_NUM_STAGES) {
+        s_stats[stage].start = profile_now();
+    }
+}
+
+void profile_end(profile_stage_t stage)
+{
+    if (stage < PROFILE_NUM_STAGES) {
+        profile_record(stage, profile_now() - s_stats[stage].start);
+    }
+}
+
+void profile_record(profile_stage_t stage, uint32_t cycles)
+{
+    stage_stats_t *st;
+
+    if (stage >= PROFILE_NUM_STAGES) {
+        return;
+    }
+    st = &s_stats[stage];
+
+    if (st->count == 0 || cycles < st->min) {
+        st->min = cycles;
+    }
+    if (cycles > st->max) {
+        st->max = cycles;
+    }
+    st->sum += cycles;
+    st->count++;
+
+    st->ring[st->head] = cycles;
+    st->head = (st->head + 1) % PROFILE_RING_SIZE;
+}
+
+/**
+ * @brief   99th percentile of the samples held in a stage's ring.
+ */
+static uint32_t ring_p99(const stage_stats_t *st)
+{
+    uint32_t sorted[PROFILE_RING_SIZE];
+    uint32_t n = (st->count < PROFILE_RING_SIZE) ? st->count : PROFILE_RING_SIZE;
+    uint32_t i, j, v;
+
+    /* Insertion sort, the ring is small */
+    for (i = 0; i < n; i++) {
+        v = st->ring[i];
+        for (j = i; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+
+    /* Nearest-rank: ceil(0.99 * n) - 1 */
+    return sorted[(99 * n + 99) / 100 - 1];
+}
+
+void profile_dump(void)
+{
+    uint32_t cycles_per_us = SystemCoreClock / 1000000;
+    int i;
+
+    if (cycles_per_us == 0) {
+        cycles_per_us = 1;
+    }
+
+    printf("\n%s\n", PROFILE_MARKER);
+    printf("stage,count,min_us,avg_us,max_us,p99_us\n");
+    for (i = 0; i < PROFILE_NUM_STAGES; i++) {
+        const stage_stats_t *st = &s_stats[i];
+
+        if (st->count == 0) {
+            continue;
+        }
+        printf("%s,%u,%u,%u,%u,%u\n", s_stage_names[i],
+               (unsigned)st->count,
+               (unsigned)(st->min / cycles_per_us),
+               (unsigned)(st->sum / st->count / cycles_per_us),
+               (unsigned)(st->max / cycles_per_us),
+               (unsigned)(ring_p99(st) / cycles_per_us));
+    }
+    printf("%s\n\n", PROFILE_MARKER);
+}
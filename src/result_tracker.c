@@ -0,0 +1,108 @@
+/**
+ * @file    result_tracker.c
+ * @brief   Temporal smoothing of CNN results implementation.
+ */
+
+#include <string.h>
+
+#include "result_tracker.h"
+#include "app_config.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Percent to Q15 */
+#define PERCENT_TO_Q15(p)   (((p) * 32768) / 100)
+
+#define TRACKER_ENTER_Q15   PERCENT_TO_Q15(TRACKER_ENTER_PERCENT)
+#define TRACKER_EXIT_Q15    PERCENT_TO_Q15(TRACKER_EXIT_PERCENT)
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static int leading_class(const result_tracker_t *tracker)
+{
+    int best = 0;
+
+    for (int i = 1; i < CNN_NUM_OUTPUTS; i++) {
+        if (tracker->score[i] > tracker->score[best]) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+void tracker_init(result_tracker_t *tracker)
+{
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->stable_class = -1;
+    tracker->candidate = -1;
+}
+
+tracker_event_t tracker_update(result_tracker_t *tracker, const inference_result_t *result)
+{
+    int lead;
+
+    /* The first frame seeds the average */
+    for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
+        if (tracker->frames == 0) {
+            tracker->score[i] = result->softmax[i];
+        } else {
+            tracker->score[i] += (result->softmax[i] - tracker->score[i]) >> TRACKER_EMA_SHIFT;
+        }
+    }
+    tracker->frames++;
+
+    /* Hysteresis: once stable, hold until below the exit level */
+    if (tracker->stable_class >= 0 &&
+        tracker->score[tracker->stable_class] < TRACKER_EXIT_Q15) {
+        tracker->stable_class = -1;
+        tracker->candidate = -1;
+        tracker->candidate_run = 0;
+        return TRACKER_EVT_LOST;
+    }
+
+    lead = leading_class(tracker);
+    if (lead == tracker->stable_class || tracker->score[lead] < TRACKER_ENTER_Q15) {
+        tracker->candidate = -1;
+        tracker->candidate_run = 0;
+        return TRACKER_EVT_NONE;
+    }
+
+    if (lead != tracker->candidate) {
+        tracker->candidate = lead;
+        tracker->candidate_run = 0;
+    }
+    if (++tracker->candidate_run < TRACKER_CONFIRM_FRAMES) {
+        return TRACKER_EVT_NONE;
+    }
+
+    tracker->stable_class = lead;
+    tracker->candidate = -1;
+    tracker->candidate_run = 0;
+
+    return TRACKER_EVT_STABLE;
+}
+
+void tracker_get_result(const result_tracker_t *tracker, const inference_result_t *latest,
+                        inference_result_t *out)
+{
+    if (out != latest) {
+        *out = *latest;
+    }
+    for (int i = 0; i < CNN_NUM_OUTPUTS; i++) {
+        out->softmax[i] = (q15_t)tracker->score[i];
+    }
+
+    out->predicted_class = (tracker->stable_class >= 0) ? tracker->stable_class
+                                                        : leading_class(tracker);
+    out->confidence_percent = (int)((tracker->score[out->predicted_class] * 100) >> 15);
+}
+
+int tracker_is_stable(const result_tracker_t *tracker)
+{
+    return tracker->stable_class >= 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file    scheduler.c
+ * @brief   Event flags and frame timer implementation for MAX78000 projects.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "scheduler.h"
+#include "app_config.h"
+
+/* Platform headers */
+#include "mxc.h"
+#include "tmr.h"
+#include "pb.h"
+#include "nvic_table.h"
+
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* Timer clock: APB / 128 */
+#define SCHED_TIMER_PRES        TMR_PRES_128
+#define SCHED_TIMER_DIV         128
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static volatile uint32_t s_events = 0;
+static uint32_t s_period_ms = 0;
+
+/*******************************************************************************
+ * Code
+ ******************************************************************************/
+
+static void frame_timer_isr(void)
+{
+    MXC_TMR_ClearFlags(SCHED_TIMER);
+    s_events |= SCHED_EVT_FRAME_TICK;
+}
+
+static void button_callback(void *pb)
+{
+    (void)pb;
+    s_events |= SCHED_EVT_BUTTON;
+}
+
+static void button_gpio_isr(void)
+{
+    MXC_GPIO_Handler(MXC_GPIO_GET_IDX(pb_pin[CAPTURE_BUTTON].port));
+}
+
+int sched_init(void)
+{
+    IRQn_Type gpio_irq = MXC_GPIO_GET_IRQ(MXC_GPIO_GET_IDX(pb_pin[CAPTURE_BUTTON].port));
+
+    MXC_NVIC_SetVector(MXC_TMR_GET_IRQ(SCHED_TIMER_IDX), frame_timer_isr);
+    NVIC_EnableIRQ(MXC_TMR_GET_IRQ(SCHED_TIMER_IDX));
+
+    /* Falling edge on the (active low) capture button */
+    MXC_NVIC_SetVector(gpio_irq, button_gpio_isr);
+    if (PB_RegisterCallback(CAPTURE_BUTTON, button_callback) != E_NO_ERROR) {
+        printf("Button interrupt setup failed!\n");
+        return -1;
+    }
+    PB_IntEnable(CAPTURE_BUTTON);
+
+    return 0;
+}
+
+void sched_post(uint32_t events)
+{
+    __disable_irq();
+    s_events |= events;
+    __enable_irq();
+}
+
+uint32_t sched_take(uint32_t mask)
+{
+    uint32_t taken;
+
+    __disable_irq();
+    taken = s_events & mask;
+    s_events &= ~taken;
+    __enable_irq();
+
+    return taken;
+}
+
+uint32_t sched_peek(uint32_t mask)
+{
+    return s_events & mask;
+}
+
+uint32_t sched_wait(uint32_t mask)
+{
+    /* Plain sleep: camera, DMA and UART keep running */
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    SCHED_SLEEP_WHILE((s_events & mask) == 0);
+
+    return sched_take(mask);
+}
+
+void sched_set_frame_period(uint32_t period_ms)
+{
+    mxc_tmr_cfg_t cfg;
+
+    s_period_ms = period_ms;
+    MXC_TMR_Shutdown(SCHED_TIMER);
+    sched_take(SCHED_EVT_FRAME_TICK);
+    if (period_ms == 0) {
+        return;
+    }
+
+    cfg.pres = SCHED_TIMER_PRES;
+    cfg.mode = TMR_MODE_CONTINUOUS;
+    cfg.bitMode = TMR_BIT_MODE_32;
+    cfg.clock = MXC_TMR_APB_CLK;
+    cfg.cmp_cnt = (uint32_t)((uint64_t)PeripheralClock / SCHED_TIMER_DIV * period_ms / 1000);
+    cfg.pol = 0;
+
+    MXC_TMR_Init(SCHED_TIMER, &cfg, false);
+    MXC_TMR_EnableInt(SCHED_TIMER);
+    MXC_TMR_Start(SCHED_TIMER);
+}
+
+uint32_t sched_get_frame_period(void)
+{
+    return s_period_ms;
+}
@@ -7,6 +7,9 @@
 #include <string.h>
 
 #include "serial_stream.h"
+#include "image_codec.h"
+#include "camera_utils.h"
+#include "scheduler.h"
 #include "app_config.h"
 #include "mxc.h"
 
@@ -18,11 +21,692 @@
 #define IMG_START_MARKER    "<<<IMG_START>>>"
 #define IMG_END_MARKER      "<<<IMG_END>>>"
 #define RESULT_MARKER       "<<<RESULT>>>"
+#define FRAME_MARKER        "<<<FRAME>>>"
+
+/* Buffered UART writer chunk size */
+#define TX_BUF_SIZE         256
+
+/* DMA request line for the console UART TX (CONSOLE_UART 0 on FTHR_RevA) */
+#ifndef SERIAL_DMA_REQSEL
+#define SERIAL_DMA_REQSEL   MXC_DMA_REQUEST_UART0TX
+#endif
+
+#if SERIAL_LIVE_DELTA_ENABLE
+#if SERIAL_LIVE_TILE_SIZE < 2 || SERIAL_LIVE_TILE_SIZE > 16 || (SERIAL_LIVE_TILE_SIZE & 1)
+#error "SERIAL_LIVE_TILE_SIZE must be even and at most 16"
+#endif
+#define LIVE_TILE           SERIAL_LIVE_TILE_SIZE
+#define LIVE_TILES_X        ((IMAGE_SIZE_X + LIVE_TILE - 1) / LIVE_TILE)
+#define LIVE_TILES_Y        ((IMAGE_SIZE_Y + LIVE_TILE - 1) / LIVE_TILE)
+#define LIVE_MAX_TILES      (LIVE_TILES_X * LIVE_TILES_Y)
+/* Tile signature: quadrant luma (r + 2g + b) sums, then tile red and blue
+ * sums so that changes of colour at equal brightness are seen too */
+#define LIVE_SIG_WORDS      6
+/* Delta payload header ahead of the changed-tile bitmap */
+#define LIVE_DELTA_HEADER   8
+#endif
+
+/* Accumulates length and CRC of an encoded payload, optionally sending or
+ * copying it */
+typedef struct {
+    uint32_t len;
+    uint32_t crc;
+    uint8_t *dst;       /* Copy destination, NULL when not copying */
+    uint32_t cap;       /* Capacity of dst */
+    int overflow;
+    int send;           /* Write through the buffered UART writer */
+} payload_sink_t;
+
+/*******************************************************************************
+ * Variables
+ ******************************************************************************/
+
+static uint8_t s_tx_buf[TX_BUF_SIZE];
+static int s_tx_len = 0;
+
+/* Compression applied to binary frames */
+static image_codec_t s_codec = SERIAL_STREAM_CODEC;
+static int s_quality = SERIAL_JPEG_QUALITY;
+
+#if SERIAL_STREAM_ASYNC_ENABLE
+/* Frame slots handed to the TX DMA: marker + header + payload each */
+static uint8_t s_slots[SERIAL_ASYNC_SLOTS][SERIAL_ASYNC_SLOT_SIZE];
+static uint32_t s_slot_len[SERIAL_ASYNC_SLOTS];
+static int s_fill_slot = 0;             /* Next slot to serialize into */
+static int s_send_slot = 0;             /* Slot currently on the DMA */
+static volatile int s_pending = 0;      /* Slots queued or in flight */
+static int s_dma_ch = -1;
+static void (*s_drain_callback)(void) = NULL; /* Called when the queue empties */
+#endif
+
+#if SERIAL_LIVE_DELTA_ENABLE
+/* Signature of every tile as the host last got it */
+static uint16_t s_live_sig[LIVE_MAX_TILES][LIVE_SIG_WORDS];
+static uint8_t s_live_bitmap[(LIVE_MAX_TILES + 7) / 8];
+static uint32_t s_live_changed = 0;
+static uint32_t s_live_width = 0;       /* Reference frame size, 0 = none */
+static uint32_t s_live_height = 0;
+static uint32_t s_live_since_key = 0;   /* Delta frames since the keyframe */
+#endif
+
+/* CRC32 (poly 0xEDB88320) nibble table - 64 bytes of flash */
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
 
 /*******************************************************************************
  * Code
  ******************************************************************************/
 
+static void tx_flush(void)
+{
+    int len = s_tx_len;
+
+    if (len > 0) {
+        MXC_UART_Write(MXC_UART_GET_UART(CONSOLE_UART), s_tx_buf, &len);
+    }
+    s_tx_len = 0;
+}
+
+static void tx_write(const uint8_t *data, int len)
+{
+    while (len-- > 0) {
+        s_tx_buf[s_tx_len++] = *data++;
+        if (s_tx_len == TX_BUF_SIZE) {
+            tx_flush();
+        }
+    }
+}
+
+static void put_le16(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    put_le16(p, v & 0xFFFF);
+    put_le16(p + 2, v >> 16);
+}
+
+/* Pack one (B<<16)|(G<<8)|R pixel into payload bytes, returns the number of bytes */
+static int pack_pixel(uint32_t pixel, stream_pixfmt_t format, uint8_t *out)
+{
+    uint8_t r = (uint8_t)(pixel & 0xFF);
+    uint8_t g = (uint8_t)((pixel >> 8) & 0xFF);
+    uint8_t b = (uint8_t)((pixel >> 16) & 0xFF);
+    uint16_t rgb;
+
+    if (format == STREAM_PIXFMT_RGB565) {
+        rgb = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+        out[0] = (uint8_t)(rgb >> 8);
+        out[1] = (uint8_t)(rgb & 0xFF);
+        return 2;
+    }
+
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
+    return 3;
+}
+
+static void build_header(uint8_t *header, int width, int height, int capture_id,
+                         stream_pixfmt_t format, uint32_t codec, uint32_t flags,
+                         uint32_t payload_len, uint32_t crc)
+{
+    memcpy(header, SERIAL_FRAME_MAGIC, 4);
+    header[4] = SERIAL_FRAME_VERSION;
+    header[5] = (uint8_t)format;
+    header[6] = (uint8_t)codec;
+    header[7] = (uint8_t)flags;
+    put_le16(&header[8], (uint32_t)width);
+    put_le16(&header[10], (uint32_t)height);
+    put_le32(&header[12], (uint32_t)capture_id);
+    put_le32(&header[16], payload_len);
+    put_le32(&header[20], crc);
+}
+
+uint32_t serial_crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    crc = ~crc;
+    while (len-- > 0) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+static void payload_sink(void *ctx, const uint8_t *data, uint32_t len)
+{
+    payload_sink_t *ps = (payload_sink_t *)ctx;
+
+    ps->crc = serial_crc32(ps->crc, data, len);
+    if (ps->dst != NULL) {
+        if (ps->len + len > ps->cap) {
+            ps->overflow = 1;
+        } else {
+            memcpy(ps->dst + ps->len, data, len);
+        }
+    }
+    if (ps->send) {
+        tx_write(data, (int)len);
+    }
+    ps->len += len;
+}
+
+void serial_stream_set_codec(image_codec_t codec, int quality)
+{
+    s_codec = codec;
+    s_quality = quality;
+}
+
+void serial_stream_init(uint32_t baud)
+{
+    /* Drain pending console output at the old rate first */
+    fflush(stdout);
+    while (MXC_UART_GetActive(MXC_UART_GET_UART(CONSOLE_UART))) {
+        /* wait */
+    }
+
+    MXC_UART_SetFrequency(MXC_UART_GET_UART(CONSOLE_UART), baud, MXC_UART_APB_CLK);
+}
+
+/* The codecs read a packed CNN buffer, other views go out uncompressed */
+static const uint32_t *codec_input(const cam_frame_view_t *view)
+{
+    if (s_codec == IMAGE_CODEC_NONE || view->format != CAM_VIEW_CNN ||
+        view->stride != view->width * sizeof(uint32_t)) {
+        return NULL;
+    }
+    return (const uint32_t *)view->data;
+}
+
+void serial_stream_frame(const uint32_t *cnn_buffer, int width, int height,
+                          int capture_id, stream_pixfmt_t format)
+{
+    cam_frame_view_t view;
+
+    if (cnn_buffer == NULL) {
+        return;
+    }
+
+    camera_utils_view_cnn(&view, cnn_buffer, (uint32_t)width, (uint32_t)height);
+    serial_stream_frame_view(&view, capture_id, format);
+}
+
+static void send_view(const cam_frame_view_t *view, int capture_id, stream_pixfmt_t format,
+                      uint32_t flags)
+{
+    uint8_t header[SERIAL_FRAME_HEADER_SIZE];
+    uint8_t px[3];
+    uint32_t crc = 0;
+    uint32_t payload_len = 0;
+    const uint32_t *cnn_buffer;
+    int n;
+    int width, height;
+
+    if (view == NULL || view->data == NULL) {
+        return;
+    }
+    width = (int)view->width;
+    height = (int)view->height;
+    cnn_buffer = codec_input(view);
+
+    if (cnn_buffer != NULL) {
+        /* Encoders are deterministic: size and CRC first, then send */
+        payload_sink_t ps = { 0 };
+
+        image_codec_encode(s_codec, cnn_buffer, width, height, s_quality, payload_sink, &ps);
+        build_header(header, width, height, capture_id, STREAM_PIXFMT_RGB888, s_codec,
+                     flags, ps.len, ps.crc);
+
+        printf("\n%s\n", FRAME_MARKER);
+        fflush(stdout);
+
+        tx_write(header, sizeof(header));
+        memset(&ps, 0, sizeof(ps));
+        ps.send = 1;
+        image_codec_encode(s_codec, cnn_buffer, width, height, s_quality, payload_sink, &ps);
+        tx_flush();
+        return;
+    }
+
+    /* First pass: CRC and length of the payload, so the header can lead */
+    for (uint32_t y = 0; y < view->height; y++) {
+        for (uint32_t x = 0; x < view->width; x++) {
+            n = pack_pixel(cam_view_rgb(view, x, y), format, px);
+            crc = serial_crc32(crc, px, (uint32_t)n);
+            payload_len += (uint32_t)n;
+        }
+    }
+
+    build_header(header, width, height, capture_id, format, IMAGE_CODEC_NONE, flags,
+                 payload_len, crc);
+
+    /* Marker goes through stdio, flush it before raw UART writes */
+    printf("\n%s\n", FRAME_MARKER);
+    fflush(stdout);
+
+    tx_write(header, sizeof(header));
+    for (uint32_t y = 0; y < view->height; y++) {
+        for (uint32_t x = 0; x < view->width; x++) {
+            n = pack_pixel(cam_view_rgb(view, x, y), format, px);
+            tx_write(px, n);
+        }
+    }
+    tx_flush();
+}
+
+void serial_stream_frame_view(const cam_frame_view_t *view, int capture_id,
+                              stream_pixfmt_t format)
+{
+    send_view(view, capture_id, format, 0);
+}
+
+#if SERIAL_LIVE_DELTA_ENABLE
+/* Signature of one tile (edge tiles cut to the frame) */
+static void tile_signature(const cam_frame_view_t *view, uint32_t tx, uint32_t ty,
+                           uint16_t sig[LIVE_SIG_WORDS])
+{
+    uint32_t x0 = tx * LIVE_TILE;
+    uint32_t y0 = ty * LIVE_TILE;
+    uint32_t sums[LIVE_SIG_WORDS] = { 0 };
+    uint32_t px;
+
+    for (uint32_t y = y0; y < y0 + LIVE_TILE && y < view->height; y++) {
+        for (uint32_t x = x0; x < x0 + LIVE_TILE && x < view->width; x++) {
+            px = cam_view_rgb(view, x, y);
+            sums[((y - y0) >= LIVE_TILE / 2) * 2 + ((x - x0) >= LIVE_TILE / 2)] +=
+                (px & 0xFFU) + ((px >> 7) & 0x1FEU) + ((px >> 16) & 0xFFU);
+            sums[4] += px & 0xFFU;
+            sums[5] += (px >> 16) & 0xFFU;
+        }
+    }
+    for (int i = 0; i < LIVE_SIG_WORDS; i++) {
+        sig[i] = (uint16_t)sums[i];
+    }
+}
+
+/* Pixels of one tile in the payload */
+static uint32_t tile_bytes(const cam_frame_view_t *view, uint32_t tx, uint32_t ty,
+                           stream_pixfmt_t format)
+{
+    uint32_t w = view->width - tx * LIVE_TILE;
+    uint32_t h = view->height - ty * LIVE_TILE;
+
+    w = (w > LIVE_TILE) ? LIVE_TILE : w;
+    h = (h > LIVE_TILE) ? LIVE_TILE : h;
+    return w * h * ((format == STREAM_PIXFMT_RGB565) ? 2 : 3);
+}
+
+void serial_stream_live_reset(void)
+{
+    s_live_width = 0;
+    s_live_height = 0;
+}
+
+/*
+ * Mark the tiles whose quadrant mean luma, or mean red or blue, moved by
+ * more than SERIAL_LIVE_TILE_THRESHOLD since the host got them, and take their new
+ * signatures as reference. Returns the delta payload length, or 0 when a
+ * keyframe is due (no reference, size change, interval, or a delta no smaller
+ * than the full frame); the references are then all renewed.
+ */
+static uint32_t live_prepare(const cam_frame_view_t *view, stream_pixfmt_t format)
+{
+    uint32_t tiles_x = (view->width + LIVE_TILE - 1) / LIVE_TILE;
+    uint32_t tiles_y = (view->height + LIVE_TILE - 1) / LIVE_TILE;
+    uint32_t tiles = tiles_x * tiles_y;
+    uint32_t full = view->width * view->height * ((format == STREAM_PIXFMT_RGB565) ? 2 : 3);
+    uint32_t len = LIVE_DELTA_HEADER + (tiles + 7) / 8;
+    /* Quadrant luma sums hold (LIVE_TILE / 2)^2 pixels of 4x luma, and the
+     * colour sums LIVE_TILE^2 pixels of one channel */
+    const uint32_t limit = SERIAL_LIVE_TILE_THRESHOLD * LIVE_TILE * LIVE_TILE;
+    uint16_t sig[LIVE_SIG_WORDS];
+    uint32_t diff;
+    uint32_t t = 0;
+    int key;
+
+    key = tiles > LIVE_MAX_TILES || view->width != s_live_width ||
+          view->height != s_live_height || s_live_since_key >= SERIAL_LIVE_KEYFRAME_INTERVAL;
+
+    memset(s_live_bitmap, 0, sizeof(s_live_bitmap));
+    s_live_changed = 0;
+    for (uint32_t ty = 0; ty < tiles_y && tiles <= LIVE_MAX_TILES; ty++) {
+        for (uint32_t tx = 0; tx < tiles_x; tx++, t++) {
+            tile_signature(view, tx, ty, sig);
+            for (int i = 0; i < LIVE_SIG_WORDS; i++) {
+                diff = (sig[i] > s_live_sig[t][i]) ? sig[i] - s_live_sig[t][i]
+                                                   : s_live_sig[t][i] - sig[i];
+                if (key || diff > limit) {
+                    s_live_bitmap[t / 8] |= (uint8_t)(1U << (t % 8));
+                    memcpy(s_live_sig[t], sig, sizeof(sig));
+                    s_live_changed++;
+                    len += tile_bytes(view, tx, ty, format);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!key && len >= full) {
+        /* Some references were only renewed for changed tiles */
+        s_live_since_key = SERIAL_LIVE_KEYFRAME_INTERVAL;
+        return live_prepare(view, format);
+    }
+    if (key) {
+        s_live_width = (tiles <= LIVE_MAX_TILES) ? view->width : 0;
+        s_live_height = view->height;
+        s_live_since_key = 0;
+        return 0;
+    }
+    s_live_since_key++;
+    return len;
+}
+
+/* Delta payload: header, changed-tile bitmap, then the changed tiles */
+static void live_encode(const cam_frame_view_t *view, stream_pixfmt_t format,
+                        image_codec_sink_t sink, void *ctx)
+{
+    uint32_t tiles_x = (view->width + LIVE_TILE - 1) / LIVE_TILE;
+    uint32_t tiles_y = (view->height + LIVE_TILE - 1) / LIVE_TILE;
+    uint8_t hdr[LIVE_DELTA_HEADER];
+    uint8_t px[3];
+    uint32_t t = 0;
+    int n;
+
+    hdr[0] = LIVE_TILE;
+    hdr[1] = (uint8_t)format;
+    put_le16(&hdr[2], tiles_x);
+    put_le16(&hdr[4], tiles_y);
+    put_le16(&hdr[6], s_live_changed);
+    sink(ctx, hdr, sizeof(hdr));
+    sink(ctx, s_live_bitmap, (tiles_x * tiles_y + 7) / 8);
+
+    for (uint32_t ty = 0; ty < tiles_y; ty++) {
+        for (uint32_t tx = 0; tx < tiles_x; tx++, t++) {
+            if (!(s_live_bitmap[t / 8] & (1U << (t % 8)))) {
+                continue;
+            }
+            for (uint32_t y = ty * LIVE_TILE; y < (ty + 1) * LIVE_TILE && y < view->height; y++) {
+                for (uint32_t x = tx * LIVE_TILE;
+                     x < (tx + 1) * LIVE_TILE && x < view->width; x++) {
+                    n = pack_pixel(cam_view_rgb(view, x, y), format, px);
+                    sink(ctx, px, (uint32_t)n);
+                }
+            }
+        }
+    }
+}
+
+void serial_stream_live_frame(const cam_frame_view_t *view, int capture_id,
+                              stream_pixfmt_t format)
+{
+    uint8_t header[SERIAL_FRAME_HEADER_SIZE];
+    payload_sink_t ps = { 0 };
+
+    if (view == NULL || view->data == NULL) {
+        return;
+    }
+
+    if (live_prepare(view, format) == 0) {
+        send_view(view, capture_id, format, SERIAL_FRAME_FLAG_LIVE);
+        return;
+    }
+
+    /* Length and CRC first, then send (as the codec path) */
+    live_encode(view, format, payload_sink, &ps);
+    build_header(header, (int)view->width, (int)view->height, capture_id, format,
+                 SERIAL_CODEC_TILE_DELTA, SERIAL_FRAME_FLAG_LIVE, ps.len, ps.crc);
+
+    printf("\n%s\n", FRAME_MARKER);
+    fflush(stdout);
+
+    tx_write(header, sizeof(header));
+    memset(&ps, 0, sizeof(ps));
+    ps.send = 1;
+    live_encode(view, format, payload_sink, &ps);
+    tx_flush();
+}
+#endif /* SERIAL_LIVE_DELTA_ENABLE */
+
+#if SERIAL_STREAM_ASYNC_ENABLE
+static void dma_send_slot(int slot)
+{
+    mxc_dma_config_t config;
+    mxc_dma_srcdst_t srcdst;
+
+    config.ch = s_dma_ch;
+    config.reqsel = SERIAL_DMA_REQSEL;
+    config.srcwd = MXC_DMA_WIDTH_BYTE;
+    config.dstwd = MXC_DMA_WIDTH_BYTE;
+    config.srcinc_en = 1;
+    config.dstinc_en = 0;
+
+    srcdst.ch = s_dma_ch;
+    srcdst.source = s_slots[slot];
+    srcdst.dest = NULL;
+    srcdst.len = (int)s_slot_len[slot];
+
+    MXC_DMA_ConfigChannel(config, srcdst);
+    MXC_DMA_EnableInt(s_dma_ch);
+    MXC_DMA_SetChannelInterruptEn(s_dma_ch, 0, 1);  /* Count-to-zero */
+    MXC_DMA_Start(s_dma_ch);
+}
+
+/* Runs from the DMA interrupt when a slot has been handed to the UART FIFO */
+static void dma_tx_callback(int ch, int err)
+{
+    (void)ch;
+    (void)err;
+
+    s_send_slot = (s_send_slot + 1) % SERIAL_ASYNC_SLOTS;
+    s_pending--;
+
+    /* Chain the next queued frame */
+    if (s_pending > 0) {
+        dma_send_slot(s_send_slot);
+    } else if (s_drain_callback != NULL) {
+        s_drain_callback();
+    }
+}
+
+static void dma_tx_isr(void)
+{
+    MXC_DMA_Handler();
+}
+
+void serial_stream_async_set_callback(void (*callback)(void))
+{
+    s_drain_callback = callback;
+}
+
+int serial_stream_async_init(int dma_channel)
+{
+    mxc_uart_regs_t *uart = MXC_UART_GET_UART(CONSOLE_UART);
+
+    if (dma_channel < 0) {
+        return -1;
+    }
+    s_dma_ch = dma_channel;
+
+    MXC_DMA_SetCallback(s_dma_ch, dma_tx_callback);
+    MXC_NVIC_SetVector(MXC_DMA_CH_GET_IRQ(s_dma_ch), dma_tx_isr);
+    NVIC_EnableIRQ(MXC_DMA_CH_GET_IRQ(s_dma_ch));
+
+    /* Request DMA whenever the TX FIFO has room */
+    MXC_UART_SetTXThreshold(uart, 2);
+    uart->dma |= MXC_F_UART_DMA_TX_EN;
+
+    return 0;
+}
+
+stream_async_status_t serial_stream_async_start(const uint32_t *cnn_buffer, int width,
+                                                int height, int capture_id,
+                                                stream_pixfmt_t format)
+{
+    cam_frame_view_t view;
+
+    if (cnn_buffer == NULL) {
+        return STREAM_ASYNC_ERROR;
+    }
+
+    camera_utils_view_cnn(&view, cnn_buffer, (uint32_t)width, (uint32_t)height);
+    return serial_stream_async_start_view(&view, capture_id, format);
+}
+
+static const char s_slot_marker[] = "\n" FRAME_MARKER "\n";
+#define SLOT_MARKER_LEN     (sizeof(s_slot_marker) - 1)
+#define SLOT_PAYLOAD_CAP    (SERIAL_ASYNC_SLOT_SIZE - SLOT_MARKER_LEN - SERIAL_FRAME_HEADER_SIZE)
+
+/* Payload area of the next slot, once one is free (only blocks when every
+ * slot is queued) */
+static uint8_t *slot_payload(void)
+{
+    SCHED_SLEEP_WHILE(s_pending == SERIAL_ASYNC_SLOTS);
+    return s_slots[s_fill_slot] + SLOT_MARKER_LEN + SERIAL_FRAME_HEADER_SIZE;
+}
+
+/* Add marker and header to the slot from slot_payload() and queue it */
+static void slot_queue(int width, int height, int capture_id, stream_pixfmt_t format,
+                       uint32_t codec, uint32_t flags, uint32_t payload_len, uint32_t crc)
+{
+    int slot_idx = s_fill_slot;
+    uint8_t *slot = s_slots[slot_idx];
+
+    memcpy(slot, s_slot_marker, SLOT_MARKER_LEN);
+    build_header(slot + SLOT_MARKER_LEN, width, height, capture_id, format, codec, flags,
+                 payload_len, crc);
+    s_slot_len[slot_idx] = SLOT_MARKER_LEN + SERIAL_FRAME_HEADER_SIZE + payload_len;
+    s_fill_slot = (s_fill_slot + 1) % SERIAL_ASYNC_SLOTS;
+
+    /* Text printed before this call must reach the wire ahead of the frame */
+    fflush(stdout);
+
+    __disable_irq();
+    s_pending++;
+    if (s_pending == 1) {
+        dma_send_slot(slot_idx);
+    }
+    __enable_irq();
+}
+
+static stream_async_status_t queue_view(const cam_frame_view_t *view, int capture_id,
+                                        stream_pixfmt_t format, uint32_t flags)
+{
+    const uint32_t cap = SLOT_PAYLOAD_CAP;
+    uint32_t bpp = (format == STREAM_PIXFMT_RGB565) ? 2 : 3;
+    uint32_t payload_len;
+    const uint32_t *cnn_buffer;
+    image_codec_t codec;
+    uint8_t *payload;
+    uint8_t *out;
+    uint32_t crc;
+    int width, height;
+
+    if (view == NULL || view->data == NULL || s_dma_ch < 0) {
+        return STREAM_ASYNC_ERROR;
+    }
+    width = (int)view->width;
+    height = (int)view->height;
+    payload_len = view->width * view->height * bpp;
+    cnn_buffer = codec_input(view);
+    codec = (cnn_buffer != NULL) ? s_codec : IMAGE_CODEC_NONE;
+    if (codec == IMAGE_CODEC_NONE && payload_len > cap) {
+        return STREAM_ASYNC_ERROR;
+    }
+
+    payload = slot_payload();
+
+    /* Payload first, so the CRC is known when the header is written */
+    if (codec != IMAGE_CODEC_NONE) {
+        payload_sink_t ps = { 0 };
+
+        ps.dst = payload;
+        ps.cap = cap;
+        image_codec_encode(s_codec, cnn_buffer, width, height, s_quality, payload_sink, &ps);
+        if (ps.overflow) {
+            return STREAM_ASYNC_ERROR;
+        }
+        payload_len = ps.len;
+        crc = ps.crc;
+        format = STREAM_PIXFMT_RGB888;
+    } else {
+        out = payload;
+        for (uint32_t y = 0; y < view->height; y++) {
+            for (uint32_t x = 0; x < view->width; x++) {
+                out += pack_pixel(cam_view_rgb(view, x, y), format, out);
+            }
+        }
+        crc = serial_crc32(0, payload, payload_len);
+    }
+
+    slot_queue(width, height, capture_id, format, codec, flags, payload_len, crc);
+    return STREAM_ASYNC_BUSY;
+}
+
+stream_async_status_t serial_stream_async_start_view(const cam_frame_view_t *view,
+                                                     int capture_id, stream_pixfmt_t format)
+{
+    return queue_view(view, capture_id, format, 0);
+}
+
+#if SERIAL_LIVE_DELTA_ENABLE
+stream_async_status_t serial_stream_async_start_live(const cam_frame_view_t *view,
+                                                     int capture_id, stream_pixfmt_t format)
+{
+    payload_sink_t ps = { 0 };
+    stream_async_status_t ret;
+
+    if (view == NULL || view->data == NULL || s_dma_ch < 0) {
+        return STREAM_ASYNC_ERROR;
+    }
+
+    if (live_prepare(view, format) == 0) {
+        ret = queue_view(view, capture_id, format, SERIAL_FRAME_FLAG_LIVE);
+    } else {
+        ps.dst = slot_payload();
+        ps.cap = SLOT_PAYLOAD_CAP;
+        live_encode(view, format, payload_sink, &ps);
+        ret = ps.overflow ? STREAM_ASYNC_ERROR : STREAM_ASYNC_BUSY;
+        if (ret == STREAM_ASYNC_BUSY) {
+            slot_queue((int)view->width, (int)view->height, capture_id, format,
+                       SERIAL_CODEC_TILE_DELTA, SERIAL_FRAME_FLAG_LIVE, ps.len, ps.crc);
+        }
+    }
+    if (ret == STREAM_ASYNC_ERROR) {
+        /* The host missed this frame: the next one is a keyframe */
+        serial_stream_live_reset();
+    }
+    return ret;
+}
+#endif
+
+stream_async_status_t serial_stream_async_poll(void)
+{
+    if (s_pending > 0 || MXC_UART_GetActive(MXC_UART_GET_UART(CONSOLE_UART))) {
+        return STREAM_ASYNC_BUSY;
+    }
+    return STREAM_ASYNC_IDLE;
+}
+
+void serial_stream_async_complete(void)
+{
+    /* Sleep until the DMA has drained every slot */
+    SCHED_SLEEP_WHILE(s_pending > 0);
+
+    /* Then wait for the UART FIFO to empty */
+    while (MXC_UART_GetActive(MXC_UART_GET_UART(CONSOLE_UART))) {
+        /* spin */
+    }
+}
+#endif /* SERIAL_STREAM_ASYNC_ENABLE */
+
 void serial_send_image_start(int width, int height, int capture_id)
 {
     printf("\n%s\n", IMG_START_MARKER);
@@ -13,14 +13,61 @@
 #include "mxc.h"
 #include "tft_ili9341.h"
 
+/*******************************************************************************
+ * Definitions
+ ******************************************************************************/
+
+/* RGB565 rows converted before each window write (16 rows of 128 pixels) */
+#ifndef TFT_BATCH_BYTES
+#define TFT_BATCH_BYTES     4096
+#endif
+
 /*******************************************************************************
  * Variables
  ******************************************************************************/
 
 static int s_tft_initialized = 0;
 
+#if TFT_ENABLE
+/* Retained overlay text field */
+typedef struct {
+    int16_t  x;
+    int16_t  y;
+    int16_t  width;     /* Advance of the drawn text in pixels */
+    uint16_t fg;
+    uint16_t bg;
+    char     text[TFT_OVERLAY_TEXT_LEN];
+} overlay_text_t;
+
+/* Retained overlay bar */
+typedef struct {
+    int16_t  x;
+    int16_t  y;
+    int16_t  width;
+    int16_t  height;
+    int16_t  fill;      /* Filled pixels */
+    uint16_t color;
+    uint16_t bg;
+} overlay_bar_t;
+
+static overlay_text_t s_texts[TFT_OVERLAY_TEXTS];
+static int s_num_texts = 0;
+static overlay_bar_t s_bars[TFT_OVERLAY_BARS];
+static int s_num_bars = 0;
+
+/* Row batch of the window opened by tft_utils_stream_begin() */
+static uint8_t s_batch[TFT_BATCH_BYTES];
+static int s_win_x = 0;
+static int s_win_y = 0;
+static int s_win_w = 0;
+static int s_win_h = 0;
+static int s_win_row = 0;       /* Rows of the window received so far */
+static int s_batch_rows = 0;    /* Rows in s_batch not yet written */
+static int s_batch_cap = 0;     /* Rows that fit in s_batch */
+#endif
+
 /* Font for text display */
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
 extern const unsigned char Arial12x12[];
 #endif
 
@@ -30,7 +77,7 @@ extern const unsigned char Arial12x12[];
 
 tft_status_t tft_utils_init(void)
 {
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     int ret;
 
     printf("Initializing TFT display...\n");
@@ -61,7 +108,7 @@ tft_status_t tft_utils_init(void)
 void tft_utils_display_image(int x, int y, int width, int height,
                               const uint8_t *rgb565_data)
 {
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     if (!s_tft_initialized || rgb565_data == NULL) {
         return;
     }
@@ -85,43 +132,107 @@ void tft_utils_display_image(int x, int y, int width, int height,
 #endif
 }
 
-void tft_utils_display_cnn_buffer(int x, int y, int width, int height,
-                                   const uint32_t *cnn_buffer)
+#if TFT_ENABLE
+/**
+ * @brief   Convert one line of (B<<16)|(G<<8)|R words to big-endian RGB565.
+ *
+ * @param   xor_mask    0x00808080 for CNN buffers, 0 for raw camera words.
+ */
+static void convert_line(uint8_t *dst, const uint32_t *pixels, int width, uint32_t xor_mask)
 {
-#ifdef TFT_ENABLE
-    static uint8_t rgb565_line[TFT_WIDTH * 2];  /* One line buffer */
     uint32_t pixel;
     uint8_t r, g, b;
     uint16_t rgb565;
-    int idx;
-    int line_idx;
 
+    for (int col = 0; col < width; col++) {
+        pixel = pixels[col] ^ xor_mask;
+        r = (uint8_t)(pixel & 0xFF);
+        g = (uint8_t)((pixel >> 8) & 0xFF);
+        b = (uint8_t)((pixel >> 16) & 0xFF);
+
+        /* Convert to RGB565 */
+        rgb565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+
+        /* Store in big-endian format for TFT */
+        *dst++ = (rgb565 >> 8) & 0xFF;
+        *dst++ = rgb565 & 0xFF;
+    }
+}
+
+/**
+ * @brief   Write the converted rows of the batch as one window.
+ */
+static void flush_batch(void)
+{
+    if (s_batch_rows == 0) {
+        return;
+    }
+
+    MXC_TFT_WriteBufferRGB565(s_win_x, s_win_y + s_win_row - s_batch_rows, s_batch,
+                              s_win_w, s_batch_rows);
+    s_batch_rows = 0;
+}
+#endif
+
+void tft_utils_stream_begin(int x, int y, int width, int height)
+{
+#if TFT_ENABLE
+    if (width > TFT_WIDTH) {
+        width = TFT_WIDTH;
+    }
+    if (width > TFT_BATCH_BYTES / 2) {
+        width = TFT_BATCH_BYTES / 2;
+    }
+
+    s_win_x = x;
+    s_win_y = y;
+    s_win_w = width;
+    s_win_h = height;
+    s_win_row = 0;
+    s_batch_rows = 0;
+    s_batch_cap = (width > 0) ? TFT_BATCH_BYTES / (width * 2) : 0;
+#else
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+#endif
+}
+
+void tft_utils_stream_row(const uint32_t *pixels, int cnn_format)
+{
+#if TFT_ENABLE
+    if (!s_tft_initialized || pixels == NULL || s_win_row >= s_win_h || s_batch_cap == 0) {
+        return;
+    }
+
+    convert_line(&s_batch[s_batch_rows * s_win_w * 2], pixels, s_win_w,
+                 cnn_format ? 0x00808080U : 0);
+    s_batch_rows++;
+    s_win_row++;
+
+    if (s_batch_rows == s_batch_cap || s_win_row == s_win_h) {
+        flush_batch();
+    }
+#else
+    (void)pixels;
+    (void)cnn_format;
+#endif
+}
+
+void tft_utils_display_cnn_buffer(int x, int y, int width, int height,
+                                   const uint32_t *cnn_buffer)
+{
+#if TFT_ENABLE
     if (!s_tft_initialized || cnn_buffer == NULL) {
         return;
     }
 
-    /* Convert and display line by line to save memory */
+    /* Convert a batch of lines at a time, one window write per batch */
+    tft_utils_stream_begin(x, y, width, height);
     for (int row = 0; row < height; row++) {
-        line_idx = 0;
-        for (int col = 0; col < width; col++) {
-            idx = row * width + col;
-
-            /* CNN buffer format: (B<<16)|(G<<8)|R XOR 0x00808080 */
-            pixel = cnn_buffer[idx] ^ 0x00808080U;
-            r = (uint8_t)(pixel & 0xFF);
-            g = (uint8_t)((pixel >> 8) & 0xFF);
-            b = (uint8_t)((pixel >> 16) & 0xFF);
-
-            /* Convert to RGB565 */
-            rgb565 = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
-
-            /* Store in big-endian format for TFT */
-            rgb565_line[line_idx++] = (rgb565 >> 8) & 0xFF;
-            rgb565_line[line_idx++] = rgb565 & 0xFF;
-        }
-
-        /* Write this line to TFT */
-        MXC_TFT_WriteBufferRGB565(x, y + row, rgb565_line, width, 1);
+        /* CNN buffer format: (B<<16)|(G<<8)|R XOR 0x00808080 */
+        tft_utils_stream_row(&cnn_buffer[row * width], 1);
     }
 #else
     (void)x;
@@ -135,7 +246,7 @@ void tft_utils_display_cnn_buffer(int x, int y, int width, int height,
 void tft_utils_print(int x, int y, const char *text,
                       uint16_t fg_color, uint16_t bg_color)
 {
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     if (!s_tft_initialized || text == NULL) {
         return;
     }
@@ -152,12 +263,231 @@ void tft_utils_print(int x, int y, const char *text,
 #endif
 }
 
+#if TFT_ENABLE
+/**
+ * @brief   Find the retained text at (x, y), or take a free entry.
+ *
+ * @return  The entry, or NULL if none is left. *fresh is 1 for a new one.
+ */
+static overlay_text_t *find_text(int x, int y, int *fresh)
+{
+    for (int i = 0; i < s_num_texts; i++) {
+        if (s_texts[i].x == x && s_texts[i].y == y) {
+            *fresh = 0;
+            return &s_texts[i];
+        }
+    }
+    if (s_num_texts == TFT_OVERLAY_TEXTS) {
+        return NULL;
+    }
+
+    *fresh = 1;
+    s_texts[s_num_texts].x = (int16_t)x;
+    s_texts[s_num_texts].y = (int16_t)y;
+    s_texts[s_num_texts].width = 0;
+    s_texts[s_num_texts].text[0] = '\0';
+    return &s_texts[s_num_texts++];
+}
+
+/**
+ * @brief   Pixel advance of a string in the overlay font.
+ *
+ * Arial12x12 header: bytes per glyph, cell width, cell height, bytes per
+ * column; glyphs start at ' ' and begin with their ink width. The driver
+ * advances by ink width + 2, at most the cell width.
+ */
+static int text_width(const char *text)
+{
+#if TFT_OVERLAY_GLYPH_WIDTH > 0
+    return (int)strlen(text) * TFT_OVERLAY_GLYPH_WIDTH;
+#else
+    const unsigned char *font = Arial12x12;
+    int cell = font[1];
+    int width = 0;
+    int w;
+    unsigned int c;
+
+    for (; *text != '\0'; text++) {
+        c = (unsigned char)*text;
+        w = cell;
+        if (c >= ' ' && c < 0x7F) {
+            w = font[4 + (c - ' ') * font[0]] + 2;
+            w = (w < cell) ? w : cell;
+        }
+        width += w;
+    }
+    return width;
+#endif
+}
+
+/**
+ * @brief   Cell height of the overlay font.
+ */
+static int text_height(void)
+{
+    return Arial12x12[2];
+}
+#endif
+
+void tft_utils_overlay_text(int x, int y, const char *text,
+                            uint16_t fg_color, uint16_t bg_color)
+{
+#if TFT_ENABLE
+    char buf[TFT_OVERLAY_TEXT_LEN];
+    overlay_text_t *item;
+    int fresh;
+    int old_len, new_len;
+    int new_width;
+    int first;
+#if TFT_OVERLAY_GLYPH_WIDTH > 0
+    char run[TFT_OVERLAY_TEXT_LEN];
+    int last;
+#endif
+
+    if (!s_tft_initialized || text == NULL) {
+        return;
+    }
+
+    item = find_text(x, y, &fresh);
+    if (item == NULL) {
+        /* Out of entries: draw without retaining */
+        tft_utils_print(x, y, text, fg_color, bg_color);
+        return;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", text);
+    new_len = (int)strlen(buf);
+    old_len = (int)strlen(item->text);
+    new_width = text_width(buf);
+
+    if (fresh || item->fg != fg_color || item->bg != bg_color) {
+        tft_utils_print(x, y, buf, fg_color, bg_color);
+    } else {
+        /* Changed character run */
+        for (first = 0; first < new_len && buf[first] == item->text[first]; first++) {
+        }
+        if (first == new_len && new_len == old_len) {
+            return;
+        }
+#if TFT_OVERLAY_GLYPH_WIDTH > 0
+        if (first < new_len) {
+            last = new_len - 1;
+            if (new_len == old_len) {
+                for (; last > first && buf[last] == item->text[last]; last--) {
+                }
+            }
+            memcpy(run, &buf[first], (size_t)(last - first + 1));
+            run[last - first + 1] = '\0';
+            tft_utils_print(x + first * TFT_OVERLAY_GLYPH_WIDTH, y, run, fg_color, bg_color);
+        }
+#else
+        /* Proportional font: glyph positions depend on earlier glyphs */
+        tft_utils_print(x, y, buf, fg_color, bg_color);
+#endif
+    }
+
+    /* Clear what the old text covered beyond the new one; padding spaces
+     * would not, as they are narrower than digits in a proportional font */
+    if (!fresh && new_width < item->width) {
+        tft_utils_fill_rect(x + new_width, y, item->width - new_width, text_height(), bg_color);
+    }
+
+    memcpy(item->text, buf, (size_t)new_len + 1);
+    item->width = (int16_t)new_width;
+    item->fg = fg_color;
+    item->bg = bg_color;
+#else
+    (void)x;
+    (void)y;
+    (void)text;
+    (void)fg_color;
+    (void)bg_color;
+#endif
+}
+
+void tft_utils_overlay_bar(int x, int y, int width, int height, int percent,
+                           uint16_t color, uint16_t bg_color)
+{
+#if TFT_ENABLE
+    overlay_bar_t *bar = NULL;
+    int fill;
+
+    if (!s_tft_initialized) {
+        return;
+    }
+
+    if (percent < 0) {
+        percent = 0;
+    } else if (percent > 100) {
+        percent = 100;
+    }
+    fill = (percent * width) / 100;
+
+    for (int i = 0; i < s_num_bars; i++) {
+        if (s_bars[i].x == x && s_bars[i].y == y) {
+            bar = &s_bars[i];
+            break;
+        }
+    }
+
+    if (bar == NULL || bar->width != width || bar->height != height || bar->bg != bg_color) {
+        /* Unknown bar: full draw */
+        tft_utils_fill_rect(x, y, width, height, bg_color);
+        if (fill > 0) {
+            tft_utils_fill_rect(x, y, fill, height, color);
+        }
+        if (bar == NULL) {
+            if (s_num_bars == TFT_OVERLAY_BARS) {
+                return;
+            }
+            bar = &s_bars[s_num_bars++];
+        }
+    } else if (bar->color != color) {
+        /* Color change: redraw the fill, clear any removed part */
+        if (fill > 0) {
+            tft_utils_fill_rect(x, y, fill, height, color);
+        }
+        if (fill < bar->fill) {
+            tft_utils_fill_rect(x + fill, y, bar->fill - fill, height, bg_color);
+        }
+    } else if (fill > bar->fill) {
+        tft_utils_fill_rect(x + bar->fill, y, fill - bar->fill, height, color);
+    } else if (fill < bar->fill) {
+        tft_utils_fill_rect(x + fill, y, bar->fill - fill, height, bg_color);
+    }
+
+    bar->x = (int16_t)x;
+    bar->y = (int16_t)y;
+    bar->width = (int16_t)width;
+    bar->height = (int16_t)height;
+    bar->fill = (int16_t)fill;
+    bar->color = color;
+    bar->bg = bg_color;
+#else
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+    (void)percent;
+    (void)color;
+    (void)bg_color;
+#endif
+}
+
+void tft_utils_overlay_reset(void)
+{
+#if TFT_ENABLE
+    s_num_texts = 0;
+    s_num_bars = 0;
+#endif
+}
+
 void tft_utils_show_results(const char (*class_names)[20],
                              const int *confidences,
                              int num_classes,
                              int predicted_class)
 {
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     char buf[32];
     int bar_x = 140;
     int bar_y = 180;
@@ -169,35 +499,27 @@ void tft_utils_show_results(const char (*class_names)[20],
         return;
     }
 
+    /* Overlay items: only what changed since the last call is drawn */
     for (int i = 0; i < num_classes; i++) {
         int y_pos = bar_y + (i * spacing);
         int conf = confidences[i];
-        int fill_width = (conf * bar_width) / 100;
         uint16_t bar_color = (i == predicted_class) ? TFT_GREEN : TFT_BLUE;
 
         /* Class name */
         snprintf(buf, sizeof(buf), "%s:", class_names[i]);
-        tft_utils_print(10, y_pos + 4, buf, TFT_WHITE, TFT_BLACK);
-
-        /* Background bar */
-        tft_utils_fill_rect(bar_x, y_pos, bar_width, bar_height, TFT_BLACK);
-
-        /* Filled portion */
-        if (fill_width > 0) {
-            tft_utils_fill_rect(bar_x, y_pos, fill_width, bar_height, bar_color);
-        }
+        tft_utils_overlay_text(10, y_pos + 4, buf, TFT_WHITE, TFT_BLACK);
 
-        /* Border */
-        /* Draw manually using lines would be ideal, but simplified here */
+        /* Bar */
+        tft_utils_overlay_bar(bar_x, y_pos, bar_width, bar_height, conf, bar_color, TFT_BLACK);
 
         /* Percentage text */
         snprintf(buf, sizeof(buf), "%d%%", conf);
-        tft_utils_print(bar_x + bar_width + 5, y_pos + 4, buf, TFT_WHITE, TFT_BLACK);
+        tft_utils_overlay_text(bar_x + bar_width + 5, y_pos + 4, buf, TFT_WHITE, TFT_BLACK);
     }
 
     /* Show prediction */
     snprintf(buf, sizeof(buf), ">> %s <<", class_names[predicted_class]);
-    tft_utils_print(80, bar_y - 30, buf, TFT_YELLOW, TFT_BLACK);
+    tft_utils_overlay_text(80, bar_y - 30, buf, TFT_YELLOW, TFT_BLACK);
 #else
     (void)class_names;
     (void)confidences;
@@ -208,13 +530,14 @@ void tft_utils_show_results(const char (*class_names)[20],
 
 void tft_utils_clear(uint16_t color)
 {
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     if (!s_tft_initialized) {
         return;
     }
 
     MXC_TFT_SetBackGroundColor(color);
     MXC_TFT_ClearScreen();
+    tft_utils_overlay_reset();
 #else
     (void)color;
 #endif
@@ -222,7 +545,7 @@ void tft_utils_clear(uint16_t color)
 
 void tft_utils_fill_rect(int x, int y, int width, int height, uint16_t color)
 {
-#ifdef TFT_ENABLE
+#if TFT_ENABLE
     if (!s_tft_initialized) {
         return;
     }
@@ -0,0 +1,293 @@
+#!/usr/bin/env python3
+"""
+MAX78000 Benchmark Regression Check
+
+Parses the <<<PROFILE>>> and <<<BENCHMARK>>> blocks printed by the benchmark
+firmware ("make BENCHMARK=1") and compares them with a stored baseline.
+Exits with status 1 when outputs mismatch, the weights changed, or a timing
+got worse than the tolerance.
+
+Usage:
+    python bench_compare.py bench.log --save-baseline bench_baseline.json
+    python bench_compare.py bench.log --baseline bench_baseline.json
+    python bench_compare.py --port /dev/ttyUSB0 --baseline bench_baseline.json
+    python bench_compare.py --port /dev/ttyUSB0 --baseline bench_baseline.json --tolerance 3
+
+Requirements:
+    pip install pyserial   (only for --port)
+"""
+
+import argparse
+import json
+import re
+import sys
+import time
+from datetime import datetime
+from pathlib import Path
+
+
+BENCHMARK_MARKER = "<<<BENCHMARK>>>"
+PROFILE_MARKER = "<<<PROFILE>>>"
+RESULT_LINES = ("*** PASS ***", "*** FAIL ***")
+PROFILE_LINE = re.compile(r"^Profile (\S+)$")
+SPAN_VALUE = re.compile(r"^min (\d+) avg (\d+) max (\d+)$")
+
+# Metrics checked against the baseline: name -> True when higher is better
+TIMED_METRICS = {
+    'latency_us_avg': False,
+    'cnn_us_avg': False,
+    'convert_us_avg': False,
+    'convert_rgb565_us_avg': False,
+    'fifo_load_us_avg': False,
+    'throughput_ips': True,
+    'batch_ips': True,
+    'fifo_load_mwords_s': True,
+}
+
+# Values that must stay the same for two reports to be comparable
+SAME_METRICS = ('iterations', 'clock_mhz')
+
+
+def parse_value(key, text):
+    """Convert one "key: value" pair of a benchmark block into metric entries."""
+    span = SPAN_VALUE.match(text)
+    if span:
+        return {f"{key}_{name}": int(v) for name, v in zip(("min", "avg", "max"), span.groups())}
+    if text.startswith("n/a"):
+        return {key: None}
+    token = text.split()[0]
+    if token.startswith("0x"):
+        return {key: token}
+    try:
+        return {key: int(token)}
+    except ValueError:
+        pass
+    try:
+        return {key: float(token)}
+    except ValueError:
+        return {key: text}
+
+
+def parse_report(lines):
+    """Split benchmark output into runs.
+
+    Each run has the "metrics" of a <<<BENCHMARK>>> block, the "stages" of the
+    <<<PROFILE>>> block printed before it and the "profile" name announced by
+    power profile builds. The PASS/FAIL line ends the report.
+
+    Returns (runs, result) with result "PASS", "FAIL" or None.
+    """
+    runs = []
+    stages = {}
+    profile = None
+    block = None
+    header = None
+    result = None
+
+    for raw in lines:
+        line = raw.rstrip("\r\n")
+        stripped = line.strip()
+
+        if stripped == PROFILE_MARKER:
+            if block == "profile":
+                block = None
+            else:
+                block, header, stages = "profile", None, {}
+            continue
+        if stripped == BENCHMARK_MARKER:
+            if block == "benchmark":
+                runs.append({'profile': profile, 'metrics': metrics, 'stages': stages})
+                block, stages = None, {}
+            else:
+                block, metrics = "benchmark", {}
+            continue
+
+        if block == "profile":
+            fields = stripped.split(",")
+            if header is None:
+                header = fields
+            elif len(fields) == len(header):
+                stages[fields[0]] = {k: int(v) for k, v in zip(header[1:], fields[1:])}
+        elif block == "benchmark":
+            # Histogram rows are indented, the histogram title has no value
+            if line.startswith(" ") or ":" not in stripped:
+                continue
+            key, _, text = stripped.partition(":")
+            if text.strip():
+                metrics.update(parse_value(key.strip(), text.strip()))
+        else:
+            match = PROFILE_LINE.match(stripped)
+            if match:
+                profile = match.group(1)
+            elif stripped in RESULT_LINES:
+                result = stripped.strip("* ")
+                break
+
+    return runs, result
+
+
+def read_port(port, baud, timeout):
+    """Collect benchmark output from the board until the PASS/FAIL line."""
+    import serial
+
+    lines = []
+    deadline = time.time() + timeout
+    with serial.Serial(port, baud, timeout=0.5) as ser:
+        print(f"Waiting for benchmark output on {port} (reset the board)...")
+        while time.time() < deadline:
+            line = ser.readline().decode("utf-8", errors="replace")
+            if not line:
+                continue
+            lines.append(line)
+            if line.strip() in RESULT_LINES:
+                return lines
+    raise TimeoutError(f"no benchmark result within {timeout:.0f} s")
+
+
+def run_name(run, index):
+    return run['profile'] or f"run {index}"
+
+
+def worse_by(base, value, higher_is_better):
+    """Relative change in percent, positive when value is worse than base."""
+    if not base:
+        return 0.0
+    change = (value - base) * 100.0 / base
+    return -change if higher_is_better else change
+
+
+def check_run(name, base, cur, args):
+    """Compare one run with its baseline. Returns (failures, lines)."""
+    failures = []
+    lines = []
+    bm, cm = base['metrics'], cur['metrics']
+
+    for key in SAME_METRICS:
+        if bm.get(key) != cm.get(key):
+            failures.append(f"{name}: {key} {bm.get(key)} -> {cm.get(key)}, "
+                            f"reports are not comparable")
+    if bm.get('weights_crc32') != cm.get('weights_crc32'):
+        msg = (f"{name}: weights changed ({bm.get('weights_crc32')} -> "
+               f"{cm.get('weights_crc32')}, {cm.get('network_ops')} ops)")
+        if args.allow_weights_change:
+            lines.append(f"  note: {msg}")
+        else:
+            failures.append(msg + "; rerun with --allow-weights-change and save a new baseline")
+
+    checks = [(key, bm.get(key), cm.get(key), higher) for key, higher in TIMED_METRICS.items()]
+    for stage, st in sorted(cur['stages'].items()):
+        if stage in base['stages']:
+            checks.append((f"stage {stage} avg_us", base['stages'][stage]['avg_us'],
+                           st['avg_us'], False))
+
+    lines.append(f"  {'metric':<28} {'baseline':>12} {'current':>12} {'change':>8}")
+    for key, b, c, higher in checks:
+        if b is None or c is None:
+            if b is not None:
+                failures.append(f"{name}: {key} missing (baseline {b})")
+            continue
+        worse = worse_by(b, c, higher)
+        # Small spans jitter by a cycle count or two: also need an absolute step
+        significant = higher or abs(c - b) >= args.min_us
+        status = ""
+        if worse > args.tolerance and significant:
+            status = "  REGRESSION"
+            failures.append(f"{name}: {key} {b} -> {c} ({worse:+.1f}% worse, "
+                            f"limit {args.tolerance:g}%)")
+        elif worse < -args.tolerance and significant:
+            status = "  improved"
+        sign = -1 if higher else 1
+        lines.append(f"  {key:<28} {b:>12} {c:>12} {sign * worse:>+7.1f}%{status}")
+
+    return failures, lines
+
+
+def check_report(runs, result, baseline, args):
+    """Check a report on its own and against the baseline. Returns failures."""
+    failures = []
+
+    if not runs:
+        return ["no <<<BENCHMARK>>> block found"]
+    if result != "PASS":
+        failures.append(f"firmware reported {result or 'no result'}")
+    for i, run in enumerate(runs):
+        name = run_name(run, i)
+        for key in ('mismatches', 'bias_mismatches'):
+            if run['metrics'].get(key):
+                failures.append(f"{name}: {run['metrics'][key]} {key.replace('_', ' ')}")
+        if run['metrics'].get('batch_ips', 0) is None:
+            failures.append(f"{name}: batch run failed")
+
+    if baseline is None:
+        return failures
+
+    base_runs = {run_name(run, i): run for i, run in enumerate(baseline['runs'])}
+    for i, run in enumerate(runs):
+        name = run_name(run, i)
+        if name not in base_runs:
+            print(f"{name}: not in the baseline, skipped")
+            continue
+        print(f"{name}:")
+        run_failures, lines = check_run(name, base_runs[name], run, args)
+        print("\n".join(lines))
+        failures += run_failures
+    for name in base_runs:
+        if name not in [run_name(run, i) for i, run in enumerate(runs)]:
+            failures.append(f"{name}: missing from this report")
+
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare MAX78000 benchmark reports")
+    parser.add_argument("log", nargs="?", help="Captured benchmark console output")
+    parser.add_argument("--port", "-p", help="Read the report from this serial port instead")
+    parser.add_argument("--baud", "-b", type=int, default=115200, help="Baud rate (default: 115200)")
+    parser.add_argument("--timeout", type=float, default=120,
+                        help="Seconds to wait for the report on --port (default: 120)")
+    parser.add_argument("--baseline", metavar="FILE", help="Baseline JSON to compare with")
+    parser.add_argument("--save-baseline", metavar="FILE",
+                        help="Store this report as the new baseline (after the checks pass)")
+    parser.add_argument("--tolerance", type=float, default=5.0,
+                        help="Allowed slowdown in percent (default: 5)")
+    parser.add_argument("--min-us", type=int, default=2,
+                        help="Timing changes below this many us never fail (default: 2)")
+    parser.add_argument("--allow-weights-change", action="store_true",
+                        help="Accept a different kernel CRC (retrained network)")
+
+    args = parser.parse_args()
+    if bool(args.log) == bool(args.port):
+        parser.error("give either a log file or --port")
+
+    if args.port:
+        lines = read_port(args.port, args.baud, args.timeout)
+        source = args.port
+    else:
+        lines = Path(args.log).read_text(errors="replace").splitlines()
+        source = args.log
+    runs, result = parse_report(lines)
+
+    baseline = None
+    if args.baseline:
+        baseline = json.loads(Path(args.baseline).read_text())
+
+    failures = check_report(runs, result, baseline, args)
+    if failures:
+        print("\n*** BENCHMARK REGRESSION ***")
+        for failure in failures:
+            print(f"  {failure}")
+        sys.exit(1)
+
+    print(f"\n{len(runs)} run(s) OK" + (f" against {args.baseline}" if baseline else ""))
+    if args.save_baseline:
+        report = {
+            'source': str(source),
+            'saved': datetime.now().isoformat(timespec="seconds"),
+            'runs': runs,
+        }
+        Path(args.save_baseline).write_text(json.dumps(report, indent=2) + "\n")
+        print(f"Baseline saved to {args.save_baseline}")
+
+
+if __name__ == "__main__":
+    main()
@@ -8,16 +8,29 @@ and saves them as image files along with classification results.
 Usage:
     python capture_images.py --port COM3
     python capture_images.py --port /dev/ttyUSB0 --baud 115200
+    python capture_images.py --port /dev/ttyUSB0 --save-live
+    python capture_images.py --port /dev/ttyUSB0 /dev/ttyUSB1 --baud 3000000 --results csv
+    python capture_images.py --port /dev/ttyUSB0 --offload [--erase]
+    python capture_images.py --from-dump captures/capture_log_20240101_120000.bin
 
 Requirements:
     pip install pyserial pillow
+    pip install opencv-python   (optional, live feed preview window)
 """
 
 import serial
 import argparse
+import csv
+import io
+import json
 import os
 import re
+import struct
 import sys
+import threading
+import time
+import zlib
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime
 from pathlib import Path
 
@@ -27,20 +40,358 @@ except ImportError:
     print("Please install Pillow: pip install pillow")
     sys.exit(1)
 
+try:
+    import cv2
+    import numpy as np
+except ImportError:
+    cv2 = None
+
+
+# Binary frame header (see serial_stream.h)
+FRAME_MAGIC = b"MXFR"
+FRAME_HEADER = struct.Struct("<4sBBBBHHIII")
+PIXFMT_RGB888 = 0
+PIXFMT_RGB565 = 1
+CODEC_NONE = 0
+CODEC_DRLE = 1
+CODEC_JPEG = 2
+CODEC_TILE_DELTA = 3
+FRAME_FLAG_LIVE = 0x01
+TILE_HEADER = struct.Struct("<BBHHH")
+LIVE_PREVIEW_SCALE = 4
+
+# Capture log offload (see capture_log.h)
+DUMP_MAGIC = b"MXLD"
+DUMP_HEADER = struct.Struct("<4sB3xII")
+PAGE_MAGIC = b"MXLP"
+PAGE_HEADER = struct.Struct("<4sIIHH")
+RECORD_MAGIC = b"MXLG"
+RECORD_HEADER = struct.Struct("<4sIBBHHBBIB3x")
+LOG_CMD_OFFLOAD = b"D"
+LOG_CMD_ERASE = b"E"
+ERASED = b"\xff\xff\xff\xff"
+
+# Receiver
+RING_SIZE = 4 * 1024 * 1024     # Bytes buffered between reader thread and parser
+READ_CHUNK = 64 * 1024          # Largest single read from the port
+MAX_LINE = 64 * 1024            # Text without a newline is passed on at this length
+IDLE_TIMEOUT = 2.0              # Seconds without data before a frame read gives up
+RESULT_BATCH = 64               # Result rows per write
+RESULT_FLUSH_S = 2.0            # Longest time a result row waits to be written
+RESULT_FIELDS = ['port', 'capture_id', 'class', 'confidence', 'inference_time_us',
+                 'boot', 'softmax', 'image', 'timestamp']
+
+# RGB565 (big-endian) to RGB888, per byte: red and blue from one byte each,
+# green from the low 3 bits of the high byte and the top 3 of the low byte
+RGB565_R = bytes(i & 0xF8 for i in range(256))
+RGB565_G_HI = bytes((i & 0x07) << 5 for i in range(256))
+RGB565_G_LO = bytes((i >> 3) & 0x1C for i in range(256))
+RGB565_B = bytes((i << 3) & 0xF8 for i in range(256))
+
+
+def parse_log_record(buf):
+    """Parse one log record at the start of buf.
+    
+    Returns (record dict, size) or None if buf holds only part of it.
+    Raises ValueError on a corrupt record.
+    """
+    if len(buf) < RECORD_HEADER.size:
+        return None
+    (magic, capture_id, codec, pixfmt, width, height, predicted, confidence,
+     inference_us, classes) = RECORD_HEADER.unpack_from(buf)
+    if magic != RECORD_MAGIC:
+        raise ValueError(f"bad record magic {magic!r}")
+    pos = RECORD_HEADER.size
+    if len(buf) < pos + 2 * classes:
+        return None
+    softmax = list(struct.unpack_from(f"<{classes}h", buf, pos))
+    pos += 2 * classes
+    
+    payload = bytearray()
+    while True:
+        if len(buf) < pos + 2:
+            return None
+        (length,) = struct.unpack_from("<H", buf, pos)
+        pos += 2
+        if length == 0:
+            break
+        if len(buf) < pos + length:
+            return None
+        payload += buf[pos:pos + length]
+        pos += length
+    if len(buf) < pos + 4:
+        return None
+    (crc,) = struct.unpack_from("<I", buf, pos)
+    pos += 4
+    if zlib.crc32(payload) != crc:
+        raise ValueError(f"CRC mismatch on logged capture {capture_id}")
+    
+    record = {
+        'capture_id': capture_id,
+        'codec': codec,
+        'format': pixfmt,
+        'width': width,
+        'height': height,
+        'predicted': predicted,
+        'confidence': confidence,
+        'inference_time_us': inference_us,
+        'softmax': softmax,
+        'payload': bytes(payload),
+    }
+    return record, pos
+
+
+def parse_log_dump(dump):
+    """Split an offloaded capture log into records, oldest first.
+    
+    A record continues into the next page only when that page has the next
+    sequence number and the same boot; after a gap, erased padding or a
+    corrupt record, parsing resumes at the first record that starts in a
+    following page.
+    
+    Returns (records, warnings).
+    """
+    magic, version, num_pages, page_size = DUMP_HEADER.unpack_from(dump)
+    if magic != DUMP_MAGIC:
+        raise ValueError(f"bad dump magic {magic!r}")
+    body = dump[DUMP_HEADER.size:DUMP_HEADER.size + num_pages * page_size]
+    if len(body) != num_pages * page_size or len(dump) < len(body) + DUMP_HEADER.size + 4:
+        raise ValueError("truncated dump")
+    (crc,) = struct.unpack_from("<I", dump, DUMP_HEADER.size + len(body))
+    if zlib.crc32(body) != crc:
+        raise ValueError("dump CRC mismatch")
+    
+    pages = []
+    for i in range(num_pages):
+        page = body[i * page_size:(i + 1) * page_size]
+        magic, seq, erase_count, first, boot = PAGE_HEADER.unpack_from(page)
+        if magic == PAGE_MAGIC:
+            pages.append((seq, first, boot, page))
+    pages.sort(key=lambda p: p[0])
+    
+    records = []
+    warnings = []
+    buf = bytearray()
+    prev = None
+    synced = False
+    for seq, first, boot, page in pages:
+        if synced and prev == (seq - 1, boot):
+            buf += page[PAGE_HEADER.size:]
+        else:
+            # Resume at the first record starting in this page
+            buf = bytearray()
+            synced = first != 0xFFFF
+            if synced:
+                buf += page[first:]
+        prev = (seq, boot)
+        
+        while synced and len(buf) >= 4:
+            if buf[:4] == ERASED:
+                # Rest of a flushed page, the next record starts a new page
+                synced = False
+                break
+            try:
+                parsed = parse_log_record(buf)
+            except ValueError as e:
+                warnings.append(f"page {seq}: {e}")
+                synced = False
+                break
+            if parsed is None:
+                break
+            record, size = parsed
+            record['boot'] = boot
+            records.append(record)
+            del buf[:size]
+    
+    return records, warnings
+
+
+class SerialReader(threading.Thread):
+    """Background reader moving serial bytes into a preallocated ring.
+    
+    The thread reads straight into free ring space; the parser takes lines
+    and frames out of it. Only the head and tail counters are shared, so the
+    port keeps being drained while frames are parsed, decoded and saved.
+    """
+    
+    def __init__(self, port, size=RING_SIZE):
+        super().__init__(daemon=True)
+        self.port = port
+        self.size = size
+        self.ring = bytearray(size)
+        self.view = memoryview(self.ring)
+        self.head = 0           # Bytes written since start
+        self.tail = 0           # Bytes consumed since start
+        self.scan = 0           # Bytes after tail already searched for a newline
+        self.cond = threading.Condition()
+        self.running = True
+        self.stalls = 0         # Times the ring was full
+        self.error = None
+    
+    def run(self):
+        while self.running:
+            with self.cond:
+                free = self.size - (self.head - self.tail)
+                if free == 0:
+                    # Parser behind: the OS buffer holds the bytes meanwhile
+                    self.stalls += 1
+                    self.cond.wait(0.05)
+                    continue
+            start = self.head % self.size
+            try:
+                want = min(free, self.size - start, READ_CHUNK,
+                           max(1, self.port.in_waiting))
+                n = self.port.readinto(self.view[start:start + want])
+            except (serial.SerialException, OSError, TypeError, AttributeError) as e:
+                if self.running:
+                    self.error = e
+                break
+            if n:
+                with self.cond:
+                    self.head += n
+                    self.cond.notify_all()
+        with self.cond:
+            self.running = False
+            self.cond.notify_all()
+    
+    def stop(self):
+        """Stop the thread (returns once the current read finished)."""
+        with self.cond:
+            self.running = False
+            self.cond.notify_all()
+        if self.is_alive():
+            self.join()
+    
+    def discard(self):
+        """Drop every buffered byte."""
+        with self.cond:
+            self.tail = self.head
+            self.scan = 0
+            self.cond.notify_all()
+    
+    def _newline(self):
+        """Offset of the next newline after tail, or -1 (lock held)."""
+        while self.scan < self.head - self.tail:
+            pos = (self.tail + self.scan) % self.size
+            end = min(self.size, pos + self.head - self.tail - self.scan)
+            i = self.ring.find(b"\n", pos, end)
+            if i >= 0:
+                return self.scan + i - pos
+            self.scan += end - pos
+        if self.scan >= min(MAX_LINE, self.size):
+            return self.scan - 1
+        return -1
+    
+    def _take(self, out, offset, n):
+        """Move n bytes from tail into out[offset:] (lock held)."""
+        pos = self.tail % self.size
+        first = min(n, self.size - pos)
+        out[offset:offset + first] = self.view[pos:pos + first]
+        if first < n:
+            out[offset + first:offset + n] = self.view[:n - first]
+        self.tail += n
+        self.scan = max(0, self.scan - n)
+        self.cond.notify_all()
+    
+    def readline(self, timeout=1.0):
+        """Next line including its newline, or None if none arrives in time."""
+        with self.cond:
+            if not self.cond.wait_for(lambda: self._newline() >= 0 or not self.running,
+                                      timeout):
+                return None
+            n = self._newline() + 1
+            if n == 0:
+                return None
+            line = bytearray(n)
+            self._take(line, 0, n)
+            self.scan = 0
+            return line
+    
+    def read_exact(self, size, timeout=IDLE_TIMEOUT):
+        """Exactly size bytes, or None after timeout seconds without data."""
+        out = bytearray(size)
+        got = 0
+        with self.cond:
+            while got < size:
+                if not self.cond.wait_for(lambda: self.head > self.tail or not self.running,
+                                          timeout) or self.head == self.tail:
+                    return None
+                n = min(size - got, self.head - self.tail)
+                self._take(out, got, n)
+                got += n
+        return out
+
+
+class ResultLog:
+    """Capture results appended to results.csv or results.jsonl in batches."""
+    
+    def __init__(self, path, fmt, batch=RESULT_BATCH, interval=RESULT_FLUSH_S):
+        self.path = Path(path)
+        self.fmt = fmt
+        self.batch = batch
+        self.interval = interval
+        self.rows = []
+        self.lock = threading.Lock()
+        self.last_flush = time.monotonic()
+    
+    def add(self, row):
+        """Queue one result row (thread-safe)."""
+        with self.lock:
+            self.rows.append(row)
+            if (len(self.rows) >= self.batch or
+                    time.monotonic() - self.last_flush >= self.interval):
+                self._flush()
+    
+    def close(self):
+        """Write the rows still queued."""
+        with self.lock:
+            self._flush()
+    
+    def _flush(self):
+        rows, self.rows = self.rows, []
+        self.last_flush = time.monotonic()
+        if not rows:
+            return
+        new_file = not self.path.exists()
+        with open(self.path, 'a', newline='') as f:
+            if self.fmt == 'jsonl':
+                f.write(''.join(json.dumps(row) + '\n' for row in rows))
+                return
+            writer = csv.DictWriter(f, fieldnames=RESULT_FIELDS, extrasaction='ignore')
+            if new_file:
+                writer.writeheader()
+            for row in rows:
+                row = dict(row)
+                if 'softmax' in row:
+                    row['softmax'] = ' '.join(str(v) for v in row['softmax'])
+                writer.writerow(row)
+
 
 class ImageCapture:
-    def __init__(self, port, baud=115200, output_dir="captures"):
+    def __init__(self, port, baud=115200, output_dir="captures", pool=None, results=None):
         self.port = port
         self.baud = baud
         self.output_dir = Path(output_dir)
-        self.output_dir.mkdir(exist_ok=True)
+        self.output_dir.mkdir(parents=True, exist_ok=True)
         self.serial = None
+        self.reader = None
+        self.pool = pool            # Executor saving captures, None to save inline
+        self.results = results      # ResultLog, None for a .txt file per capture
+        self.stop_event = threading.Event()
+        self.preview_window = True
         self.capture_count = 0
+        self.class_names = ["Horse", "Human"]
+        self.save_live = False
+        self.live_frame = None      # RGB888 bytearray of the last live frame
+        self.live_size = None
+        self.live_png_lock = threading.Lock()
         
     def connect(self):
         """Connect to serial port."""
         try:
-            self.serial = serial.Serial(self.port, self.baud, timeout=1)
+            self.serial = serial.Serial(self.port, self.baud, timeout=0.2)
+            self.reader = SerialReader(self.serial)
+            self.reader.start()
             print(f"Connected to {self.port} at {self.baud} baud")
             return True
         except serial.SerialException as e:
@@ -49,17 +400,234 @@ class ImageCapture:
     
     def disconnect(self):
         """Disconnect from serial port."""
+        if self.reader:
+            self.reader.stop()
+            if self.reader.stalls:
+                print(f"[{self.port}] Receive ring was full {self.reader.stalls} times")
         if self.serial:
             self.serial.close()
-            print("Disconnected")
+            print(f"Disconnected from {self.port}")
+    
+    def stop(self):
+        """Make run() return (from another thread)."""
+        self.stop_event.set()
     
     def read_line(self):
-        """Read a line from serial."""
-        try:
-            line = self.serial.readline().decode('utf-8', errors='ignore').strip()
-            return line
-        except:
+        """Read a line from the receive ring, or None if none arrived in time."""
+        line = self.reader.readline()
+        if line is None:
+            return None
+        return line.decode('utf-8', errors='ignore').strip()
+    
+    def read_exact(self, size):
+        """Read exactly size bytes from the receive ring, or None on timeout."""
+        return self.reader.read_exact(size)
+    
+    def read_frame(self):
+        """Read a binary frame after the <<<FRAME>>> marker.
+        
+        Returns (header dict, payload bytes) or None if the frame is bad.
+        """
+        raw = self.read_exact(FRAME_HEADER.size)
+        if raw is None:
+            print("Error: Timeout reading frame header")
+            return None
+        
+        (magic, version, pixfmt, codec, flags,
+         width, height, capture_id, length, crc) = FRAME_HEADER.unpack(raw)
+        if magic != FRAME_MAGIC:
+            print(f"Error: Bad frame magic {magic!r}")
+            return None
+        
+        payload = self.read_exact(length)
+        if payload is None:
+            print(f"Error: Timeout reading {length}-byte payload")
+            return None
+        if zlib.crc32(payload) != crc:
+            print(f"Error: CRC mismatch on capture {capture_id}")
+            return None
+        
+        header = {
+            'version': version,
+            'format': pixfmt,
+            'codec': codec,
+            'flags': flags,
+            'width': width,
+            'height': height,
+            'capture_id': capture_id,
+        }
+        return header, payload
+    
+    def decode_drle(self, payload, num_pixels):
+        """Undo DRLE (PackBits of planar R/G/B deltas) into RGB888 bytes."""
+        planes = bytearray()
+        i = 0
+        while i < len(payload):
+            c = payload[i]
+            i += 1
+            if c < 0x80:
+                planes += payload[i:i + c + 1]
+                i += c + 1
+            else:
+                planes += bytes([payload[i]]) * (c - 0x80 + 3)
+                i += 1
+        
+        if len(planes) != num_pixels * 3:
+            print(f"Warning: DRLE decoded {len(planes)} bytes, expected {num_pixels*3}")
+            return None
+        
+        rgb = bytearray(num_pixels * 3)
+        for ch in range(3):
+            prev = 0
+            base = ch * num_pixels
+            for p in range(num_pixels):
+                prev = (prev + planes[base + p]) & 0xFF
+                rgb[3 * p + ch] = prev
+        return bytes(rgb)
+    
+    def decode_frame(self, header, payload):
+        """Create PIL Image from a binary frame payload."""
+        width = header['width']
+        height = header['height']
+        
+        if header['codec'] == CODEC_DRLE:
+            payload = self.decode_drle(payload, width * height)
+            if payload is None:
+                return None
+        elif header['codec'] == CODEC_JPEG:
+            try:
+                return Image.open(io.BytesIO(payload)).convert('RGB')
+            except OSError as e:
+                print(f"Warning: Bad JPEG payload: {e}")
+                return None
+        elif header['codec'] != CODEC_NONE:
+            print(f"Warning: Unsupported codec {header['codec']}")
+            return None
+        
+        rgb = self.to_rgb888(payload, header['format'], width * height)
+        if rgb is None:
+            return None
+        return Image.frombytes('RGB', (width, height), rgb)
+    
+    def to_rgb888(self, data, pixfmt, num_pixels):
+        """Convert RGB888 or RGB565 pixel bytes to RGB888 bytes."""
+        if pixfmt == PIXFMT_RGB888:
+            if len(data) != num_pixels * 3:
+                print(f"Warning: Expected {num_pixels*3} bytes, got {len(data)}")
+                return None
+            return bytes(data)
+        
+        if pixfmt == PIXFMT_RGB565:
+            if len(data) != num_pixels * 2:
+                print(f"Warning: Expected {num_pixels*2} bytes, got {len(data)}")
+                return None
+            # Whole-plane table lookups instead of a Python loop per pixel
+            hi = bytes(data[0::2])
+            lo = bytes(data[1::2])
+            green = (int.from_bytes(hi.translate(RGB565_G_HI), 'little') |
+                     int.from_bytes(lo.translate(RGB565_G_LO), 'little'))
+            rgb = bytearray(num_pixels * 3)
+            rgb[0::3] = hi.translate(RGB565_R)
+            rgb[1::3] = green.to_bytes(num_pixels, 'little')
+            rgb[2::3] = lo.translate(RGB565_B)
+            return bytes(rgb)
+        
+        print(f"Warning: Unsupported pixel format {pixfmt}")
+        return None
+    
+    def apply_tile_delta(self, header, payload):
+        """Update the live frame with the tiles of a delta frame.
+        
+        Returns the number of tiles updated, or None when the delta cannot be
+        applied (no keyframe yet, size change or bad payload).
+        """
+        width = header['width']
+        height = header['height']
+        if self.live_frame is None or self.live_size != (width, height):
+            return None
+        if len(payload) < TILE_HEADER.size:
+            return None
+        tile, pixfmt, across, down, changed = TILE_HEADER.unpack_from(payload)
+        if tile == 0 or across != (width + tile - 1) // tile or \
+                down != (height + tile - 1) // tile:
+            print(f"Warning: Bad tile grid {across}x{down} of {tile}px")
+            return None
+        bpp = 2 if pixfmt == PIXFMT_RGB565 else 3
+        bitmap = payload[TILE_HEADER.size:TILE_HEADER.size + (across * down + 7) // 8]
+        pos = TILE_HEADER.size + len(bitmap)
+        
+        count = 0
+        for t in range(across * down):
+            if not (bitmap[t // 8] >> (t % 8)) & 1:
+                continue
+            x0 = (t % across) * tile
+            y0 = (t // across) * tile
+            w = min(tile, width - x0)
+            h = min(tile, height - y0)
+            rgb = self.to_rgb888(payload[pos:pos + w * h * bpp], pixfmt, w * h)
+            if rgb is None:
+                return None
+            pos += w * h * bpp
+            for row in range(h):
+                dst = ((y0 + row) * width + x0) * 3
+                self.live_frame[dst:dst + w * 3] = rgb[row * w * 3:(row + 1) * w * 3]
+            count += 1
+        
+        if count != changed or pos != len(payload):
+            print(f"Warning: Delta holds {count} tiles, header says {changed}")
             return None
+        return count
+    
+    def receive_live(self, header, payload, result):
+        """Rebuild a live-stream frame, preview it, and save it with --save-live."""
+        width = header['width']
+        height = header['height']
+        if header['codec'] == CODEC_TILE_DELTA:
+            tiles = self.apply_tile_delta(header, payload)
+            if tiles is None:
+                print("[Live] Delta skipped, waiting for a keyframe")
+                return
+            kind = f"{tiles} tiles"
+        else:
+            img = self.decode_frame(header, payload)
+            if img is None:
+                self.live_frame = None
+                return
+            self.live_frame = bytearray(img.tobytes())
+            self.live_size = (width, height)
+            kind = "keyframe"
+        
+        print(f"[Live {header['capture_id']}] {kind}, {len(payload)} bytes")
+        img = Image.frombytes('RGB', self.live_size, bytes(self.live_frame))
+        self.show_live(img)
+        if self.save_live:
+            if 'capture_id' not in result:
+                result['capture_id'] = header['capture_id']
+            if self.pool is None:
+                self.save_capture(img, result, prefix="live")
+            else:
+                self.pool.submit(self.save_capture, img, result, "live")
+    
+    def show_live(self, img):
+        """Show the live frame in a window (OpenCV) or as live.png."""
+        if cv2 is not None and self.preview_window:
+            bgr = cv2.cvtColor(np.asarray(img), cv2.COLOR_RGB2BGR)
+            bgr = cv2.resize(bgr, None, fx=LIVE_PREVIEW_SCALE, fy=LIVE_PREVIEW_SCALE,
+                             interpolation=cv2.INTER_NEAREST)
+            cv2.imshow("MAX78000 live feed", bgr)
+            cv2.waitKey(1)
+            return
+        if self.pool is None:
+            self.write_live_png(img)
+        else:
+            self.pool.submit(self.write_live_png, img)
+    
+    def write_live_png(self, img):
+        """Replace live.png in one step so viewers never read half a PNG."""
+        with self.live_png_lock:
+            tmp_path = self.output_dir / "live.tmp.png"
+            img.save(tmp_path)
+            os.replace(tmp_path, self.output_dir / "live.png")
     
     def parse_result(self, lines):
         """Parse classification result from lines."""
@@ -101,20 +669,42 @@ class ImageCapture:
         if len(pixels) != width * height * 3:
             print(f"Warning: Expected {width*height*3} values, got {len(pixels)}")
             return None
-        
-        img = Image.new('RGB', (width, height))
-        pixel_data = []
-        
-        for i in range(0, len(pixels), 3):
-            r = pixels[i]
-            g = pixels[i + 1]
-            b = pixels[i + 2]
-            pixel_data.append((r, g, b))
-        
-        img.putdata(pixel_data)
-        return img
+        try:
+            return Image.frombytes('RGB', (width, height), bytes(pixels))
+        except ValueError:
+            print("Warning: PPM value out of range")
+            return None
+    
+    def save_ppm(self, lines, width, height, result):
+        """Parse an ASCII PPM capture and save it with its result."""
+        pixels = self.parse_ppm(lines, width, height)
+        if not pixels:
+            print("Error: No pixel data parsed")
+            return
+        img = self.create_image(pixels, width, height)
+        if img:
+            self.save_capture(img, result)
+    
+    def submit_frame(self, header, payload, result):
+        """Decode and save a frame on the worker pool (inline without one)."""
+        self.capture_count += 1
+        if self.pool is None:
+            self.save_frame(header, payload, result)
+        else:
+            self.pool.submit(self.save_frame, header, payload, result)
     
-    def save_capture(self, img, result):
+    def save_frame(self, header, payload, result):
+        """Decode a frame and save it with its result."""
+        try:
+            img = self.decode_frame(header, payload)
+            if img:
+                if 'capture_id' not in result:
+                    result['capture_id'] = header['capture_id']
+                self.save_capture(img, result)
+        except Exception as e:
+            print(f"Error saving capture {header['capture_id']}: {e}")
+    
+    def save_capture(self, img, result, prefix="capture"):
         """Save image and result to files."""
         timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
         capture_id = result.get('capture_id', self.capture_count)
@@ -122,32 +712,143 @@ class ImageCapture:
         confidence = result.get('confidence', 0)
         
         # Create filename
-        filename = f"capture_{capture_id:04d}_{class_name}_{confidence}pct_{timestamp}"
+        filename = f"{prefix}_{capture_id:04d}_{class_name}_{confidence}pct_{timestamp}"
         
         # Save image
         img_path = self.output_dir / f"{filename}.png"
         img.save(img_path)
-        print(f"Saved image: {img_path}")
         
-        # Save result as text
+        # Batched result row, or a text file per capture
+        if self.results is not None:
+            row = {
+                'port': self.port,
+                'capture_id': capture_id,
+                'class': class_name,
+                'confidence': confidence,
+                'inference_time_us': result.get('inference_time_us', 0),
+                'image': str(img_path),
+                'timestamp': timestamp,
+            }
+            for key in ('boot', 'softmax'):
+                if key in result:
+                    row[key] = result[key]
+            self.results.add(row)
+            print(f"Saved image: {img_path}")
+            return img_path
+        
+        print(f"Saved image: {img_path}")
         txt_path = self.output_dir / f"{filename}.txt"
         with open(txt_path, 'w') as f:
             f.write(f"Capture ID: {capture_id}\n")
             f.write(f"Class: {class_name}\n")
             f.write(f"Confidence: {confidence}%\n")
             f.write(f"Inference Time: {result.get('inference_time_us', 0)} us\n")
+            if 'boot' in result:
+                f.write(f"Boot: {result['boot']}\n")
+            if 'softmax' in result:
+                f.write(f"Softmax (Q15): {' '.join(str(v) for v in result['softmax'])}\n")
             f.write(f"Timestamp: {timestamp}\n")
         print(f"Saved result: {txt_path}")
         
         return img_path
     
+    def read_log_dump(self):
+        """Read an offloaded capture log after the <<<LOG>>> marker.
+        
+        The device announces the dump rate and switches to it; the port
+        follows and returns to the normal rate once the dump is in.
+        
+        Returns the dump bytes or None on timeout.
+        """
+        dump_baud = self.baud
+        for _ in range(2):
+            line = self.read_line() or ""
+            if line.startswith("BAUD:"):
+                dump_baud = int(line.split(":")[1])
+        
+        self.serial.baudrate = dump_baud
+        try:
+            header = self.read_exact(DUMP_HEADER.size)
+            if header is None:
+                print("Error: Timeout reading log dump header")
+                return None
+            _magic, _version, pages, page_size = DUMP_HEADER.unpack(header)
+            print(f"[Receiving capture log: {pages} pages at {dump_baud} baud]")
+            rest = self.read_exact(pages * page_size + 4)
+            if rest is None:
+                print("Error: Timeout reading log dump")
+                return None
+            return header + rest
+        finally:
+            self.serial.baudrate = self.baud
+    
+    def save_log(self, dump, class_names):
+        """Decode an offloaded capture log and save every record."""
+        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        dump_path = self.output_dir / f"capture_log_{timestamp}.bin"
+        dump_path.write_bytes(dump)
+        print(f"Saved raw log: {dump_path}")
+        
+        try:
+            records, warnings = parse_log_dump(dump)
+        except ValueError as e:
+            print(f"Error: {e}")
+            return False
+        for w in warnings:
+            print(f"Warning: {w}")
+        
+        for record in records:
+            img = self.decode_frame(record, record['payload'])
+            if img is None:
+                continue
+            predicted = record['predicted']
+            result = dict(record)
+            result['class'] = (class_names[predicted] if predicted < len(class_names)
+                               else f"class{predicted}")
+            self.capture_count += 1
+            self.save_capture(img, result, prefix=f"log_b{record['boot']:03d}")
+        print(f"\n{len(records)} logged captures decoded")
+        return not warnings
+    
+    def offload(self, class_names, erase=False):
+        """Ask the device for its capture log and save it."""
+        if not self.connect():
+            return
+        
+        try:
+            self.serial.reset_input_buffer()
+            self.reader.discard()
+            self.serial.write(LOG_CMD_OFFLOAD)
+            print("Requested capture log (device must be at the mode select prompt)")
+            for _ in range(30):
+                line = self.read_line()
+                if line == "<<<LOG>>>":
+                    break
+            else:
+                print("Error: No capture log received")
+                return
+            
+            dump = self.read_log_dump()
+            if dump is None:
+                return
+            if self.save_log(dump, class_names) and erase:
+                self.serial.write(LOG_CMD_ERASE)
+                print("Erased the capture log on the device")
+        
+        except KeyboardInterrupt:
+            print("\n\nOffload stopped by user")
+        
+        finally:
+            self.disconnect()
+            print(f"Output directory: {self.output_dir.absolute()}")
+    
     def run(self):
-        """Main capture loop."""
+        """Main capture loop, until Ctrl+C or stop()."""
         if not self.connect():
             return
         
         print("\n" + "="*50)
-        print("MAX78000 Image Capture")
+        print(f"MAX78000 Image Capture ({self.port})")
         print("="*50)
         print("Waiting for captures from device...")
         print("Press Ctrl+C to exit\n")
@@ -159,9 +860,12 @@ class ImageCapture:
         height = 128
         
         try:
-            while True:
+            while not self.stop_event.is_set():
                 line = self.read_line()
                 if not line:
+                    if not self.reader.running:
+                        print(f"Error: {self.port} stopped: {self.reader.error}")
+                        break
                     continue
                 
                 # Check for result marker
@@ -177,6 +881,24 @@ class ImageCapture:
                     print(f"\n[Result] Class: {current_result.get('class', '?')} "
                           f"({current_result.get('confidence', 0)}%)")
                 
+                # Binary frame: header and payload follow the marker
+                elif line == "<<<FRAME>>>":
+                    frame = self.read_frame()
+                    if frame and frame[0]['flags'] & FRAME_FLAG_LIVE:
+                        self.receive_live(frame[0], frame[1], current_result)
+                    elif frame:
+                        header, payload = frame
+                        print(f"[Received {header['width']}x{header['height']} frame, "
+                              f"{len(payload)} bytes]")
+                        self.submit_frame(header, payload, current_result)
+                    current_result = {}
+                
+                # Capture log dump, sent when a --offload run asked for it
+                elif line == "<<<LOG>>>":
+                    dump = self.read_log_dump()
+                    if dump:
+                        self.save_log(dump, self.class_names)
+                
                 # Check for image start
                 elif "<<<IMG_START>>>" in line:
                     image_lines = []
@@ -200,15 +922,12 @@ class ImageCapture:
                     # Process the captured image
                     if image_lines:
                         print(f"[Parsing {width}x{height} image...]")
-                        pixels = self.parse_ppm(image_lines, width, height)
-                        
-                        if pixels:
-                            img = self.create_image(pixels, width, height)
-                            if img:
-                                self.capture_count += 1
-                                self.save_capture(img, current_result)
+                        self.capture_count += 1
+                        if self.pool is None:
+                            self.save_ppm(image_lines, width, height, current_result)
                         else:
-                            print("Error: No pixel data parsed")
+                            self.pool.submit(self.save_ppm, image_lines, width, height,
+                                             current_result)
                     
                     image_lines = []
                     current_result = {}
@@ -226,20 +945,90 @@ class ImageCapture:
         
         finally:
             self.disconnect()
-            print(f"\nTotal captures saved: {self.capture_count}")
+            if cv2 is not None and self.preview_window and self.live_frame is not None:
+                cv2.destroyAllWindows()
+            print(f"\nTotal captures received: {self.capture_count}")
             print(f"Output directory: {self.output_dir.absolute()}")
 
 
 def main():
     parser = argparse.ArgumentParser(description="Capture images from MAX78000")
-    parser.add_argument("--port", "-p", required=True, help="Serial port (e.g., COM3, /dev/ttyUSB0)")
+    parser.add_argument("--port", "-p", nargs="+",
+                        help="Serial port(s) (e.g., COM3, /dev/ttyUSB0); several ports "
+                             "are received in parallel, each into its own subdirectory")
     parser.add_argument("--baud", "-b", type=int, default=115200, help="Baud rate (default: 115200)")
     parser.add_argument("--output", "-o", default="captures", help="Output directory (default: captures)")
+    parser.add_argument("--offload", action="store_true",
+                        help="Download the device's capture log instead of live captures")
+    parser.add_argument("--erase", action="store_true",
+                        help="With --offload, erase the log once it is saved")
+    parser.add_argument("--from-dump", metavar="FILE",
+                        help="Decode a saved capture log dump (no device needed)")
+    parser.add_argument("--classes", default="Horse,Human",
+                        help="Class names of logged results (default: Horse,Human)")
+    parser.add_argument("--save-live", action="store_true",
+                        help="Save every rebuilt live feed frame, not only the preview")
+    parser.add_argument("--workers", type=int, default=4,
+                        help="Threads decoding and saving captures (0 = save inline, default: 4)")
+    parser.add_argument("--results", choices=["txt", "csv", "jsonl"], default="txt",
+                        help="Results as a .txt per capture, or batched into "
+                             "results.csv / results.jsonl (default: txt)")
     
     args = parser.parse_args()
+    class_names = args.classes.split(",")
+    
+    if args.from_dump:
+        capturer = ImageCapture(None, args.baud, args.output)
+        capturer.class_names = class_names
+        capturer.save_log(Path(args.from_dump).read_bytes(), class_names)
+        return
+    if not args.port:
+        parser.error("--port is required")
+    if args.offload:
+        capturer = ImageCapture(args.port[0], args.baud, args.output)
+        capturer.class_names = class_names
+        capturer.offload(class_names, erase=args.erase)
+        return
+    
+    results = None
+    if args.results != "txt":
+        Path(args.output).mkdir(parents=True, exist_ok=True)
+        results = ResultLog(Path(args.output) / f"results.{args.results}", args.results)
+    pool = ThreadPoolExecutor(max_workers=args.workers) if args.workers > 0 else None
+    
+    capturers = []
+    for port in args.port:
+        output = args.output if len(args.port) == 1 else Path(args.output) / Path(port).name
+        capturer = ImageCapture(port, args.baud, output, pool=pool, results=results)
+        capturer.class_names = class_names
+        capturer.save_live = args.save_live
+        # OpenCV windows are only safe from the main thread
+        capturer.preview_window = len(args.port) == 1
+        capturers.append(capturer)
     
-    capturer = ImageCapture(args.port, args.baud, args.output)
-    capturer.run()
+    try:
+        if len(capturers) == 1:
+            capturers[0].run()
+        else:
+            threads = [threading.Thread(target=c.run) for c in capturers]
+            for t in threads:
+                t.start()
+            try:
+                while any(t.is_alive() for t in threads):
+                    for t in threads:
+                        t.join(0.5)
+            except KeyboardInterrupt:
+                print("\n\nCapture stopped by user")
+                for c in capturers:
+                    c.stop()
+                for t in threads:
+                    t.join()
+    finally:
+        if pool is not None:
+            print("Waiting for pending saves...")
+            pool.shutdown(wait=True)
+        if results is not None:
+            results.close()
 
 
 if __name__ == "__main__":
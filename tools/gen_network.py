@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+"""
+CNN Network Table Generator
+
+Turns the register stores of the generated cnn_init() / cnn_configure()
+(cnn.c), the bias loads of cnn_load_bias() and the layer summary of cnn.h into
+network.h: a layer descriptor table and packed register and bias tables,
+written out by cnn_network.c.
+
+Run it again whenever ai8xize.py regenerates cnn.c.
+
+A second network kept resident next to this one needs its own prefix, its
+kernels embedded (its weights.h defines the same KERNELS/BIAS_n names) and
+kernel/bias memory that does not overlap the first network's:
+
+Usage:
+    python gen_network.py
+    python gen_network.py --cnn-c ../cnn.c --cnn-h ../cnn.h --out ../network.h
+    python gen_network.py --cnn-c det/cnn.c --cnn-h det/cnn.h --weights det/weights.h \\
+        --prefix DETECTOR --embed-kernels --exclude-weights weights.h --out detector.h
+"""
+
+import argparse
+import re
+import sys
+from pathlib import Path
+
+
+# CNN quadrant register blocks (see cnn_network.h)
+QUADRANT_BASE = 0x50100000
+QUADRANT_STRIDE = 0x00400000
+QUADRANT_SPAN = 0x00010000
+FIFO_CTRL_ADDR = 0x50000000
+
+OP_NAMES = {"conv2d": "CNN_OP_CONV2D", "conv1d": "CNN_OP_CONV1D",
+            "linear": "CNN_OP_LINEAR", "passthrough": "CNN_OP_PASSTHROUGH"}
+
+STORE_RE = re.compile(r"^\s*\*\(\(volatile uint32_t \*\) (0x[0-9a-fA-F]+)\) = (0x[0-9a-fA-F]+);")
+LAYER_RE = re.compile(r"^// Layer (\d+): (.*)$")
+OPS_RE = re.compile(r"Layer (\d+): ([\d,]+) ops \(([\d,]+) macc")
+SHAPE_RE = re.compile(r"(\d+)x(\d+)x(\d+)")
+POOL_RE = re.compile(r"(max|avg) pool (\d+)x\d+ with stride (\d+)/")
+KERNEL_RE = re.compile(r"kernel size (\d+)")
+UNLOAD_RE = re.compile(r"addr = \(volatile uint32_t \*\) (0x[0-9a-fA-F]+);")
+BIAS_LOAD_RE = re.compile(r"memcpy_8to32\(\(uint32_t \*\) (0x[0-9a-fA-F]+), (\w+), "
+                          r"sizeof\(uint8_t\) \* (\d+)\);")
+BIAS_DECL_RE = re.compile(r"static const uint8_t (\w+)\[\] = (\w+);")
+MACRO_RE = r"#define %s \{ \\\n(.*?)\n\}"
+
+
+def function_body(text, name):
+    start = text.index("int %s(" % name)
+    end = text.index("\n}\n", start)
+    return text[start:end].splitlines()
+
+
+def parse_layers(cnn_c, cnn_h):
+    layers = []
+    for line in cnn_c.splitlines():
+        m = LAYER_RE.match(line)
+        if not m:
+            continue
+        desc = m.group(2)
+        shapes = SHAPE_RE.findall(desc)
+        pool = POOL_RE.search(desc)
+        kernel = KERNEL_RE.search(desc)
+        op = next((k for k in OP_NAMES if (" %s" % k) in desc), "passthrough")
+        layers.append({
+            "index": int(m.group(1)),
+            "in": tuple(int(v) for v in shapes[0]),
+            "out": tuple(int(v) for v in shapes[-1]),
+            "op": OP_NAMES[op],
+            "pool": ("CNN_POOL_MAX" if pool.group(1) == "max" else "CNN_POOL_AVG")
+                    if pool else "CNN_POOL_NONE",
+            "pool_size": int(pool.group(2)) if pool else 1,
+            "kernel": int(kernel.group(1)) if kernel else 1,
+            "relu": 1 if "ReLU" in desc else 0,
+            "streaming": 1 if "streaming" in desc.split(",")[0] else 0,
+            "ops": 0,
+            "macs": 0,
+            "regs": [],
+        })
+
+    for m in OPS_RE.finditer(cnn_h):
+        idx = int(m.group(1))
+        layers[idx]["ops"] = int(m.group(2).replace(",", ""))
+        layers[idx]["macs"] = int(m.group(3).replace(",", ""))
+
+    return layers
+
+
+def encode_addr(addr):
+    """Quadrant in bits 15:14, word offset in bits 13:0."""
+    quadrant = (addr - QUADRANT_BASE) // QUADRANT_STRIDE
+    offset = addr - QUADRANT_BASE - quadrant * QUADRANT_STRIDE
+    if addr < QUADRANT_BASE or quadrant > 3 or offset >= QUADRANT_SPAN or offset & 3:
+        raise ValueError("register 0x%08x outside the quadrant blocks" % addr)
+    return (quadrant << 14) | (offset >> 2)
+
+
+def decode_addr(code):
+    return QUADRANT_BASE + (code >> 14) * QUADRANT_STRIDE + ((code & 0x3FFF) << 2)
+
+
+def parse_configure(cnn_c, layers):
+    """Register stores per layer, in generated order, plus the FIFO control."""
+    fifo_ctrl = None
+    stores = []
+    layer = None
+
+    for line in function_body(cnn_c, "cnn_configure"):
+        m = re.match(r"^\s*// Layer (\d+) quadrant", line)
+        if m:
+            layer = int(m.group(1))
+            continue
+        m = STORE_RE.match(line)
+        if not m:
+            if "=" in line and "*((volatile" in line:
+                raise ValueError("unsupported store: %s" % line.strip())
+            continue
+        addr, value = int(m.group(1), 16), int(m.group(2), 16)
+        if addr == FIFO_CTRL_ADDR:
+            fifo_ctrl = value
+            continue
+        if layer is None:
+            raise ValueError("store outside a layer: %s" % line.strip())
+        layers[layer]["regs"].append((encode_addr(addr), value))
+        stores.append((addr, value))
+
+    if fifo_ctrl is None:
+        raise ValueError("no FIFO control store found")
+    return stores, fifo_ctrl
+
+
+def parse_init(cnn_c):
+    """All cnn_init() stores, as full addresses (some are outside the quadrants)."""
+    stores = []
+    for line in function_body(cnn_c, "cnn_init"):
+        m = STORE_RE.match(line)
+        if m:
+            stores.append((int(m.group(1), 16), int(m.group(2), 16)))
+    if not stores:
+        raise ValueError("cnn_init() not recognized")
+    return stores
+
+
+def macro_values(weights_h, name):
+    m = re.search(MACRO_RE % name, weights_h, re.S)
+    if not m:
+        raise ValueError("%s not found in weights file" % name)
+    return [int(v, 16) for v in re.findall(r"0x[0-9a-fA-F]+", m.group(1))]
+
+
+def parse_bias(cnn_c, weights_h):
+    """cnn_load_bias() copies as {address, count, values} records."""
+    arrays = dict(BIAS_DECL_RE.findall(cnn_c))
+    records = []
+    for line in function_body(cnn_c, "cnn_load_bias"):
+        m = BIAS_LOAD_RE.search(line)
+        if m:
+            values = macro_values(weights_h, arrays[m.group(2)])
+            if len(values) != int(m.group(3)):
+                raise ValueError("%s size mismatch" % m.group(2))
+            records.append((int(m.group(1), 16), values))
+    return records
+
+
+def kernel_records(kernels):
+    """(address, words) of each {address, count, words...} record."""
+    records = []
+    i = 0
+    while kernels[i] != 0:
+        records.append((kernels[i], kernels[i + 1]))
+        i += 2 + kernels[i + 1]
+    return records
+
+
+def check_overlap(kernels, bias, other_weights, other_cnn_c):
+    """Kernel and bias memory must be disjoint from a network kept resident."""
+    ours = [(a, a + 4 * n) for a, n in kernel_records(kernels)]
+    ours += [(a, a + 4 * len(v)) for a, v in bias]
+    theirs = [(a, a + 4 * n) for a, n in kernel_records(macro_values(other_weights, "KERNELS"))]
+    if other_cnn_c is not None:
+        theirs += [(a, a + 4 * len(v)) for a, v in parse_bias(other_cnn_c, other_weights)]
+    for lo, hi in ours:
+        for olo, ohi in theirs:
+            if lo < ohi and olo < hi:
+                raise ValueError("memory 0x%08x-0x%08x overlaps a resident network" % (lo, hi))
+
+
+def parse_unload(cnn_c):
+    body = function_body(cnn_c, "cnn_unload")
+    addr = None
+    words = 0
+    for line in body:
+        m = UNLOAD_RE.search(line)
+        if m:
+            if addr is not None:
+                raise ValueError("cnn_unload() reads more than one block")
+            addr = int(m.group(1), 16)
+        words += line.count("*out_buf++ = *addr++;")
+    if addr is None or words == 0:
+        raise ValueError("cnn_unload() not recognized")
+    return addr, words
+
+
+def emit(filename, prefix, name, layers, init, fifo_ctrl, out_addr, out_words, bias, kernels):
+    lines = []
+    w = lines.append
+    regs = [r for layer in layers for r in layer["regs"]]
+    guard = "%s_H_" % prefix
+
+    w("/**")
+    w(" * @file    %s" % filename)
+    w(" * @brief   Register tables for %s, @generated by tools/gen_network.py" % name)
+    w(" *          from cnn.c and cnn.h.")
+    w(" *")
+    w(" * DO NOT EDIT - regenerate this file instead!")
+    w(" */")
+    w("")
+    w("#ifndef %s" % guard)
+    w("#define %s" % guard)
+    w("")
+    w('#define %s_NAME "%s"' % (prefix, name))
+    w("#define %s_NUM_LAYERS %d" % (prefix, len(layers)))
+    w("#define %s_NUM_REGS %d" % (prefix, len(regs)))
+    w("#define %s_NUM_INIT %d" % (prefix, len(init)))
+    w("#define %s_FIFO_CTRL 0x%08x" % (prefix, fifo_ctrl))
+    w("#define %s_OUTPUT_ADDR 0x%08x" % (prefix, out_addr))
+    w("#define %s_OUTPUT_WORDS %d" % (prefix, out_words))
+    w("")
+    w("/* in c/h/w, out c/h/w, op, pool, pool size, kernel, ReLU, streaming,")
+    w(" * first register, register count, ops, MACs */")
+    w("#define %s_LAYERS { \\" % prefix)
+    first = 0
+    for layer in layers:
+        w("    { %d, %d, %d, %d, %d, %d, %s, %s, %d, %d, %d, %d, %d, %d, %dU, %dU }, \\" % (
+            layer["in"] + layer["out"] + (layer["op"], layer["pool"], layer["pool_size"],
+                                          layer["kernel"], layer["relu"], layer["streaming"],
+                                          first, len(layer["regs"]), layer["ops"],
+                                          layer["macs"])))
+        first += len(layer["regs"])
+    w("}")
+    w("")
+    w("/* (quadrant << 14) | (register offset >> 2) */")
+    w("#define %s_REG_ADDR { \\" % prefix)
+    for i in range(0, len(regs), 8):
+        w("    " + " ".join("0x%04x," % a for a, _ in regs[i:i + 8]) + " \\")
+    w("}")
+    w("")
+    w("#define %s_REG_VALUE { \\" % prefix)
+    for i in range(0, len(regs), 6):
+        w("    " + " ".join("0x%08x," % v for _, v in regs[i:i + 6]) + " \\")
+    w("}")
+    w("")
+    w("/* cnn_init(): address, value */")
+    w("#define %s_INIT { \\" % prefix)
+    for addr, value in init:
+        w("    0x%08x, 0x%08x, \\" % (addr, value))
+    w("}")
+    w("")
+    w("/* cnn_load_bias(): {address, count, bytes...} records, zero terminated */")
+    w("#define %s_BIAS { \\" % prefix)
+    for addr, values in bias:
+        w("    0x%08x, %d, \\" % (addr, len(values)))
+        for i in range(0, len(values), 12):
+            w("    " + " ".join("0x%02x," % v for v in values[i:i + 12]) + " \\")
+    w("    0 \\")
+    w("}")
+    w("")
+    if kernels is not None:
+        w("/* Kernels in cnn_load_weights() record format */")
+        w("#define %s_KERNELS { \\" % prefix)
+        for i in range(0, len(kernels), 8):
+            w("    " + " ".join("0x%08x," % v for v in kernels[i:i + 8]) + " \\")
+        w("}")
+        w("")
+    w("#endif /* %s */" % guard)
+    w("")
+    return "\n".join(lines)
+
+
+def main():
+    here = Path(__file__).resolve().parent.parent
+    parser = argparse.ArgumentParser(description="Generate CNN register tables from cnn.c")
+    parser.add_argument("--cnn-c", type=Path, default=here / "cnn.c")
+    parser.add_argument("--cnn-h", type=Path, default=here / "cnn.h")
+    parser.add_argument("--out", type=Path, default=here / "network.h")
+    parser.add_argument("--weights", type=Path, default=here / "weights.h")
+    parser.add_argument("--prefix", default="NETWORK", help="Macro prefix")
+    parser.add_argument("--embed-kernels", action="store_true",
+                        help="Copy the kernels into the output (networks other than cnn.c's)")
+    parser.add_argument("--exclude-weights", type=Path, action="append", default=[],
+                        help="weights.h of a resident network that must not overlap "
+                             "(its cnn.c is read from the same directory for the bias)")
+    args = parser.parse_args()
+
+    cnn_c = args.cnn_c.read_text()
+    cnn_h = args.cnn_h.read_text()
+    weights_h = args.weights.read_text()
+
+    m = re.search(r"^// (\S+)\n// This file was @generated", cnn_c, re.M)
+    name = m.group(1) if m else args.cnn_c.stem
+
+    try:
+        layers = parse_layers(cnn_c, cnn_h)
+        stores, fifo_ctrl = parse_configure(cnn_c, layers)
+        out_addr, out_words = parse_unload(cnn_c)
+        init = parse_init(cnn_c)
+        bias = parse_bias(cnn_c, weights_h)
+        kernels = macro_values(weights_h, "KERNELS")
+        for other in args.exclude_weights:
+            other_cnn_c = other.parent / "cnn.c"
+            check_overlap(kernels, bias, other.read_text(),
+                          other_cnn_c.read_text() if other_cnn_c.exists() else None)
+    except ValueError as err:
+        print("Error: %s" % err)
+        return 1
+
+    # The table must replay cnn_configure() store for store
+    replay = [(decode_addr(a), v) for layer in layers for a, v in layer["regs"]]
+    if replay != stores:
+        print("Error: register table does not replay cnn_configure()")
+        return 1
+
+    args.out.write_text(emit(args.out.name, args.prefix, name, layers, init, fifo_ctrl,
+                             out_addr, out_words, bias, kernels if args.embed_kernels else None))
+    print("%s: %d layers, %d registers" % (args.out, len(layers), len(stores)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())